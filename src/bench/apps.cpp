@@ -0,0 +1,90 @@
+/**
+ * Aplicações de hosts como corrotinas (sim::Task), todas no laço de eventos da simulação:
+ *
+ *   N hosts - S (um switch com N portas)
+ *
+ * Os hosts formam pares; em cada par, um manda um frame, espera a resposta (co_await receive) e espera um pouco
+ * (co_await sim::sleep) antes da próxima rodada. Nenhuma thread é criada: o custo é o quadro de cada corrotina.
+ */
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "peers.hpp"
+#include "sim.hpp"
+#include "task.hpp"
+
+using P = error_control::Crc;
+
+static const char PAYLOAD[] = "ping";
+
+//Lado que começa: manda, espera a resposta e descansa (o intervalo varia com o par, para espalhar os eventos)
+static sim::Task pinger(Ref<Host> self, MAC peer, unsigned rounds, sim::Time think)
+{
+    for (unsigned r = 0; r < rounds; r++)
+    {
+        Ether2Frame frame(peer, self->m_MAC, PAYLOAD, sizeof(PAYLOAD), P{});
+        self->sendFrameT<P>(0, frame);
+        co_await self->receive();
+        co_await sim::sleep(think);
+    }
+}
+
+//Lado que responde a cada frame recebido
+static sim::Task ponger(Ref<Host> self, MAC peer, unsigned rounds)
+{
+    for (unsigned r = 0; r < rounds; r++)
+    {
+        co_await self->receive();
+        Ether2Frame frame(peer, self->m_MAC, PAYLOAD, sizeof(PAYLOAD), P{});
+        self->sendFrameT<P>(0, frame);
+    }
+}
+
+static void runApps(unsigned hosts, unsigned rounds)
+{
+    Ref<Switch> S = std::make_shared<Switch>(P::kind, hosts, 2 * hosts);
+    std::vector<Ref<Host>> H;
+    for (unsigned i = 0; i < hosts; i++)
+    {
+        H.push_back(std::make_shared<Host>(MAC(0x020000000000ull + i), P::kind));
+        EthernetPeer::connect(H[i], S, 0, i, 0);
+    }
+    sim::reset();
+
+    //Warm up: every host sends a frame to itself, so the switch learns it without flooding
+    for (Ref<Host> &host : H)
+    {
+        Ether2Frame frame(host->m_MAC, host->m_MAC, PAYLOAD, sizeof(PAYLOAD), P{});
+        host->sendFrameT<P>(0, frame);
+    }
+
+    for (unsigned i = 0; i + 1 < hosts; i += 2)
+    {
+        sim::spawn(pinger(H[i], H[i + 1]->m_MAC, rounds, (1 + i % 16) * sim::MICROSECOND));
+        sim::spawn(ponger(H[i + 1], H[i]->m_MAC, rounds));
+    }
+    size_t spawned = sim::liveTasks();
+
+    sim::Time start = sim::now();
+    bench::Timer timer;
+    size_t events = sim::run();
+    double seconds = timer.seconds();
+
+    uint64_t frames = (uint64_t)(hosts / 2) * rounds * 2;
+    bench::report(std::to_string(hosts) + " host applications", frames, seconds, "frames");
+    std::cout << "    " << spawned << " tasks, " << events << " events, " << sim::liveTasks() << " still waiting, "
+              << std::fixed << std::setprecision(3) << (double)(sim::now() - start) / sim::MILLISECOND << " ms simulated"
+              << std::defaultfloat << std::endl;
+}
+
+void bench::apps()
+{
+    unsigned rounds = (unsigned)bench::iterations(64);
+    for (unsigned hosts : {64u, 1024u, 8192u})
+        runApps(hosts, rounds);
+    sim::reset();
+}
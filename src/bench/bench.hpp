@@ -0,0 +1,59 @@
+/**
+ * Header criado para os benchmarks da simulação (binário bin/bench)
+ *
+ * Cada benchmark é uma função registrada em main.cpp pelo nome; todos rodam com o log da simulação desligado.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace bench
+{
+    //Cronômetro de parede simples
+    class Timer
+    {
+    private:
+        std::chrono::steady_clock::time_point m_Start = std::chrono::steady_clock::now();
+
+    public:
+        double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count(); }
+    };
+
+    /**
+     * Imprime uma linha de resultado: nome, quantidade de operações e taxa
+     *
+     * Parâmetros:	const std::string &name	=>	Nome da medida
+     * 				uint64_t ops			=>	Quantidade de operações
+     * 				double seconds			=>	Tempo gasto
+     * 				const char *unit		=>	Unidade das operações (ex.: "frames")
+     *
+     * Retorno: void
+     */
+    void report(const std::string &name, uint64_t ops, double seconds, const char *unit);
+
+    //Quantidade de repetições pedida na linha de comando (0 = padrão de cada benchmark)
+    uint64_t iterations(uint64_t fallback);
+
+    //Frames entre duas renovações das entradas aprendidas: o tempo simulado avança com cada frame e,
+    //sem tráfego de volta, o destino expiraria (TTL da tabela) no meio de uma medida longa.
+    //Numa cadeia de 16 switches cada frame avança ~0,2 ms, então 4096 frames ficam abaixo de 1 s
+    constexpr uint64_t TABLE_REFRESH = 4096;
+
+    //Benchmarks
+    void dispatch();
+    void checksums();
+    void multicast();
+    void vlan();
+    void flood();
+    void switching();
+    void queues();
+    void lag();
+    void burst();
+    void apps();
+    void shm();
+    void checkpoint();
+    void macTable();
+    void router();
+}
@@ -0,0 +1,118 @@
+/**
+ * Frames/s enviados frame a frame (sendFrame) e em rajadas (sendFrames), em duas topologias:
+ *
+ *   cadeia:  A - S1 - S2 - ... - Sn - B        (todos os frames saem pela mesma porta em cada salto)
+ *   estrela: A - S - {B1, B2, B3, B4}           (destinos alternados: a rajada é dividida por porta de saída)
+ *
+ * Enlaces sem ruído e tabelas grandes: depois do aquecimento todo frame é encaminhado pela tabela
+ * (renovada periodicamente por tráfego de volta, ver TABLE_REFRESH).
+ */
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "peers.hpp"
+#include "sim.hpp"
+
+//Envia 'count' frames do vetor (em ordem circular), frame a frame (burst = 0) ou em rajadas do tamanho pedido;
+//a cada TABLE_REFRESH frames, 'refresh' manda tráfego de volta para os destinos continuarem aprendidos
+template <class Refresh>
+static double sendAll(Host &A, std::vector<Ether2Frame> &frames, uint64_t count, size_t burst, Refresh refresh)
+{
+    bench::Timer timer;
+    if (burst == 0)
+    {
+        for (uint64_t i = 0; i < count; i++)
+        {
+            A.sendFrame(0, frames[i % frames.size()]);
+            if (i % bench::TABLE_REFRESH == bench::TABLE_REFRESH - 1)
+                refresh();
+        }
+    }
+    else
+    {
+        for (uint64_t i = 0; i < count; i += burst)
+        {
+            A.sendFrames(0, std::span<Ether2Frame>(frames).first(burst));
+            if (i % bench::TABLE_REFRESH + burst >= bench::TABLE_REFRESH)
+                refresh();
+        }
+    }
+    return timer.seconds();
+}
+
+static std::string label(const std::string &topology, size_t burst)
+{
+    return topology + (burst ? ", bursts of " + std::to_string(burst) : ", frame by frame");
+}
+
+static void runChain(unsigned switches, uint64_t count)
+{
+    Ref<Host> A = std::make_shared<Host>(MAC("02:00:00:00:00:0A"), ERROR_CONTROL::CRC);
+    Ref<Host> B = std::make_shared<Host>(MAC("02:00:00:00:00:0B"), ERROR_CONTROL::CRC);
+
+    std::vector<Ref<Switch>> chain;
+    for (unsigned i = 0; i < switches; i++)
+        chain.push_back(std::make_shared<Switch>(ERROR_CONTROL::CRC, 2, 1024));
+
+    EthernetPeer::connect(A, chain.front(), 0, 0, 0);
+    for (unsigned i = 0; i + 1 < switches; i++)
+        EthernetPeer::connect(chain[i], chain[i + 1], 1, 0, 0);
+    EthernetPeer::connect(chain.back(), B, 1, 0, 0);
+    sim::reset();
+
+    //Warm up: both hosts get learned on every switch
+    const char payload[] = "benchmark frame";
+    Ether2Frame toA(A->m_MAC, B->m_MAC, payload, sizeof(payload), ERROR_CONTROL::CRC);
+    std::vector<Ether2Frame> frames(EthernetPeer::BURST_MAX, Ether2Frame(B->m_MAC, A->m_MAC, payload, sizeof(payload), ERROR_CONTROL::CRC));
+    A->sendFrame(0, frames[0]);
+    B->sendFrame(0, toA);
+
+    std::string topology = std::to_string(switches) + " switches";
+    auto refresh = [&]() { B->sendFrame(0, toA); };
+    for (size_t burst : {0, 8, 32, 64})
+        bench::report(label(topology, burst), count, sendAll(*A, frames, count, burst, refresh), "frames");
+}
+
+static void runStar(uint64_t count)
+{
+    Ref<Host> A = std::make_shared<Host>(MAC("02:00:00:00:00:0A"), ERROR_CONTROL::CRC);
+    Ref<Switch> S = std::make_shared<Switch>(ERROR_CONTROL::CRC, 5, 1024);
+    EthernetPeer::connect(A, S, 0, 0, 0);
+
+    std::vector<Ref<Host>> hosts;
+    for (unsigned i = 0; i < 4; i++)
+    {
+        hosts.push_back(std::make_shared<Host>(MAC(0x020000000100ull + i), ERROR_CONTROL::CRC));
+        EthernetPeer::connect(hosts.back(), S, 0, i + 1, 0);
+    }
+    sim::reset();
+
+    //Warm up: every host is learned; the frames of the burst cycle through the destinations
+    const char payload[] = "benchmark frame";
+    std::vector<Ether2Frame> frames;
+    for (unsigned i = 0; i < EthernetPeer::BURST_MAX; i++)
+        frames.emplace_back(hosts[i % hosts.size()]->m_MAC, A->m_MAC, payload, sizeof(payload), ERROR_CONTROL::CRC);
+    auto refresh = [&]() {
+        for (Ref<Host> &host : hosts)
+        {
+            Ether2Frame toA(A->m_MAC, host->m_MAC, payload, sizeof(payload), ERROR_CONTROL::CRC);
+            host->sendFrame(0, toA);
+        }
+    };
+    refresh();
+
+    for (size_t burst : {0, 8, 32, 64})
+        bench::report(label("star, 4 destinations", burst), count, sendAll(*A, frames, count, burst, refresh), "frames");
+}
+
+void bench::burst()
+{
+    EthernetPeer::setDispatchMode(DispatchMode::Closed);
+    uint64_t count = bench::iterations(256'000);
+    for (unsigned switches : {1u, 4u, 16u})
+        runChain(switches, count);
+    runStar(count);
+}
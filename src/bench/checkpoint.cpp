@@ -0,0 +1,153 @@
+/**
+ * Checkpoint de uma rede aquecida (checkpoint::save/restore) comparado a simular o aquecimento de novo:
+ *
+ *   spine - LEAVES folhas - HOSTS hosts por folha, com filas de saída e ruído nos enlaces
+ *
+ * Cada host manda frames a hosts de outras folhas até o fim do aquecimento (os uplinks ficam sobrecarregados,
+ * então as filas estão cheias e há frames em trânsito). A rede original e a restaurada terminam de escoar
+ * esses frames: as duas precisam entregar os mesmos frames e terminar no mesmo instante simulado.
+ */
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "checkpoint.hpp"
+#include "egress_queue.hpp"
+#include "peers.hpp"
+#include "sim.hpp"
+#include "task.hpp"
+
+using P = error_control::Crc;
+
+static const unsigned LEAVES = 16, HOSTS = 32;
+static const sim::Time WARM_UP = 20 * sim::MILLISECOND;
+
+static MAC hostMac(unsigned i) { return MAC(0x020000000000ull + i); }
+
+//Manda um frame por vez a hosts de outras folhas (em rodízio), até 'until'
+static sim::Task talker(Ref<Host> host, unsigned self, sim::Time until)
+{
+    const char payload[] = "checkpoint frame";
+    sim::Time interval = 4 * sim::LinkTiming{}.serialization(Ether2Frame::WIRE_SIZE);
+    for (unsigned n = 1; sim::now() < until; n++)
+    {
+        unsigned dst = (self + n * HOSTS + n) % (LEAVES * HOSTS);
+        Ether2Frame frame(hostMac(dst), host->m_MAC, payload, sizeof(payload), P{});
+        host->sendFrameT<P>(0, frame);
+        co_await sim::sleep(interval);
+    }
+}
+
+struct Fabric
+{
+    std::vector<Ref<Switch>> switches;
+    std::vector<Ref<Host>> hosts;
+};
+
+static Fabric build()
+{
+    queueing::QueueConfig config;
+    config.capacity = 256;
+
+    Fabric f;
+    Ref<Switch> spine = std::make_shared<Switch>(P::kind, LEAVES, LEAVES * HOSTS);
+    spine->setEgressQueues(config);
+    f.switches.push_back(spine);
+    for (unsigned l = 0; l < LEAVES; l++)
+    {
+        Ref<Switch> leaf = std::make_shared<Switch>(P::kind, HOSTS + 1, LEAVES * HOSTS);
+        leaf->setEgressQueues(config);
+        EthernetPeer::connect(leaf, spine, HOSTS, l);
+        for (unsigned h = 0; h < HOSTS; h++)
+        {
+            f.hosts.push_back(std::make_shared<Host>(hostMac(l * HOSTS + h), P::kind));
+            EthernetPeer::connect(f.hosts.back(), leaf, 0, h);
+        }
+        f.switches.push_back(leaf);
+    }
+    return f;
+}
+
+template <class H>
+static uint64_t delivered(const std::vector<Ref<H>> &hosts)
+{
+    uint64_t frames = 0;
+    for (const Ref<H> &h : hosts)
+        frames += h->metrics().snapshot().ports[0].rxFrames;
+    return frames;
+}
+
+void bench::checkpoint()
+{
+    const std::string path = "/tmp/nls-bench.ckpt";
+    noise::setSeed(7);
+
+    uint64_t drainedOriginal = 0, drainedRestored = 0;
+    sim::Time endOriginal = 0, endRestored = 0;
+    double warmUp = 0;
+    {
+        Fabric f = build();
+        sim::reset();
+
+        //Warm-up: every host is learned everywhere (broadcast), then the fabric runs loaded
+        bench::Timer timer;
+        const char hello[] = "hello";
+        for (Ref<Host> &h : f.hosts)
+        {
+            Ether2Frame frame(MAC(MAC::BROADCAST), h->m_MAC, hello, sizeof(hello), P{});
+            h->sendFrameT<P>(0, frame);
+        }
+        for (unsigned i = 0; i < f.hosts.size(); i++)
+            sim::spawn(talker(f.hosts[i], i, WARM_UP), sim::MILLISECOND);
+        size_t events = sim::run(WARM_UP);
+        warmUp = timer.seconds();
+
+        size_t queued = 0;
+        for (Ref<Switch> &s : f.switches)
+            for (uint16_t port = 0; port < s->metrics().snapshot().ports.size(); port++)
+                queued += s->egressQueue(port)->size();
+        size_t inFlight = EthernetPeer::framesInFlight().size();
+        bench::report("warm-up (simulated)", events, warmUp, "events");
+
+        timer = bench::Timer();
+        size_t bytes = ::checkpoint::save(path);
+        double saving = timer.seconds();
+        bench::report("save", f.hosts.size() + f.switches.size(), saving, "peers");
+        std::cout << "    " << bytes / 1024 << " KiB, " << queued << " frames queued, " << inFlight << " in flight" << std::endl;
+
+        uint64_t before = delivered(f.hosts);
+        sim::run();
+        drainedOriginal = delivered(f.hosts) - before;
+        endOriginal = sim::now();
+    }
+
+    //Each point of a sweep starts here
+    double restoring = 0;
+    const unsigned ROUNDS = (unsigned)bench::iterations(5);
+    for (unsigned r = 0; r < ROUNDS; r++)
+    {
+        bench::Timer timer;
+        ::checkpoint::Fabric f = ::checkpoint::restore(path);
+        restoring += timer.seconds();
+
+        std::vector<Ref<Host>> hosts;
+        for (size_t i = 0; i < f.peers.size(); i++)
+            if (Ref<Host> h = f.get<Host>(i))
+                hosts.push_back(h);
+        sim::run();
+        drainedRestored = delivered(hosts);
+        endRestored = sim::now();
+    }
+    bench::report("restore", ROUNDS, restoring, "restores");
+    std::cout << "    " << restoring / ROUNDS * 1000 << " ms per restore, " << warmUp / (restoring / ROUNDS) << "x faster than the warm-up"
+              << std::endl;
+    std::cout << "    drained after the checkpoint: original " << drainedOriginal << " frames (t = " << endOriginal << " ns), restored "
+              << drainedRestored << " frames (t = " << endRestored << " ns)"
+              << (drainedOriginal == drainedRestored && endOriginal == endRestored ? "" : "  MISMATCH") << std::endl;
+
+    std::remove(path.c_str());
+    sim::reset();
+}
@@ -0,0 +1,63 @@
+/**
+ * Vazão (bytes/s) de cada método de checagem sobre payloads de frames, um por vez (compute)
+ * e em lotes de VERIFY_BATCH_MAX (computeMany)
+ */
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "crc_32.hpp"
+#include "error_control.hpp"
+#include "frame.hpp"
+#include "rng.hpp"
+
+//Working set of payloads: larger than L1 so the loads are not free, small enough to stay in L2
+static constexpr size_t PAYLOADS = 128;
+
+//Keeps the results alive so the compiler cannot drop the computation
+static volatile uint32_t __sink;
+
+template <error_control::Policy P>
+static void measure(const std::vector<uint8_t> &slab, uint64_t rounds)
+{
+    const uint8_t *payloads[PAYLOADS];
+    for (size_t i = 0; i < PAYLOADS; i++)
+        payloads[i] = &slab[i * Ether2Frame::PAYLOAD_SIZE];
+
+    uint64_t bytes = rounds * PAYLOADS * Ether2Frame::PAYLOAD_SIZE;
+    uint32_t acc = 0;
+
+    bench::Timer single;
+    for (uint64_t r = 0; r < rounds; r++)
+        for (size_t i = 0; i < PAYLOADS; i++)
+            acc ^= P::compute(payloads[i], Ether2Frame::PAYLOAD_SIZE);
+    bench::report(std::string(P::name) + ", one at a time", bytes, single.seconds(), "B");
+
+    uint32_t out[VERIFY_BATCH_MAX];
+    bench::Timer batch;
+    for (uint64_t r = 0; r < rounds; r++)
+        for (size_t i = 0; i < PAYLOADS; i += VERIFY_BATCH_MAX)
+        {
+            P::computeMany(payloads + i, VERIFY_BATCH_MAX, Ether2Frame::PAYLOAD_SIZE, out);
+            acc ^= out[0] ^ out[VERIFY_BATCH_MAX - 1];
+        }
+    bench::report(std::string(P::name) + ", batches of " + std::to_string(VERIFY_BATCH_MAX), bytes, batch.seconds(), "B");
+
+    __sink = acc;
+}
+
+void bench::checksums()
+{
+    std::vector<uint8_t> slab(PAYLOADS * Ether2Frame::PAYLOAD_SIZE);
+    rng::Xoshiro256 gen(1);
+    for (uint8_t &b : slab)
+        b = (uint8_t)gen.next();
+
+    std::cout << "  (CRC-32 uses " << (CRC32Hardware() ? "PCLMULQDQ folding" : "slicing-by-8 tables") << ")" << std::endl;
+    std::cout << "  (CRC-32C uses " << (CRC32CHardware() ? "the SSE4.2 crc32 instruction" : "slicing-by-8 tables") << ")" << std::endl;
+
+    uint64_t rounds = bench::iterations(2'000);
+#define MEASURE(P) measure<error_control::P>(slab, rounds);
+    ERROR_CONTROL_POLICIES(MEASURE)
+#undef MEASURE
+}
@@ -0,0 +1,62 @@
+/**
+ * Frames/s por uma cadeia de switches, com despacho virtual e com despacho fechado (Host/Switch)
+ *
+ *   A - S1 - S2 - ... - Sn - B
+ *
+ * Enlaces sem ruído e tabelas grandes: depois do aquecimento todo frame é encaminhado pela tabela em cada salto.
+ */
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "peers.hpp"
+#include "sim.hpp"
+
+static void runChain(unsigned switches, DispatchMode mode, uint64_t frames)
+{
+    Ref<Host> A = std::make_shared<Host>(MAC("02:AA:AA:AA:AA:AA"), ERROR_CONTROL::CRC);
+    Ref<Host> B = std::make_shared<Host>(MAC("02:BB:BB:BB:BB:BB"), ERROR_CONTROL::CRC);
+
+    std::vector<Ref<Switch>> chain;
+    for (unsigned i = 0; i < switches; i++)
+        chain.push_back(std::make_shared<Switch>(ERROR_CONTROL::CRC, 2, 1024));
+
+    EthernetPeer::connect(A, chain.front(), 0, 0, 0);
+    for (unsigned i = 0; i + 1 < switches; i++)
+        EthernetPeer::connect(chain[i], chain[i + 1], 1, 0, 0);
+    EthernetPeer::connect(chain.back(), B, 1, 0, 0);
+
+    EthernetPeer::setDispatchMode(mode);
+    sim::reset();
+
+    //Warm up: both hosts get learned on every switch
+    const char payload[] = "benchmark frame";
+    Ether2Frame toB(B->m_MAC, A->m_MAC, payload, sizeof(payload), ERROR_CONTROL::CRC);
+    Ether2Frame toA(A->m_MAC, B->m_MAC, payload, sizeof(payload), ERROR_CONTROL::CRC);
+    A->sendFrame(0, toB);
+    B->sendFrame(0, toA);
+
+    bench::Timer timer;
+    for (uint64_t i = 0; i < frames; i++)
+    {
+        A->sendFrame(0, toB);
+        if (i % bench::TABLE_REFRESH == bench::TABLE_REFRESH - 1)
+            B->sendFrame(0, toA);
+    }
+    double seconds = timer.seconds();
+
+    bench::report(std::to_string(switches) + " switches, " + (mode == DispatchMode::Closed ? "closed" : "virtual"),
+                  frames, seconds, "frames");
+}
+
+void bench::dispatch()
+{
+    uint64_t frames = bench::iterations(200'000);
+    for (unsigned switches : {1u, 4u, 16u})
+    {
+        runChain(switches, DispatchMode::Virtual, frames);
+        runChain(switches, DispatchMode::Closed, frames);
+    }
+    EthernetPeer::setDispatchMode(DispatchMode::Closed);
+}
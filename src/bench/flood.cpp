@@ -0,0 +1,50 @@
+/**
+ * Inundação em switches largos: um switch com 4096 portas, das quais só K estão conectadas.
+ * O custo de uma inundação deve acompanhar as K portas ativas, e não as 4096 portas do switch.
+ */
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "peers.hpp"
+#include "sim.hpp"
+
+static void runFlood(unsigned portCount, unsigned connected, uint64_t frames)
+{
+    using P = error_control::Crc;
+
+    Ref<Switch> S = std::make_shared<Switch>(P::kind, portCount, 4096);
+    Ref<Host> sender = std::make_shared<Host>(MAC(0x020000000000ull), P::kind);
+    EthernetPeer::connect(sender, S, 0, 0, 0);
+
+    //Connected ports are spread over the whole switch
+    std::vector<Ref<Host>> hosts;
+    for (unsigned i = 1; i < connected; i++)
+    {
+        hosts.push_back(std::make_shared<Host>(MAC(0x020000000000ull + i), P::kind));
+        EthernetPeer::connect(hosts.back(), S, 0, i * (portCount / connected), 0);
+    }
+    sim::reset();
+
+    const char payload[] = "flood benchmark frame";
+    Ether2Frame frame(MAC(0x02FFFFFFFFFFull), sender->m_MAC, payload, sizeof(payload), P{});
+
+    bench::Timer timer;
+    for (uint64_t f = 0; f < frames; f++)
+        sender->sendFrameT<P>(0, frame);
+    double seconds = timer.seconds();
+
+    std::string name = std::to_string(connected) + "/" + std::to_string(portCount) + " ports connected";
+    bench::report(name + " floods", frames, seconds, "frames");
+    bench::report(name + " copies", frames * (connected - 1), seconds, "frames");
+}
+
+void bench::flood()
+{
+    uint64_t frames = bench::iterations(200'000);
+    for (unsigned connected : {4u, 64u, 1024u, 4096u})
+        runFlood(4096, connected, std::max<uint64_t>(frames * 4 / connected, 100));
+}
@@ -0,0 +1,100 @@
+/**
+ * Agregação de enlaces entre dois switches (simulação por eventos, tempo simulado):
+ *
+ *   H hosts - S1 =(LAG de N membros)= S2 - H hosts
+ *
+ * Cada host de um lado manda uma rajada a um host do outro lado, na velocidade do enlace. A vazão entre os
+ * switches deve crescer com N (até a carga oferecida) e o hash deve distribuir os fluxos entre os membros.
+ */
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "egress_queue.hpp"
+#include "peers.hpp"
+#include "sim.hpp"
+
+using P = error_control::Crc;
+
+static void runLag(unsigned members, unsigned hosts, unsigned burst)
+{
+    queueing::QueueConfig config;
+    config.capacity = hosts * burst;
+
+    Ref<Switch> S1 = std::make_shared<Switch>(P::kind, hosts + members, 4096);
+    Ref<Switch> S2 = std::make_shared<Switch>(P::kind, hosts + members, 4096);
+    S1->setEgressQueues(config);
+    S2->setEgressQueues(config);
+
+    //Ports 0..members-1 form the LAG on both switches, hosts take the rest
+    std::vector<uint16_t> lagPorts;
+    for (unsigned m = 0; m < members; m++)
+    {
+        lagPorts.push_back((uint16_t)m);
+        EthernetPeer::connect(S1, S2, m, m, 0);
+    }
+    S1->addLag(lagPorts);
+    S2->addLag(lagPorts);
+
+    std::vector<Ref<Host>> left, right;
+    for (unsigned i = 0; i < hosts; i++)
+    {
+        left.push_back(std::make_shared<Host>(MAC(0x020000000000ull + i), P::kind));
+        right.push_back(std::make_shared<Host>(MAC(0x020000010000ull + i), P::kind));
+        EthernetPeer::connect(left.back(), S1, 0, members + i, 0);
+        EthernetPeer::connect(right.back(), S2, 0, members + i, 0);
+    }
+    sim::reset();
+
+    //The right side announces itself first, so the bursts are switched (not flooded)
+    const char payload[] = "lag frame";
+    std::vector<Ether2Frame> hellos, frames;
+    for (unsigned i = 0; i < hosts; i++)
+    {
+        hellos.emplace_back(MAC(MAC::BROADCAST), right[i]->m_MAC, payload, sizeof(payload), P{});
+        frames.emplace_back(right[i]->m_MAC, left[i]->m_MAC, payload, sizeof(payload), P{});
+    }
+    for (unsigned i = 0; i < hosts; i++)
+        sim::schedule(i * sim::MICROSECOND, [&, i] { right[i]->sendFrameT<P>(0, hellos[i]); });
+    sim::run();
+
+    metrics::PeerSnapshot before = S1->metrics().snapshot();
+    sim::Time start = sim::now() + sim::MICROSECOND;
+    sim::Time frameTime = sim::LinkTiming().serialization(Ether2Frame::WIRE_SIZE);
+    for (unsigned i = 0; i < hosts; i++)
+        for (unsigned f = 0; f < burst; f++)
+            sim::schedule(start + f * frameTime, [&, i] { left[i]->sendFrameT<P>(0, frames[i]); });
+
+    bench::Timer timer;
+    sim::run();
+    double seconds = timer.seconds();
+    sim::Time elapsed = sim::now() - start;
+
+    metrics::PeerSnapshot after = S1->metrics().snapshot();
+    uint64_t total = 0, least = UINT64_MAX, most = 0;
+    for (unsigned m = 0; m < members; m++)
+    {
+        uint64_t sent = after.ports[m].txFrames - before.ports[m].txFrames;
+        total += sent;
+        least = std::min(least, sent);
+        most = std::max(most, sent);
+    }
+
+    double gbps = (double)total * Ether2Frame::WIRE_SIZE * 8 / elapsed;
+    bench::report(std::to_string(members) + " members, " + std::to_string(hosts) + " flows", total, seconds, "frames");
+    std::cout << std::fixed << std::setprecision(2) << "    throughput: " << gbps << " Gbps over the LAG (" << elapsed / 1000.0
+              << " us simulated), per member: min " << least << " / max " << most << " frames (ideal " << total / members << ")"
+              << std::defaultfloat << std::endl;
+}
+
+void bench::lag()
+{
+    unsigned burst = (unsigned)std::min<uint64_t>(bench::iterations(64), 4096);
+    for (unsigned hosts : {16u, 256u})
+        for (unsigned members : {1u, 2u, 4u, 8u})
+            runLag(members, hosts, burst);
+}
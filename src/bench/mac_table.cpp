@@ -0,0 +1,131 @@
+/**
+ * Tabela de MACs lida por várias threads de ingresso (mactable::ShardedTable) comparada a um unordered_map
+ * com uma trava global (o que o Switch precisaria para ser lido por mais de uma thread):
+ *
+ *   N threads leitoras procuram estações conhecidas enquanto uma thread escritora renova entradas,
+ *   aprende estações novas (expulsando as antigas) e envelhece a tabela.
+ *
+ * Mede as consultas por segundo somadas de todas as leitoras, para 1, 2, 4 e 8 leitoras.
+ */
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "bench.hpp"
+#include "mac_table.hpp"
+#include "rng.hpp"
+
+static constexpr size_t STATIONS = 1 << 16;
+static constexpr uint64_t TTL = 15'000;
+
+static uint64_t station(uint64_t i) { return (uint64_t)1 << 48 | (0x020000000000ull + i); }
+
+//Tabela com uma trava global, com a mesma interface da ShardedTable
+class LockedTable
+{
+private:
+    mutable std::mutex m_Mutex;
+    std::unordered_map<uint64_t, mactable::Entry> m_Map;
+    size_t m_Capacity;
+
+public:
+    explicit LockedTable(size_t capacity) : m_Capacity(capacity) { m_Map.reserve(capacity); }
+
+    bool lookup(uint64_t key, mactable::Entry &entry) const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Map.find(key);
+        if (it == m_Map.end())
+            return false;
+        entry = it->second;
+        return true;
+    }
+
+    bool learn(uint64_t key, uint16_t interface, uint64_t currentTime)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Map.find(key);
+        if (it != m_Map.end())
+        {
+            it->second = {interface, currentTime};
+            return false;
+        }
+        //A full table drops any entry: the benchmark only needs the churn, not the eviction policy
+        if (m_Map.size() >= m_Capacity)
+            m_Map.erase(m_Map.begin());
+        m_Map.emplace(key, mactable::Entry{interface, currentTime});
+        return true;
+    }
+
+    size_t age(uint64_t currentTime, uint64_t ttl)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return std::erase_if(m_Map, [&](const auto &item) { return currentTime - item.second.lastUpdate > ttl; });
+    }
+};
+
+template <class Table>
+static void run(const std::string &name, Table &table, unsigned readers, uint64_t lookups)
+{
+    for (uint64_t i = 0; i < STATIONS; i++)
+        table.learn(station(i), (uint16_t)(i % 48), 0);
+
+    //Writer: refreshes known stations, learns new ones and ages the table once per simulated second
+    std::atomic<bool> done = false;
+    uint64_t learned = 0;
+    std::thread writer([&]() {
+        rng::Xoshiro256 rng(7);
+        uint64_t clock = 0, next = STATIONS;
+        while (!done.load(std::memory_order_relaxed))
+        {
+            for (int i = 0; i < 1000; i++)
+                table.learn(station(rng.next() % STATIONS), (uint16_t)(rng.next() % 48), clock);
+            table.learn(station(next++ % (2 * STATIONS)), 1, clock);
+            learned++;
+            if (++clock % 1000 == 0)
+                table.age(clock, TTL);
+        }
+    });
+
+    std::vector<uint64_t> hits(readers);
+    std::vector<std::thread> threads;
+    bench::Timer timer;
+    for (unsigned r = 0; r < readers; r++)
+        threads.emplace_back([&, r]() {
+            rng::Xoshiro256 rng(100 + r);
+            uint64_t found = 0;
+            mactable::Entry entry;
+            for (uint64_t i = 0; i < lookups; i++)
+                found += table.lookup(station(rng.next() % STATIONS), entry);
+            hits[r] = found;
+        });
+    for (std::thread &t : threads)
+        t.join();
+    double seconds = timer.seconds();
+    done = true;
+    writer.join();
+
+    uint64_t found = 0;
+    for (uint64_t h : hits)
+        found += h;
+    bench::report(name + ", " + std::to_string(readers) + " reader(s)", lookups * readers, seconds, "lookups");
+    std::cout << "    hits " << found << " (" << (100 * found / (lookups * readers)) << "%), writer learned " << learned << " new station(s) meanwhile"
+              << std::endl;
+}
+
+void bench::macTable()
+{
+    uint64_t lookups = bench::iterations(2'000'000);
+    std::cout << "  hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    for (unsigned readers : {1u, 2u, 4u, 8u})
+    {
+        mactable::ShardedTable sharded(STATIONS * 2, 64);
+        run("sharded (64 shards)", sharded, readers, lookups);
+        LockedTable locked(STATIONS * 2);
+        run("global lock", locked, readers, lookups);
+    }
+}
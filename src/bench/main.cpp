@@ -0,0 +1,97 @@
+/**
+ * Benchmarks da simulação
+ *
+ * Uso: ./bin/bench [--trace arquivo] [benchmark|all] [repetições]
+ *
+ * --trace grava o caminho dos frames de todos os benchmarks em um Chrome trace (precisa de make TRACE=1)
+ */
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "bench.hpp"
+#include "trace.hpp"
+#include "types.hpp"
+
+static uint64_t __iterations = 0;
+
+void bench::report(const std::string &name, uint64_t ops, double seconds, const char *unit)
+{
+    //Rate with a metric prefix, so slow and fast measurements stay readable side by side
+    double rate = ops / seconds;
+    const char *prefix = "";
+    for (const char *p : {"k", "M", "G"})
+    {
+        if (rate < 1000)
+            break;
+        rate /= 1000;
+        prefix = p;
+    }
+
+    std::cout << "  " << std::left << std::setw(40) << name << std::right << std::setw(12) << ops << " " << unit
+              << "  " << std::fixed << std::setprecision(3) << seconds << " s  " << std::setprecision(2)
+              << rate << " " << prefix << unit << "/s" << std::defaultfloat << std::endl;
+}
+
+uint64_t bench::iterations(uint64_t fallback) { return __iterations ? __iterations : fallback; }
+
+int main(int argc, char const *argv[])
+{
+    static const std::pair<const char *, void (*)()> benchmarks[] = {
+        {"dispatch", bench::dispatch},
+        {"checksums", bench::checksums},
+        {"multicast", bench::multicast},
+        {"vlan", bench::vlan},
+        {"flood", bench::flood},
+        {"switching", bench::switching},
+        {"queues", bench::queues},
+        {"lag", bench::lag},
+        {"burst", bench::burst},
+        {"apps", bench::apps},
+        {"shm", bench::shm},
+        {"checkpoint", bench::checkpoint},
+        {"mactable", bench::macTable},
+        {"router", bench::router},
+    };
+
+    std::string tracePath;
+    if (argc > 2 && std::string(argv[1]) == "--trace")
+    {
+        tracePath = argv[2];
+        argc -= 2;
+        argv += 2;
+        if (!trace::COMPILED)
+            std::cerr << "--trace ignored: built without TRACE=1" << std::endl;
+    }
+
+    std::string which = argc > 1 ? argv[1] : "all";
+    __iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0;
+
+    //The narrative output would dominate every measurement
+    __nezumi_log_on__ = false;
+
+    bool found = false;
+    for (auto &[name, run] : benchmarks)
+    {
+        if (which != "all" && which != name)
+            continue;
+        found = true;
+        std::cout << name << ":" << std::endl;
+        if (!tracePath.empty())
+            trace::start();
+        run();
+        trace::stop();
+    }
+
+    if (!found)
+    {
+        std::cerr << "Unknown benchmark: " << which << std::endl;
+        return 1;
+    }
+
+    if (!tracePath.empty() && trace::COMPILED)
+        std::cout << "trace: " << trace::writeChrome(tracePath) << " events written to " << tracePath << " (" << trace::dropped() << " dropped)" << std::endl;
+    return 0;
+}
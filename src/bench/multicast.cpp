@@ -0,0 +1,73 @@
+/**
+ * Replicação de multicast: um switch com 1 + 2K portas, um emissor e 2K hosts, dos quais K assinam o grupo.
+ * Compara o grupo registrado (cópias só para os K assinantes) com o broadcast (cópias para as 2K portas).
+ */
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "peers.hpp"
+#include "sim.hpp"
+
+static uint64_t deliveredTo(const std::vector<Ref<Host>> &hosts)
+{
+    uint64_t total = 0;
+    for (const Ref<Host> &h : hosts)
+        total += h->metrics().snapshot().ports[0].rxFrames;
+    return total;
+}
+
+static void runGroup(unsigned subscribers, uint64_t frames)
+{
+    using P = error_control::Crc;
+    const MAC group("01:00:5E:00:00:01");
+
+    Ref<Switch> S = std::make_shared<Switch>(P::kind, 1 + 2 * subscribers, 4096);
+    Ref<Host> sender = std::make_shared<Host>(MAC(0x020000000000ull), P::kind);
+    EthernetPeer::connect(sender, S, 0, 0, 0);
+
+    std::vector<Ref<Host>> hosts;
+    for (unsigned i = 0; i < 2 * subscribers; i++)
+    {
+        hosts.push_back(std::make_shared<Host>(MAC(0x020000000001ull + i), P::kind));
+        EthernetPeer::connect(hosts.back(), S, 0, 1 + i, 0);
+        if (i < subscribers)
+            hosts.back()->joinGroup(group);
+    }
+    sim::reset();
+
+    const char payload[] = "multicast benchmark frame";
+    for (const MAC &dst : {group, MAC(MAC::BROADCAST)})
+    {
+        Ether2Frame frame(dst, sender->m_MAC, payload, sizeof(payload), P{});
+        uint64_t deliveredBefore = deliveredTo(hosts);
+        metrics::PeerSnapshot before = S->metrics().snapshot();
+
+        bench::Timer timer;
+        for (uint64_t f = 0; f < frames; f++)
+            sender->sendFrameT<P>(0, frame);
+        double seconds = timer.seconds();
+
+        metrics::PeerSnapshot after = S->metrics().snapshot();
+        uint64_t delivered = deliveredTo(hosts) - deliveredBefore;
+        bool multicast = dst == group;
+        std::string name = std::to_string(subscribers) + "/" + std::to_string(2 * subscribers) + " ports, " + (multicast ? "group" : "broadcast");
+
+        bench::report(name + " sent", frames, seconds, "frames");
+        bench::report(name + " delivered", delivered, seconds, "frames");
+        if (multicast)
+            std::cout << "    fan-out: " << std::fixed << std::setprecision(1)
+                      << (double)(after.replications - before.replications) / (after.multicasts - before.multicasts)
+                      << " copies/frame" << std::defaultfloat << std::endl;
+    }
+}
+
+void bench::multicast()
+{
+    uint64_t deliveries = bench::iterations(1'000'000);
+    for (unsigned subscribers : {16u, 128u, 1024u})
+        runGroup(subscribers, std::max<uint64_t>(deliveries / subscribers, 100));
+}
@@ -0,0 +1,148 @@
+/**
+ * Filas de saída de um switch (simulação por eventos, tempo simulado):
+ *
+ *  - incast: K hosts mandam uma rajada ao mesmo tempo para um único destino; a porta de saída dele
+ *    enche e descarta (tail drop ou RED)
+ *  - prioridade: um fluxo volumoso (PCP 0) e um fluxo esparso (PCP 6) disputam a mesma porta; com uma
+ *    única fila (FIFO) o fluxo esparso espera atrás da rajada (bloqueio de cabeça de fila), com
+ *    prioridade estrita ou DWRR ele passa à frente
+ */
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "egress_queue.hpp"
+#include "latency.hpp"
+#include "peers.hpp"
+#include "sim.hpp"
+
+using P = error_control::Crc;
+
+static const sim::Time FRAME_TIME = sim::LinkTiming().serialization(Ether2Frame::WIRE_SIZE + Ether2Frame::VLAN_TAG_SIZE);
+
+static void runIncast(unsigned senders, unsigned burst, const queueing::QueueConfig &config, const std::string &label)
+{
+    Ref<Switch> S = std::make_shared<Switch>(P::kind, senders + 1, 4096);
+    S->setEgressQueues(config);
+
+    Ref<Host> sink = std::make_shared<Host>(MAC(0x02AA00000000ull), P::kind);
+    EthernetPeer::connect(sink, S, 0, senders, 0);
+    std::vector<Ref<Host>> hosts;
+    for (unsigned i = 0; i < senders; i++)
+    {
+        hosts.push_back(std::make_shared<Host>(MAC(0x020000000001ull + i), P::kind));
+        EthernetPeer::connect(hosts.back(), S, 0, i, 0);
+    }
+    sim::reset();
+    latency::flows().reset();
+
+    //The sink is learned first, so the burst is switched (not flooded)
+    const char payload[] = "incast frame";
+    Ether2Frame hello(MAC(MAC::BROADCAST), sink->m_MAC, payload, sizeof(payload), P{});
+    sim::schedule(0, [&] { sink->sendFrameT<P>(0, hello); });
+    sim::run();
+
+    //Every sender starts its burst at the same instant, at line rate
+    sim::Time start = sim::now() + sim::MICROSECOND;
+    std::vector<Ether2Frame> frames;
+    for (Ref<Host> &h : hosts)
+        frames.emplace_back(sink->m_MAC, h->m_MAC, payload, sizeof(payload), P{});
+    for (unsigned i = 0; i < senders; i++)
+        for (unsigned f = 0; f < burst; f++)
+            sim::schedule(start + f * FRAME_TIME, [&, i] { hosts[i]->sendFrameT<P>(0, frames[i]); });
+
+    bench::Timer timer;
+    size_t events = sim::run();
+    double seconds = timer.seconds();
+
+    metrics::PeerSnapshot s = S->metrics().snapshot();
+    latency::Histogram delivered;
+    for (Ref<Host> &h : hosts)
+        delivered.merge(latency::flows().get(h->m_MAC.bytes, sink->m_MAC.bytes).endToEnd);
+
+    bench::report(label, events, seconds, "events");
+    std::cout << "    offered " << senders * burst << ", delivered " << delivered.count() << ", tail drops " << s.ports[senders].tailDrops
+              << ", RED drops " << s.ports[senders].redDrops << ", peak depth " << s.ports[senders].queuePeak << " frames" << std::endl;
+    latency::printSummary(std::cout, "    end-to-end", latency::summarize(delivered));
+}
+
+static void runPriority(const queueing::QueueConfig &config, bool prioritized, const std::string &label)
+{
+    //Two bulk hosts at line rate share the sink port with a sparse urgent flow: the port is oversubscribed 2:1
+    Ref<Switch> S = std::make_shared<Switch>(P::kind, 4, 4096);
+    S->setEgressQueues(config);
+
+    Ref<Host> sink = std::make_shared<Host>(MAC(0x02AA00000000ull), P::kind);
+    Ref<Host> urgent = std::make_shared<Host>(MAC(0x020000000001ull), P::kind);
+    std::vector<Ref<Host>> bulk = {std::make_shared<Host>(MAC(0x020000000002ull), P::kind),
+                                   std::make_shared<Host>(MAC(0x020000000003ull), P::kind)};
+    EthernetPeer::connect(sink, S, 0, 0, 0);
+    EthernetPeer::connect(urgent, S, 0, 1, 0);
+    EthernetPeer::connect(bulk[0], S, 0, 2, 0);
+    EthernetPeer::connect(bulk[1], S, 0, 3, 0);
+    sim::reset();
+    latency::flows().reset();
+
+    const char payload[] = "priority frame";
+    Ether2Frame hello(MAC(MAC::BROADCAST), sink->m_MAC, payload, sizeof(payload), P{});
+    sim::schedule(0, [&] { sink->sendFrameT<P>(0, hello); });
+    sim::run();
+
+    //Priority-tagged frames (VID 0): bulk at PCP 0, urgent at PCP 6 (or 0, sharing the bulk FIFO)
+    std::vector<Ether2Frame> bulkFrames;
+    for (Ref<Host> &h : bulk)
+    {
+        bulkFrames.emplace_back(sink->m_MAC, h->m_MAC, payload, sizeof(payload), P{});
+        bulkFrames.back().tag(0, 0);
+    }
+    Ether2Frame urgentFrame(sink->m_MAC, urgent->m_MAC, payload, sizeof(payload), P{});
+    urgentFrame.tag(0, prioritized ? 6 : 0);
+
+    const unsigned BULK = 1000, URGENT = 50;
+    sim::Time start = sim::now() + sim::MICROSECOND;
+    for (unsigned f = 0; f < BULK; f++)
+        for (unsigned h = 0; h < bulk.size(); h++)
+            sim::schedule(start + f * FRAME_TIME, [&, h] { bulk[h]->sendFrameT<P>(0, bulkFrames[h]); });
+    for (unsigned f = 0; f < URGENT; f++)
+        sim::schedule(start + f * (BULK / URGENT) * FRAME_TIME, [&] { urgent->sendFrameT<P>(0, urgentFrame); });
+
+    bench::Timer timer;
+    size_t events = sim::run();
+    double seconds = timer.seconds();
+
+    metrics::PeerSnapshot s = S->metrics().snapshot();
+    bench::report(label, events, seconds, "events");
+    std::cout << "    drops " << s.ports[0].tailDrops + s.ports[0].redDrops << ", peak depth " << s.ports[0].queuePeak << " frames" << std::endl;
+    latency::printSummary(std::cout, "    urgent", latency::summarize(latency::flows().get(urgent->m_MAC.bytes, sink->m_MAC.bytes).endToEnd));
+    latency::printSummary(std::cout, "    bulk  ", latency::summarize(latency::flows().get(bulk[0]->m_MAC.bytes, sink->m_MAC.bytes).endToEnd));
+}
+
+void bench::queues()
+{
+    queueing::QueueConfig tail;
+    tail.capacity = 128;
+
+    queueing::QueueConfig red = tail;
+    red.drop = queueing::DropPolicy::RED;
+    red.redMin = 32;
+    red.redMax = 96;
+    red.redWeight = 0.02;
+
+    for (unsigned senders : {4u, 16u})
+    {
+        runIncast(senders, 64, tail, "incast " + std::to_string(senders) + "x64, tail drop");
+        runIncast(senders, 64, red, "incast " + std::to_string(senders) + "x64, RED");
+    }
+
+    queueing::QueueConfig strict;
+    strict.capacity = 1024;
+    queueing::QueueConfig dwrr = strict;
+    dwrr.scheduling = queueing::Scheduling::DWRR;
+    dwrr.quantum[6] = 4 * 1522;
+
+    runPriority(strict, false, "priority, single FIFO class");
+    runPriority(strict, true, "priority, strict");
+    runPriority(dwrr, true, "priority, DWRR (PCP 6 weight 4)");
+}
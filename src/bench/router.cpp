@@ -0,0 +1,213 @@
+/**
+ * Roteador com uma tabela do tamanho da Internet (cerca de 1 milhão de prefixos IPv4):
+ *
+ *   - carga da tabela DIR-24-8 (rotas/s, memória, grupos de tbl8);
+ *   - buscas por segundo com endereços aleatórios e com endereços dentro das rotas, uma a uma e em lote,
+ *     comparadas a uma busca ingênua (um hash por tamanho de prefixo, do mais longo ao mais curto),
+ *     que também confere as respostas;
+ *   - encaminhamento pela simulação:  A - R - B,  com todas as rotas de R apontando para B.
+ *
+ * A tabela é sintética (sem um dump de BGP no repositório), com a distribuição de tamanhos de prefixo da
+ * tabela global: maioria /24, depois /22, /23, /21, /20..., poucos mais curtos que /16 e alguns mais longos que /24.
+ */
+#include <array>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "bench.hpp"
+#include "ipv4.hpp"
+#include "lpm.hpp"
+#include "rng.hpp"
+#include "router.hpp"
+#include "sim.hpp"
+
+using P = error_control::Crc;
+
+struct Route
+{
+    uint32_t prefix;
+    uint8_t length;
+    uint32_t nextHop;
+};
+
+static constexpr uint32_t NEXT_HOPS = 64;
+
+static std::vector<Route> internetTable(size_t count)
+{
+    //Approximate share (per mille) of each prefix length in the global table
+    static const std::pair<uint8_t, unsigned> LENGTHS[] = {{8, 1},   {12, 2},  {14, 3},  {15, 4},  {16, 15}, {17, 8},  {18, 14}, {19, 25},
+                                                           {20, 40}, {21, 50}, {22, 120}, {23, 100}, {24, 603}, {25, 5}, {26, 4},  {28, 3},
+                                                           {30, 2},  {32, 1}};
+    rng::Xoshiro256 rng(2024);
+    std::vector<Route> routes;
+    std::unordered_set<uint64_t> seen;
+    routes.reserve(count);
+    while (routes.size() < count)
+    {
+        unsigned pick = (unsigned)(rng.next() % 1000), sum = 0;
+        uint8_t length = 24;
+        for (auto [l, share] : LENGTHS)
+            if (pick < (sum += share))
+            {
+                length = l;
+                break;
+            }
+        //Unicast space only (1.0.0.0 - 223.255.255.255)
+        uint32_t prefix = (uint32_t)(0x01000000 + rng.next() % (0xE0000000u - 0x01000000)) & ipv4::mask(length);
+        if (seen.insert((uint64_t)length << 32 | prefix).second)
+            routes.push_back({prefix, length, (uint32_t)(rng.next() % NEXT_HOPS)});
+    }
+    return routes;
+}
+
+//Busca ingênua: um hash por tamanho de prefixo, do mais longo ao mais curto
+class NaiveLpm
+{
+private:
+    std::array<std::unordered_map<uint32_t, uint32_t>, 33> m_ByLength;
+
+public:
+    void insert(uint32_t prefix, unsigned length, uint32_t nextHop) { m_ByLength[length][prefix & ipv4::mask(length)] = nextHop; }
+
+    uint32_t lookup(uint32_t address) const
+    {
+        for (int length = 32; length >= 0; length--)
+        {
+            const auto &table = m_ByLength[length];
+            if (table.empty())
+                continue;
+            auto it = table.find(address & ipv4::mask(length));
+            if (it != table.end())
+                return it->second;
+        }
+        return lpm::NO_ROUTE;
+    }
+};
+
+static void lookups(const lpm::Dir24_8 &table, const NaiveLpm &naive, const std::vector<uint32_t> &addresses, const std::string &name)
+{
+    uint64_t singleSum = 0, batchSum = 0;
+    bench::Timer single;
+    for (uint32_t a : addresses)
+        singleSum += table.lookup(a);
+    bench::report("DIR-24-8, " + name, addresses.size(), single.seconds(), "lookups");
+
+    std::vector<uint32_t> hops(addresses.size());
+    bench::Timer batch;
+    table.lookup(addresses, hops);
+    bench::report("DIR-24-8 batch, " + name, addresses.size(), batch.seconds(), "lookups");
+    for (uint32_t hop : hops)
+        batchSum += hop;
+
+    //The naive lookup is much slower, so it runs on a sample, which is also checked against DIR-24-8
+    size_t sample = std::min<size_t>(addresses.size(), 200'000), mismatches = 0, routed = 0;
+    bench::Timer reference;
+    for (size_t i = 0; i < sample; i++)
+    {
+        uint32_t expected = naive.lookup(addresses[i]);
+        mismatches += expected != hops[i];
+        routed += expected != lpm::NO_ROUTE;
+    }
+    bench::report("per-length hash, " + name, sample, reference.seconds(), "lookups");
+    std::cout << "    " << routed << " of " << sample << " routed, " << mismatches << " mismatch(es), single and batch "
+              << (singleSum == batchSum ? "agree" : "DISAGREE") << std::endl;
+}
+
+static void forwarding(const std::vector<Route> &routes, uint64_t frames)
+{
+    const MAC MAC_A(0x02000000000Aull), MAC_B(0x02000000000Bull), MAC_R0(0x020000000100ull), MAC_R1(0x020000000101ull);
+    const uint32_t IP_A = ipv4::parse("10.0.0.2"), IP_B = ipv4::parse("10.0.1.2");
+
+    Ref<Host> A = std::make_shared<Host>(MAC_A, P::kind);
+    Ref<Host> B = std::make_shared<Host>(MAC_B, P::kind);
+    Ref<Router> R = std::make_shared<Router>(P::kind, 2);
+    R->setInterface(0, MAC_R0, ipv4::parse("10.0.0.1"), 24);
+    R->setInterface(1, MAC_R1, ipv4::parse("10.0.1.1"), 24);
+    R->addArp(IP_B, MAC_B);
+    EthernetPeer::connect(A, R, 0, 0, 0);
+    EthernetPeer::connect(R, B, 1, 0, 0);
+    sim::reset();
+
+    bench::Timer load;
+    for (const Route &route : routes)
+        R->addRoute(route.prefix, route.length, 1, IP_B);
+    bench::report("router table load", routes.size(), load.seconds(), "routes");
+
+    //Packets to addresses inside the routes; each send uses a copy, since the router rewrites the frame it gets
+    rng::Xoshiro256 rng(5);
+    std::vector<Ether2Frame> packets;
+    const char payload[] = "router benchmark packet";
+    for (size_t i = 0; i < 4096; i++)
+    {
+        const Route &route = routes[rng.next() % routes.size()];
+        uint32_t destination = route.prefix | ((uint32_t)rng.next() & ~ipv4::mask(route.length));
+        packets.push_back(ipv4::packet<P>(MAC_R0, MAC_A, IP_A, destination, payload, sizeof(payload)));
+    }
+
+    bench::Timer timer;
+    for (uint64_t i = 0; i < frames; i++)
+    {
+        Ether2Frame frame = packets[i % packets.size()];
+        A->sendFrameT<P>(0, frame);
+    }
+    double seconds = timer.seconds();
+
+    metrics::PeerSnapshot snapshot = R->metrics().snapshot();
+    bench::report("A - R - B forwarding", frames, seconds, "frames");
+    std::cout << "    forwarded " << R->forwarded() << ", B received " << B->metrics().snapshot().ports[0].rxFrames << ", no route "
+              << snapshot.drops[(size_t)metrics::DropReason::NoRoute] << ", no ARP " << snapshot.drops[(size_t)metrics::DropReason::NoArp] << std::endl;
+}
+
+void bench::router()
+{
+    const size_t ROUTES = 1'000'000;
+    uint64_t count = bench::iterations(10'000'000);
+
+    std::vector<Route> routes = internetTable(ROUTES);
+
+    lpm::Dir24_8 table;
+    bench::Timer load;
+    for (const Route &route : routes)
+        table.insert(route.prefix, route.length, route.nextHop);
+    bench::report("DIR-24-8 load", routes.size(), load.seconds(), "routes");
+    std::cout << "    " << table.size() << " distinct prefixes, " << table.groups() << " tbl8 group(s), "
+              << table.memoryBytes() / (1024 * 1024) << " MiB" << std::endl;
+
+    NaiveLpm naive;
+    bench::Timer naiveLoad;
+    for (const Route &route : routes)
+        naive.insert(route.prefix, route.length, route.nextHop);
+    bench::report("per-length hash load", routes.size(), naiveLoad.seconds(), "routes");
+
+    rng::Xoshiro256 rng(11);
+    std::vector<uint32_t> uniform(count), routed(count);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        uniform[i] = (uint32_t)rng.next();
+        const Route &route = routes[rng.next() % routes.size()];
+        routed[i] = route.prefix | ((uint32_t)rng.next() & ~ipv4::mask(route.length));
+    }
+    lookups(table, naive, uniform, "uniform addresses");
+    lookups(table, naive, routed, "addresses in routes");
+
+    //Removing every other route must leave the covering routes in place
+    bench::Timer removal;
+    size_t removed = 0;
+    for (size_t i = 0; i < routes.size(); i += 2)
+        removed += table.remove(routes[i].prefix, routes[i].length);
+    bench::report("DIR-24-8 removal", removed, removal.seconds(), "routes");
+    NaiveLpm remaining;
+    for (size_t i = 0; i < routes.size(); i++)
+        if (i % 2)
+            remaining.insert(routes[i].prefix, routes[i].length, routes[i].nextHop);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < std::min<size_t>(routed.size(), 200'000); i++)
+        mismatches += table.lookup(routed[i]) != remaining.lookup(routed[i]);
+    std::cout << "    " << table.size() << " prefixes left, " << table.groups() << " tbl8 group(s), " << mismatches << " mismatch(es)" << std::endl;
+
+    forwarding(routes, bench::iterations(200'000));
+}
@@ -0,0 +1,125 @@
+/**
+ * Enlace entre processos por memória compartilhada (shm::Link) comparado a um enlace dentro do processo:
+ *
+ *   um processo:     A - S1 - S2 - B
+ *   dois processos:  A - S1 - [shm] ~ [shm] - S2 - B      (o segundo processo é criado com fork)
+ *
+ * A manda frames na velocidade do enlace (uma corrotina no tempo simulado). Os dois processos avançam o tempo
+ * de forma conservadora; a vazão medida inclui a espera de um processo pelo relógio do outro.
+ */
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.hpp"
+#include "peers.hpp"
+#include "shm_link.hpp"
+#include "sim.hpp"
+#include "task.hpp"
+
+using P = error_control::Crc;
+
+static const MAC MAC_A(0x02000000000Aull), MAC_B(0x02000000000Bull);
+
+//Envia 'frames' frames a B, um a cada tempo de serialização
+static sim::Task sender(Ref<Host> A, uint64_t frames)
+{
+    const char payload[] = "benchmark frame";
+    sim::Time interval = sim::LinkTiming{}.serialization(Ether2Frame::WIRE_SIZE);
+    for (uint64_t i = 0; i < frames; i++)
+    {
+        Ether2Frame frame(MAC_B, MAC_A, payload, sizeof(payload), P{});
+        A->sendFrameT<P>(0, frame);
+        co_await sim::sleep(interval);
+    }
+}
+
+//Tempo simulado suficiente para todos os frames chegarem
+static sim::Time endOf(uint64_t frames) { return (frames + 16) * sim::LinkTiming{}.serialization(Ether2Frame::WIRE_SIZE) + sim::MILLISECOND; }
+
+static void runLocal(uint64_t frames)
+{
+    Ref<Host> A = std::make_shared<Host>(MAC_A, P::kind);
+    Ref<Host> B = std::make_shared<Host>(MAC_B, P::kind);
+    Ref<Switch> S1 = std::make_shared<Switch>(P::kind, 2, 1024);
+    Ref<Switch> S2 = std::make_shared<Switch>(P::kind, 2, 1024);
+    EthernetPeer::connect(A, S1, 0, 0, 0);
+    EthernetPeer::connect(S1, S2, 1, 0, 0);
+    EthernetPeer::connect(S2, B, 1, 0, 0);
+    sim::reset();
+
+    sim::spawn(sender(A, frames));
+    bench::Timer timer;
+    sim::run(endOf(frames));
+    double seconds = timer.seconds();
+
+    bench::report("one process", frames, seconds, "frames");
+    std::cout << "    B received " << B->metrics().snapshot().ports[0].rxFrames << std::endl;
+}
+
+static void runSharded(uint64_t frames)
+{
+    std::string name = "/nls-bench-" + std::to_string(getpid());
+    std::cout << std::flush;
+
+    pid_t child = fork();
+    if (child < 0)
+    {
+        std::cout << "  fork failed, skipping the two-process run" << std::endl;
+        return;
+    }
+
+    if (child == 0)
+    {
+        //Second process: the shared-memory link, S2 and B
+        int status = 0;
+        try
+        {
+            Ref<shm::Link> link = std::make_shared<shm::Link>(name, false, P::kind);
+            Ref<Switch> S2 = std::make_shared<Switch>(P::kind, 2, 1024);
+            Ref<Host> B = std::make_shared<Host>(MAC_B, P::kind);
+            EthernetPeer::connect(link, S2, 0, 0, 0);
+            EthernetPeer::connect(S2, B, 1, 0, 0);
+            sim::reset();
+
+            shm::Link *links[] = {link.get()};
+            shm::run(links, endOf(frames));
+            std::cout << "    B received " << B->metrics().snapshot().ports[0].rxFrames << " (second process)" << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            std::cout << "    second process failed: " << e.what() << std::endl;
+            status = 1;
+        }
+        std::cout << std::flush;
+        _exit(status);
+    }
+
+    Ref<shm::Link> link = std::make_shared<shm::Link>(name, true, P::kind);
+    Ref<Host> A = std::make_shared<Host>(MAC_A, P::kind);
+    Ref<Switch> S1 = std::make_shared<Switch>(P::kind, 2, 1024);
+    EthernetPeer::connect(A, S1, 0, 0, 0);
+    EthernetPeer::connect(S1, link, 1, 0, 0);
+    sim::reset();
+
+    sim::spawn(sender(A, frames));
+    shm::Link *links[] = {link.get()};
+    bench::Timer timer;
+    shm::run(links, endOf(frames));
+    double seconds = timer.seconds();
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    bench::report("two processes (shared memory)", frames, seconds, "frames");
+}
+
+void bench::shm()
+{
+    uint64_t frames = bench::iterations(200'000);
+    runLocal(frames);
+    runSharded(frames);
+    sim::reset();
+}
@@ -0,0 +1,85 @@
+/**
+ * Modos de comutação por uma cadeia de switches com enlaces ruidosos:
+ *
+ *   A - S1 - S2 - ... - Sn - B
+ *
+ * Para store-and-forward e cut-through: latência fim-a-fim (tempo simulado), frames corrompidos que
+ * seguiram adiante e a banda desperdiçada com eles (bytes de frames inválidos transmitidos pelos switches).
+ */
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "latency.hpp"
+#include "peers.hpp"
+#include "sim.hpp"
+
+static void runChain(unsigned switches, SwitchingMode mode, double bitErrorRate, uint64_t frames)
+{
+    using P = error_control::Crc;
+
+    Ref<Host> A = std::make_shared<Host>(MAC("02:AA:AA:AA:AA:AA"), P::kind);
+    Ref<Host> B = std::make_shared<Host>(MAC("02:BB:BB:BB:BB:BB"), P::kind);
+
+    std::vector<Ref<Switch>> chain;
+    for (unsigned i = 0; i < switches; i++)
+    {
+        chain.push_back(std::make_shared<Switch>(P::kind, 2, 1024));
+        chain.back()->setSwitchingMode(mode);
+    }
+
+    EthernetPeer::connect(A, chain.front(), 0, 0, 0);
+    for (unsigned i = 0; i + 1 < switches; i++)
+        EthernetPeer::connect(chain[i], chain[i + 1], 1, 0, 0);
+    EthernetPeer::connect(chain.back(), B, 1, 0, 0);
+    sim::reset();
+
+    //Warm up on clean links: B gets learned on every switch
+    const char payload[] = "switching benchmark frame";
+    Ether2Frame toA(A->m_MAC, B->m_MAC, payload, sizeof(payload), P{});
+    B->sendFrameT<P>(0, toA);
+
+    A->setBitErrorRate(0, bitErrorRate);
+    for (Ref<Switch> &s : chain)
+        for (unsigned port = 0; port < 2; port++)
+            s->setBitErrorRate(port, bitErrorRate);
+    latency::flows().reset();
+
+    Ether2Frame toB(B->m_MAC, A->m_MAC, payload, sizeof(payload), P{});
+    bench::Timer timer;
+    for (uint64_t i = 0; i < frames; i++)
+        A->sendFrameT<P>(0, toB);
+    double seconds = timer.seconds();
+
+    uint64_t corrupt = 0, wasted = 0, sent = 0, dropped = 0;
+    for (const Ref<Switch> &s : chain)
+    {
+        metrics::PeerSnapshot snapshot = s->metrics().snapshot();
+        corrupt += snapshot.corruptForwarded;
+        wasted += snapshot.wastedBytes;
+        dropped += snapshot.drops[(size_t)metrics::DropReason::Checksum];
+        for (const metrics::PortSnapshot &p : snapshot.ports)
+            sent += p.txBytes;
+    }
+    uint64_t badAtB = B->metrics().snapshot().checksumFailures;
+
+    std::string name = std::to_string(switches) + " switches, " + (mode == SwitchingMode::CutThrough ? "cut-through" : "store-and-forward");
+    bench::report(name, frames, seconds, "frames");
+    latency::printSummary(std::cout, "    end-to-end", latency::summarize(latency::flows().get(A->m_MAC.bytes, B->m_MAC.bytes).endToEnd));
+    std::cout << "    dropped at a switch: " << dropped << ", corrupt forwarded: " << corrupt << ", corrupt at B: " << badAtB << std::endl;
+    std::cout << "    wasted: " << wasted << " of " << sent << " bytes sent by switches (" << std::fixed << std::setprecision(2)
+              << (sent ? 100.0 * wasted / sent : 0.0) << "%)" << std::defaultfloat << std::endl;
+}
+
+void bench::switching()
+{
+    uint64_t frames = bench::iterations(100'000);
+    for (unsigned switches : {1u, 4u})
+    {
+        runChain(switches, SwitchingMode::StoreAndForward, 1e-6, frames);
+        runChain(switches, SwitchingMode::CutThrough, 1e-6, frames);
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * Domínios de broadcast por VLAN: um switch com 1 + N portas de acesso divididas em V VLANs.
+ * O emissor envia frames para um destino desconhecido (inundação); com V VLANs cada inundação
+ * alcança só as N/V portas da VLAN do emissor em vez das N portas do switch.
+ */
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "peers.hpp"
+#include "sim.hpp"
+
+static uint64_t transmitted(const metrics::PeerSnapshot &snapshot)
+{
+    uint64_t total = 0;
+    for (const metrics::PortSnapshot &p : snapshot.ports)
+        total += p.txFrames;
+    return total;
+}
+
+static void runFlood(unsigned ports, unsigned vlans, uint64_t frames)
+{
+    using P = error_control::Crc;
+
+    Ref<Switch> S = std::make_shared<Switch>(P::kind, 1 + ports, 4096);
+    Ref<Host> sender = std::make_shared<Host>(MAC(0x020000000000ull), P::kind);
+    EthernetPeer::connect(sender, S, 0, 0, 0);
+
+    //The sender is in VLAN 1, host i in VLAN 1 + i % V
+    std::vector<Ref<Host>> hosts;
+    for (unsigned i = 0; i < ports; i++)
+    {
+        hosts.push_back(std::make_shared<Host>(MAC(0x020000000001ull + i), P::kind));
+        EthernetPeer::connect(hosts.back(), S, 0, 1 + i, 0);
+        S->setAccessPort(1 + i, 1 + i % vlans);
+    }
+    sim::reset();
+
+    const char payload[] = "vlan benchmark frame";
+    Ether2Frame frame(MAC(0x02FFFFFFFFFFull), sender->m_MAC, payload, sizeof(payload), P{});
+    metrics::PeerSnapshot before = S->metrics().snapshot();
+
+    bench::Timer timer;
+    for (uint64_t f = 0; f < frames; f++)
+        sender->sendFrameT<P>(0, frame);
+    double seconds = timer.seconds();
+
+    metrics::PeerSnapshot after = S->metrics().snapshot();
+    uint64_t copies = transmitted(after) - transmitted(before);
+    std::string name = std::to_string(ports) + " ports, " + std::to_string(vlans) + (vlans == 1 ? " VLAN" : " VLANs");
+
+    bench::report(name + " floods", frames, seconds, "frames");
+    bench::report(name + " copies", copies, seconds, "frames");
+    std::cout << "    fan-out: " << std::fixed << std::setprecision(1) << (double)copies / (after.floods - before.floods) << " copies/flood"
+              << std::defaultfloat << std::endl;
+}
+
+void bench::vlan()
+{
+    uint64_t copies = bench::iterations(1'000'000);
+    const unsigned ports = 256;
+    for (unsigned vlans : {1u, 4u, 16u, 64u})
+        runFlood(ports, vlans, std::max<uint64_t>(copies * vlans / ports, 100));
+}
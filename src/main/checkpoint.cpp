@@ -0,0 +1,616 @@
+#include "checkpoint.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "egress_queue.hpp"
+#include "noise.hpp"
+#include "sim.hpp"
+#include "topology.hpp"
+
+namespace checkpoint
+{
+    static constexpr uint64_t MAGIC = 0x54504B43534C4E; //"NLSCKPT"
+
+    //Sections are aligned so the records can be read in place from the mapping
+    static constexpr size_t ALIGNMENT = 64;
+
+    //Marks a group/VLAN that is registered with no port (it still changes how its frames are forwarded)
+    static constexpr uint16_t NO_PORT_RECORD = 0xFFFF;
+
+    enum class Section : uint32_t
+    {
+        Globals,
+        Peers,
+        Ports,
+        HostGroups,
+        MacTable,
+        GroupPorts,
+        VlanPorts,
+        LagMembers,
+        Queues,
+        QueuedFrames,
+        Wire,
+        COUNT
+    };
+
+    struct Header
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t sections;
+        uint64_t bytes;
+    };
+
+    struct SectionEntry
+    {
+        uint32_t type;
+        uint32_t recordSize; //Also rejects files written by a build with another record layout
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    struct GlobalsRecord
+    {
+        sim::Time now;
+        uint64_t seed, streamsUsed;
+        uint8_t dispatchMode;
+    };
+
+    struct PeerRecord
+    {
+        PeerKind kind;
+        uint8_t errorControl;
+        uint16_t ports;
+        uint8_t promiscuous;   //Host
+        uint8_t switchingMode; //Switch
+        uint8_t queues;        //Switch: egress queues enabled
+        uint64_t mac;          //Host
+        uint64_t tableSize;    //Switch
+        uint64_t floodStamp;   //Switch
+        sim::LinkTiming timing;
+    };
+
+    //Every port of every peer, in order (a peer's ports follow the ports of the peers before it)
+    struct PortRecord
+    {
+        PortLink link; //Peer as an index into the checkpoint's peers
+        uint8_t trunk;
+        uint16_t pvid;
+        double bitErrorRate;
+        rng::Xoshiro256 rng;
+        uint64_t bitsUntilError;
+    };
+
+    struct HostGroupRecord
+    {
+        uint32_t peer;
+        uint64_t group;
+    };
+
+    struct MacTableRecord
+    {
+        uint32_t peer;
+        uint64_t key;
+        SwitchTableEntry entry;
+    };
+
+    struct GroupPortRecord
+    {
+        uint32_t peer;
+        uint16_t port;
+        uint8_t isStatic;
+        uint64_t group;
+    };
+
+    struct VlanPortRecord
+    {
+        uint32_t peer;
+        uint16_t vid;
+        uint16_t port;
+    };
+
+    struct LagMemberRecord
+    {
+        uint32_t peer;
+        uint16_t lag;
+        uint16_t port;
+        uint64_t floodStamp;
+    };
+
+    struct QueueRecord
+    {
+        uint32_t peer;
+        uint16_t port;
+        queueing::QueueConfig config;
+        double average[queueing::CLASSES];
+        uint32_t deficit[queueing::CLASSES];
+        uint32_t cursor;
+        uint8_t visited;
+        rng::Xoshiro256 rng;
+        sim::Time busyUntil, serviceAt;
+    };
+
+    struct QueuedFrameRecord
+    {
+        uint32_t peer;
+        uint16_t port;
+        uint8_t cls;
+        Ether2Frame frame;
+    };
+
+    struct WireRecord
+    {
+        PortLink link;
+        Ether2Frame frame;
+    };
+
+    static_assert(std::is_trivially_copyable_v<PeerRecord> && std::is_trivially_copyable_v<PortRecord> &&
+                  std::is_trivially_copyable_v<QueueRecord> && std::is_trivially_copyable_v<QueuedFrameRecord> &&
+                  std::is_trivially_copyable_v<WireRecord>);
+
+    static std::runtime_error systemError(const std::string &what, const std::string &path)
+    {
+        return std::runtime_error(what + " '" + path + "': " + strerror(errno));
+    }
+
+    //Sections being written: raw bytes of each record vector
+    struct Writer
+    {
+        struct Buffer
+        {
+            uint32_t recordSize = 0;
+            uint64_t count = 0;
+            std::vector<char> bytes;
+        } sections[(size_t)Section::COUNT];
+
+        template <class T>
+        void add(Section section, const T &record)
+        {
+            Buffer &buffer = sections[(size_t)section];
+            buffer.recordSize = sizeof(T);
+            buffer.count++;
+            const char *raw = reinterpret_cast<const char *>(&record);
+            buffer.bytes.insert(buffer.bytes.end(), raw, raw + sizeof(T));
+        }
+
+        size_t write(const std::string &path)
+        {
+            constexpr size_t COUNT = (size_t)Section::COUNT;
+            SectionEntry table[COUNT];
+            uint64_t offset = sizeof(Header) + sizeof(table);
+            for (size_t i = 0; i < COUNT; i++)
+            {
+                offset = (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+                table[i] = {(uint32_t)i, sections[i].recordSize, offset, sections[i].count};
+                offset += sections[i].bytes.size();
+            }
+            Header header = {MAGIC, VERSION, (uint32_t)COUNT, offset};
+
+            //Written next to the destination and renamed, so a reader never maps half a checkpoint
+            std::string tmp = path + ".tmp";
+            {
+                std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+                if (!out)
+                    throw systemError("Could not create checkpoint", tmp);
+                out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+                out.write(reinterpret_cast<const char *>(table), sizeof(table));
+                for (size_t i = 0; i < COUNT; i++)
+                {
+                    static const char zeros[ALIGNMENT] = {};
+                    out.write(zeros, (std::streamsize)(table[i].offset - (uint64_t)out.tellp()));
+                    out.write(sections[i].bytes.data(), (std::streamsize)sections[i].bytes.size());
+                }
+                if (!out.flush())
+                    throw systemError("Could not write checkpoint", tmp);
+            }
+            if (std::rename(tmp.c_str(), path.c_str()) != 0)
+                throw systemError("Could not replace checkpoint", path);
+            return offset;
+        }
+    };
+
+    //Read-only mapping of a checkpoint, released when restore is done
+    class Mapping
+    {
+    private:
+        const char *m_Data = nullptr;
+        size_t m_Bytes = 0;
+        const SectionEntry *m_Table = nullptr;
+
+    public:
+        explicit Mapping(const std::string &path)
+        {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw systemError("Could not open checkpoint", path);
+            struct stat st = {};
+            if (fstat(fd, &st) < 0)
+            {
+                close(fd);
+                throw systemError("Could not read checkpoint", path);
+            }
+            m_Bytes = (size_t)st.st_size;
+
+            void *memory = m_Bytes ? mmap(nullptr, m_Bytes, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+            close(fd);
+            if (memory == MAP_FAILED)
+                throw systemError("Could not map checkpoint", path);
+            m_Data = static_cast<const char *>(memory);
+
+            //Validated once here: section() only checks the record layout
+            const Header *header = reinterpret_cast<const Header *>(m_Data);
+            const size_t COUNT = (size_t)Section::COUNT;
+            bool valid = m_Bytes >= sizeof(Header) && header->magic == MAGIC;
+            if (valid && header->version != VERSION)
+            {
+                munmap(memory, m_Bytes);
+                throw std::runtime_error("Checkpoint '" + path + "' has format version " + std::to_string(header->version) +
+                                         " (expected " + std::to_string(VERSION) + ")");
+            }
+            valid = valid && header->sections == COUNT && header->bytes == m_Bytes && m_Bytes >= sizeof(Header) + COUNT * sizeof(SectionEntry);
+            m_Table = reinterpret_cast<const SectionEntry *>(m_Data + sizeof(Header));
+            for (size_t i = 0; valid && i < COUNT; i++)
+            {
+                const SectionEntry &entry = m_Table[i];
+                valid = entry.type == i && entry.offset % ALIGNMENT == 0 && entry.offset <= m_Bytes &&
+                        (entry.count == 0 || (entry.recordSize && entry.count <= (m_Bytes - entry.offset) / entry.recordSize));
+            }
+            if (!valid)
+            {
+                munmap(memory, m_Bytes);
+                throw std::runtime_error("'" + path + "' is not a valid checkpoint");
+            }
+        }
+
+        ~Mapping() { munmap(const_cast<char *>(m_Data), m_Bytes); }
+
+        Mapping(const Mapping &) = delete;
+        Mapping &operator=(const Mapping &) = delete;
+
+        template <class T>
+        std::span<const T> section(Section section) const
+        {
+            const SectionEntry &entry = m_Table[(size_t)section];
+            if (entry.count == 0)
+                return {};
+            if (entry.recordSize != sizeof(T))
+                throw std::runtime_error("Checkpoint record layout does not match this build");
+            return {reinterpret_cast<const T *>(m_Data + entry.offset), (size_t)entry.count};
+        }
+    };
+
+    //Calls f(records of one peer) for each run of consecutive records of the same peer
+    template <class T, class F>
+    static void forEachPeerRun(std::span<const T> records, F &&f)
+    {
+        for (size_t first = 0; first < records.size();)
+        {
+            size_t last = first;
+            while (last < records.size() && records[last].peer == records[first].peer)
+                last++;
+            f(records[first].peer, records.subspan(first, last - first));
+            first = last;
+        }
+    }
+
+    struct Access
+    {
+        static size_t save(const std::string &path)
+        {
+            if (sim::running())
+                throw std::runtime_error("A checkpoint can only be saved between calls to sim::run");
+
+            Topology &topology = Topology::global();
+            Writer writer;
+
+            //Ids of removed peers are skipped: the peers are numbered again from 0
+            std::vector<PeerId> index(topology.idCount(), NO_PEER);
+            std::vector<EthernetPeer *> peers;
+            for (PeerId id = 0; id < topology.idCount(); id++)
+            {
+                EthernetPeer *peer = topology.peer(id);
+                if (!peer)
+                    continue;
+                if (topology.kind(id) != PeerKind::Host && topology.kind(id) != PeerKind::Switch)
+                    throw std::runtime_error("Only hosts and switches can be saved in a checkpoint");
+                index[id] = (PeerId)peers.size();
+                peers.push_back(peer);
+            }
+            auto remap = [&](const PortLink &link) { return link.connected() ? PortLink{index[link.peer], link.port} : PortLink(); };
+
+            writer.add(Section::Globals, GlobalsRecord{sim::now(), noise::seed(), noise::streamsUsed(), (uint8_t)EthernetPeer::dispatchMode()});
+
+            for (uint32_t i = 0; i < peers.size(); i++)
+            {
+                EthernetPeer *peer = peers[i];
+                std::span<PortLink> ports = peer->ports();
+                PeerRecord record = {};
+                record.kind = topology.kind(peer->m_Id);
+                record.errorControl = (uint8_t)peer->m_ErrorControlType;
+                record.ports = (uint16_t)ports.size();
+                record.timing = peer->m_LinkTiming;
+
+                Host *host = record.kind == PeerKind::Host ? static_cast<Host *>(peer) : nullptr;
+                Switch *sw = record.kind == PeerKind::Switch ? static_cast<Switch *>(peer) : nullptr;
+                if (host)
+                {
+                    record.promiscuous = host->m_PromiscuousMode;
+                    record.mac = host->m_MAC.bytes;
+                    for (uint64_t group : host->m_Groups)
+                        writer.add(Section::HostGroups, HostGroupRecord{i, group});
+                }
+                if (sw)
+                {
+                    record.switchingMode = (uint8_t)sw->m_SwitchingMode;
+                    record.queues = !sw->m_EgressQueues.empty();
+                    record.tableSize = sw->MAX_TABLE_SIZE;
+                    record.floodStamp = sw->m_FloodStamp;
+                    saveSwitch(writer, i, *sw);
+                }
+                writer.add(Section::Peers, record);
+
+                for (size_t port = 0; port < ports.size(); port++)
+                {
+                    const noise::NoiseModel &noise = peer->m_Noise[port];
+                    PortRecord p = {remap(ports[port]), 0, DEFAULT_VLAN, noise.m_BitErrorRate, noise.m_Rng, noise.m_BitsUntilError};
+                    if (sw)
+                    {
+                        p.trunk = sw->m_PortVlans[port].trunk;
+                        p.pvid = sw->m_PortVlans[port].pvid;
+                    }
+                    writer.add(Section::Ports, p);
+                }
+            }
+
+            //Frames going to a removed peer would be dropped on arrival anyway
+            for (const WireFrame &wire : EthernetPeer::framesInFlight())
+                if (index[wire.link.peer] != NO_PEER)
+                    writer.add(Section::Wire, WireRecord{remap(wire.link), wire.frame});
+
+            return writer.write(path);
+        }
+
+        static void saveSwitch(Writer &writer, uint32_t i, Switch &sw)
+        {
+            for (const auto &[key, entry] : sw.m_SwitchTable)
+                writer.add(Section::MacTable, MacTableRecord{i, key, entry});
+
+            for (const auto &[group, entry] : sw.m_GroupTable)
+            {
+                writer.add(Section::GroupPorts, GroupPortRecord{i, NO_PORT_RECORD, 0, group.bytes});
+                entry.ports.forEach([&](size_t port) {
+                    writer.add(Section::GroupPorts, GroupPortRecord{i, (uint16_t)port, entry.staticPorts.test(port), group.bytes});
+                });
+            }
+
+            for (const auto &[vid, ports] : sw.m_VlanPorts)
+            {
+                writer.add(Section::VlanPorts, VlanPortRecord{i, vid, NO_PORT_RECORD});
+                ports.forEach([&](size_t port) { writer.add(Section::VlanPorts, VlanPortRecord{i, vid, (uint16_t)port}); });
+            }
+
+            for (size_t lag = 0; lag < sw.m_Lags.size(); lag++)
+                for (uint16_t port : sw.m_Lags[lag].members)
+                    writer.add(Section::LagMembers, LagMemberRecord{i, (uint16_t)lag, port, sw.m_Lags[lag].floodStamp});
+
+            for (size_t port = 0; port < sw.m_EgressQueues.size(); port++)
+            {
+                const queueing::EgressQueue &queue = sw.m_EgressQueues[port];
+                QueueRecord record = {i, (uint16_t)port, queue.m_Config};
+                std::copy(std::begin(queue.m_Average), std::end(queue.m_Average), record.average);
+                std::copy(std::begin(queue.m_Deficit), std::end(queue.m_Deficit), record.deficit);
+                record.cursor = queue.m_Cursor;
+                record.visited = queue.m_Visited;
+                record.rng = queue.m_Rng;
+                record.busyUntil = queue.busyUntil;
+                record.serviceAt = queue.serviceAt;
+                writer.add(Section::Queues, record);
+
+                for (unsigned cls = 0; cls < queueing::CLASSES; cls++)
+                    for (const Ether2Frame &frame : queue.m_Queues[cls])
+                        writer.add(Section::QueuedFrames, QueuedFrameRecord{i, (uint16_t)port, (uint8_t)cls, frame});
+            }
+        }
+
+        static Fabric restore(const std::string &path)
+        {
+            Topology &topology = Topology::global();
+            if (topology.size() != 0)
+                throw std::runtime_error("A checkpoint can only be restored into an empty topology");
+
+            Mapping mapping(path);
+            std::span<const GlobalsRecord> globals = mapping.section<GlobalsRecord>(Section::Globals);
+            std::span<const PeerRecord> peerRecords = mapping.section<PeerRecord>(Section::Peers);
+            std::span<const PortRecord> portRecords = mapping.section<PortRecord>(Section::Ports);
+            if (globals.size() != 1)
+                throw std::runtime_error("'" + path + "' is not a valid checkpoint");
+
+            size_t portCount = 0;
+            for (const PeerRecord &record : peerRecords)
+                portCount += record.ports;
+            if (portCount != portRecords.size())
+                throw std::runtime_error("'" + path + "' is not a valid checkpoint");
+
+            //Only the events recreated below remain (applications are started again by the caller)
+            sim::reset();
+
+            Fabric fabric;
+            fabric.peers.reserve(peerRecords.size());
+            std::vector<Switch *> switches(peerRecords.size(), nullptr);
+            std::vector<Host *> hosts(peerRecords.size(), nullptr);
+            for (size_t i = 0; i < peerRecords.size(); i++)
+            {
+                const PeerRecord &record = peerRecords[i];
+                ERROR_CONTROL ect = (ERROR_CONTROL)record.errorControl;
+                if (record.kind == PeerKind::Host)
+                {
+                    Ref<Host> host = std::make_shared<Host>(MAC(record.mac), ect, record.ports);
+                    host->m_PromiscuousMode = record.promiscuous;
+                    hosts[i] = host.get();
+                    fabric.peers.push_back(host);
+                }
+                else if (record.kind == PeerKind::Switch)
+                {
+                    Ref<Switch> sw = std::make_shared<Switch>(ect, record.ports, (size_t)record.tableSize);
+                    sw->m_SwitchingMode = (SwitchingMode)record.switchingMode;
+                    sw->m_FloodStamp = record.floodStamp;
+                    sw->m_VlanPorts.clear();
+                    switches[i] = sw.get();
+                    fabric.peers.push_back(sw);
+                }
+                else
+                    throw std::runtime_error("'" + path + "' has a peer kind that cannot be restored");
+                fabric.peers.back()->m_LinkTiming = record.timing;
+            }
+
+            //Ports: links (each one connected from its lower end), VLAN of the port and noise state of its egress
+            const PortRecord *port = portRecords.data();
+            for (size_t i = 0; i < peerRecords.size(); i++)
+            {
+                EthernetPeer &peer = *fabric.peers[i];
+                for (uint16_t p = 0; p < peerRecords[i].ports; p++, port++)
+                {
+                    const PortLink &link = port->link;
+                    if (link.connected())
+                    {
+                        if (link.peer >= peerRecords.size() || link.port >= peerRecords[link.peer].ports)
+                            throw std::runtime_error("'" + path + "' has a link to a port that does not exist");
+                        if (std::make_pair(link.peer, link.port) > std::make_pair((PeerId)i, p))
+                            topology.connect(fabric.peers[i]->m_Id, p, fabric.peers[link.peer]->m_Id, link.port);
+                    }
+                    if (switches[i])
+                        switches[i]->m_PortVlans[p] = PortVlan{port->trunk != 0, port->pvid};
+
+                    noise::NoiseModel &noise = peer.m_Noise[p];
+                    noise = noise::NoiseModel(port->bitErrorRate, port->rng);
+                    noise.m_Rng = port->rng;
+                    noise.m_BitsUntilError = port->bitsUntilError;
+                }
+            }
+
+            for (const HostGroupRecord &record : mapping.section<HostGroupRecord>(Section::HostGroups))
+                peerAt(hosts, record.peer, path)->m_Groups.insert(record.group);
+
+            forEachPeerRun(mapping.section<MacTableRecord>(Section::MacTable), [&](uint32_t peer, std::span<const MacTableRecord> records) {
+                Switch *sw = peerAt(switches, peer, path);
+                SwitchTable &table = sw->m_SwitchTable;
+                table.reserve(table.size() + records.size());
+                for (const MacTableRecord &record : records)
+                {
+                    if (record.entry.interface >= sw->m_PortLag.size())
+                        throw std::runtime_error("'" + path + "' has a MAC table entry on a port that does not exist");
+                    table.emplace(record.key, record.entry);
+                }
+                sw->m_Metrics.table.entries.set(table.size());
+            });
+
+            for (const GroupPortRecord &record : mapping.section<GroupPortRecord>(Section::GroupPorts))
+            {
+                Switch *sw = peerAt(switches, record.peer, path);
+                if (record.port != NO_PORT_RECORD && record.port >= sw->m_PortLag.size())
+                    throw std::runtime_error("'" + path + "' has a group port that does not exist");
+                GroupEntry &entry = sw->m_GroupTable[MAC(record.group)];
+                if (record.port == NO_PORT_RECORD)
+                    continue;
+                entry.ports.set(record.port);
+                if (record.isStatic)
+                    entry.staticPorts.set(record.port);
+            }
+
+            for (const VlanPortRecord &record : mapping.section<VlanPortRecord>(Section::VlanPorts))
+            {
+                Switch *sw = peerAt(switches, record.peer, path);
+                if (record.port != NO_PORT_RECORD && record.port >= sw->m_PortLag.size())
+                    throw std::runtime_error("'" + path + "' has a VLAN port that does not exist");
+                PortMask &ports = sw->m_VlanPorts[record.vid];
+                if (record.port != NO_PORT_RECORD)
+                    ports.set(record.port);
+            }
+
+            for (const LagMemberRecord &record : mapping.section<LagMemberRecord>(Section::LagMembers))
+            {
+                Switch *sw = peerAt(switches, record.peer, path);
+                if (record.port >= sw->m_PortLag.size())
+                    throw std::runtime_error("'" + path + "' has a LAG member that does not exist");
+                if (record.lag >= sw->m_Lags.size())
+                    sw->m_Lags.resize(record.lag + 1);
+                sw->m_Lags[record.lag].members.push_back(record.port);
+                sw->m_Lags[record.lag].floodStamp = record.floodStamp;
+                sw->m_PortLag[record.port] = record.lag;
+            }
+
+            restoreQueues(mapping, switches, path);
+
+            //Every event is scheduled again at its time, after the clock is back where it was
+            const GlobalsRecord &g = globals[0];
+            sim::advanceTo(g.now);
+            noise::setStreams(g.seed, g.streamsUsed);
+            EthernetPeer::setDispatchMode((DispatchMode)g.dispatchMode);
+
+            for (Switch *sw : switches)
+                if (sw)
+                    sw->resumeQueues();
+            for (const WireRecord &record : mapping.section<WireRecord>(Section::Wire))
+            {
+                if (record.link.peer >= fabric.peers.size() || record.link.port >= fabric.peers[record.link.peer]->ports().size())
+                    throw std::runtime_error("'" + path + "' has a frame in flight to a peer that does not exist");
+                EthernetPeer::putInFlight({fabric.peers[record.link.peer]->m_Id, record.link.port}, record.frame);
+            }
+
+            return fabric;
+        }
+
+        static void restoreQueues(const Mapping &mapping, const std::vector<Switch *> &switches, const std::string &path)
+        {
+            for (const QueueRecord &record : mapping.section<QueueRecord>(Section::Queues))
+            {
+                Switch *sw = peerAt(switches, record.peer, path);
+                if (record.port != sw->m_EgressQueues.size() || record.port >= sw->m_PortVlans.size())
+                    throw std::runtime_error("'" + path + "' has egress queues out of order");
+
+                queueing::EgressQueue &queue = sw->m_EgressQueues.emplace_back(record.config, record.rng);
+                std::copy(std::begin(record.average), std::end(record.average), queue.m_Average);
+                std::copy(std::begin(record.deficit), std::end(record.deficit), queue.m_Deficit);
+                queue.m_Cursor = record.cursor;
+                queue.m_Visited = record.visited;
+                queue.busyUntil = record.busyUntil;
+                queue.serviceAt = record.serviceAt;
+            }
+
+            for (const QueuedFrameRecord &record : mapping.section<QueuedFrameRecord>(Section::QueuedFrames))
+            {
+                Switch *sw = peerAt(switches, record.peer, path);
+                if (record.port >= sw->m_EgressQueues.size() || record.cls >= queueing::CLASSES)
+                    throw std::runtime_error("'" + path + "' has a queued frame in a queue that does not exist");
+                queueing::EgressQueue &queue = sw->m_EgressQueues[record.port];
+                queue.m_Queues[record.cls].push_back(record.frame);
+                queue.m_Size++;
+            }
+        }
+
+        //Peer of a record, checked against the kind the record belongs to
+        template <class T>
+        static T *peerAt(const std::vector<T *> &peers, uint32_t i, const std::string &path)
+        {
+            if (i >= peers.size() || !peers[i])
+                throw std::runtime_error("'" + path + "' has a record for a peer of another kind");
+            return peers[i];
+        }
+    };
+
+    size_t save(const std::string &path) { return Access::save(path); }
+
+    Fabric restore(const std::string &path) { return Access::restore(path); }
+}
@@ -0,0 +1,68 @@
+/**
+ * Header criado para salvar o estado de uma simulação aquecida e restaurá-lo rapidamente
+ *
+ * O checkpoint guarda a topologia (peers, portas e enlaces), o relógio simulado, os fluxos aleatórios
+ * (global, do ruído de cada enlace e do RED de cada fila), as tabelas dos switches (MACs, grupos, VLANs, LAGs),
+ * as filas de saída com seus frames e os frames em trânsito nos enlaces. Um experimento aquece a rede uma vez,
+ * salva, e cada ponto de uma varredura de parâmetros parte do mesmo estado em vez de simular o aquecimento de novo:
+ *
+ *   checkpoint::save("warm.ckpt");
+ *   ...
+ *   checkpoint::Fabric fabric = checkpoint::restore("warm.ckpt");
+ *   Ref<Switch> core = fabric.get<Switch>(0);
+ *
+ * O arquivo é binário e versionado: um cabeçalho, uma tabela de seções e, em cada seção, um vetor de registros
+ * de tamanho fixo. A restauração mapeia o arquivo (mmap) e lê os registros direto da memória, sem interpretar texto.
+ *
+ * Não fazem parte do checkpoint: as corrotinas (sim::Task) e os demais eventos agendados por aplicações
+ * (elas são iniciadas de novo depois da restauração), os contadores/histogramas de métricas e peers
+ * de tipos fora do conjunto embutido (Host e Switch), como shm::Link.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "peers.hpp"
+#include "types.hpp"
+
+namespace checkpoint
+{
+    //Versão do formato (arquivos de outra versão são recusados)
+    constexpr uint32_t VERSION = 2;
+
+    //Peers recriados por restore, na ordem dos seus identificadores quando o checkpoint foi salvo
+    struct Fabric
+    {
+        std::vector<Ref<EthernetPeer>> peers;
+
+        //Peer de índice i com o seu tipo concreto (nullptr se o tipo for outro)
+        template <class T>
+        Ref<T> get(size_t i) const { return std::dynamic_pointer_cast<T>(peers.at(i)); }
+    };
+
+    /**
+     * Método que salva o estado da simulação atual (fora de sim::run)
+     *
+     * Parâmetros: const std::string &path	=>	Arquivo de destino (substituído por inteiro, nunca pela metade)
+     *
+     * Retorno: size_t	=>	Tamanho do arquivo em bytes
+     */
+    size_t save(const std::string &path);
+
+    /**
+     * Método que restaura uma simulação salva: reinicia o relógio (sim::reset), recria os peers e agenda de novo
+     * os frames em trânsito e o serviço das filas. A topologia precisa estar vazia.
+     *
+     * Parâmetros: const std::string &path	=>	Arquivo gerado por save
+     *
+     * Retorno: Fabric	=>	Peers restaurados (ficam vivos enquanto houver referências a eles)
+     */
+    Fabric restore(const std::string &path);
+
+    //Acesso ao estado interno dos peers, do ruído e das filas (usado só por save/restore)
+    struct Access;
+}
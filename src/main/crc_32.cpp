@@ -1,8 +1,20 @@
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 
 #include "crc_32.hpp"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+#include <smmintrin.h>
+#define NLS_HAS_SSE42_CRC 1
+#define NLS_HAS_PCLMUL_CRC 1
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 
 typedef uint32_t crc;
@@ -44,10 +56,476 @@ uint32_t update(uint32_t (&table)[1500], uint32_t initial, const void* buf, size
 	return c ^ 0xFFFFFFFF;
 }
 
+/**
+ * Tabelas do "slicing-by-8": tables[k][b] é o CRC do byte b seguido de k bytes nulos,
+ * o que permite consumir 8 bytes por iteração com 8 consultas independentes.
+ * São geradas uma única vez (antes eram recalculadas a cada chamada de CRC32).
+ */
+struct SlicingTables
+{
+	uint32_t t[8][256];
+
+	//polynomial: polinômio refletido (0xEDB88320 para o CRC-32 IEEE, 0x82F63B78 para o CRC-32C)
+	SlicingTables(uint32_t polynomial)
+	{
+		for (uint32_t b = 0; b < 256; b++)
+		{
+			uint32_t c = b;
+			for (size_t j = 0; j < 8; j++)
+				c = (c & 1) ? polynomial ^ (c >> 1) : c >> 1;
+			t[0][b] = c;
+		}
+		for (int k = 1; k < 8; k++)
+			for (int b = 0; b < 256; b++)
+				t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFF];
+	}
+};
+
+static const SlicingTables &slicingTables()
+{
+	static const SlicingTables tables(0xEDB88320);
+	return tables;
+}
+
+//Consome 8 bytes de um fluxo de CRC (registrador 'c' já invertido)
+static inline uint32_t crcStep8(const SlicingTables &T, uint32_t c, const uint8_t* u)
+{
+	uint64_t word;
+	memcpy(&word, u, 8);
+	word ^= c;
+	return T.t[7][word & 0xFF] ^ T.t[6][(word >> 8) & 0xFF] ^ T.t[5][(word >> 16) & 0xFF] ^ T.t[4][(word >> 24) & 0xFF] ^
+		   T.t[3][(word >> 32) & 0xFF] ^ T.t[2][(word >> 40) & 0xFF] ^ T.t[1][(word >> 48) & 0xFF] ^ T.t[0][word >> 56];
+}
+
+static inline uint32_t crcStep1(const SlicingTables &T, uint32_t c, uint8_t byte)
+{
+	return T.t[0][(c ^ byte) & 0xFF] ^ (c >> 8);
+}
+
+static uint32_t crc32Software(const uint8_t* u, size_t len, uint32_t c = 0xFFFFFFFF)
+{
+	const SlicingTables &T = slicingTables();
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8)
+		c = crcStep8(T, c, u + i);
+	for (; i < len; i++)
+		c = crcStep1(T, c, u[i]);
+	return c ^ 0xFFFFFFFF;
+}
+
+#ifdef NLS_HAS_PCLMUL_CRC
+//Advances 'acc' by 128 bits (multiplying by the constants in 'k') and adds the next block
+__attribute__((target("pclmul,sse4.1"))) static inline __m128i fold128(__m128i acc, __m128i next, __m128i k)
+{
+	return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(acc, k, 0x11), _mm_clmulepi64_si128(acc, k, 0x00)), next);
+}
+
+/**
+ * Dobra ("folding") com multiplicação sem carry (PCLMULQDQ), como no artigo da Intel "Fast CRC Computation for
+ * Generic Polynomials Using PCLMULQDQ Instruction": 4 registradores de 128 bits avançam 64 bytes por iteração,
+ * multiplicando o estado por x^(512±64) mod P e somando (XOR) o próximo bloco; no fim, os 4 são dobrados em um
+ * e reduzidos a 32 bits (Barrett). Constantes do polinômio refletido 0xEDB88320.
+ *
+ * 'len' precisa ser múltiplo de 16 e ao menos 64; retorna o registrador do CRC (sem a inversão final)
+ */
+__attribute__((target("pclmul,sse4.1"))) static uint32_t crc32Fold(const uint8_t* u, size_t len, uint32_t c)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+	const __m128i k5 = _mm_set_epi64x(0, 0x0163cd6124);
+	const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+	const __m128i low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+	__m128i x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(u + 0x00)), _mm_cvtsi32_si128((int)c));
+	__m128i x2 = _mm_loadu_si128((const __m128i *)(u + 0x10));
+	__m128i x3 = _mm_loadu_si128((const __m128i *)(u + 0x20));
+	__m128i x4 = _mm_loadu_si128((const __m128i *)(u + 0x30));
+	u += 64;
+	len -= 64;
+
+	for (; len >= 64; u += 64, len -= 64)
+	{
+		__m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00), x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+		__m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00), x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(u + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(u + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(u + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(u + 0x30)));
+	}
+
+	//Four lanes into one, then the remaining 16-byte blocks
+	x1 = fold128(fold128(fold128(x1, x2, k3k4), x3, k3k4), x4, k3k4);
+	for (; len >= 16; u += 16, len -= 16)
+		x1 = fold128(x1, _mm_loadu_si128((const __m128i *)u), k3k4);
+
+	//128 -> 64 bits
+	x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, low32), k5, 0x00), x2);
+
+	//Barrett reduction to 32 bits
+	x2 = _mm_and_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, low32), poly, 0x10), low32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+	return (uint32_t)_mm_extract_epi32(_mm_xor_si128(x1, x2), 1);
+}
+#endif
+
+bool CRC32Hardware()
+{
+#ifdef NLS_HAS_PCLMUL_CRC
+	static const bool supported = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+	return supported;
+#else
+	return false;
+#endif
+}
+
 uint32_t CRC32(const void* buf, size_t len) {
-	uint32_t table[1500];
-	generate_table(table);
-	return update(table, 0, buf, len);
+	const uint8_t* u = static_cast<const uint8_t*>(buf);
+#ifdef NLS_HAS_PCLMUL_CRC
+	if (len >= 64 && CRC32Hardware())
+	{
+		size_t folded = len & ~(size_t)15;
+		return crc32Software(u + folded, len - folded, crc32Fold(u, folded, 0xFFFFFFFF));
+	}
+#endif
+	return crc32Software(u, len);
+}
+
+void CRC32Multi(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out)
+{
+#ifdef NLS_HAS_PCLMUL_CRC
+	//Each buffer already runs 4 independent folding lanes, enough to keep the multiplier busy
+	if (len >= 64 && CRC32Hardware())
+	{
+		for (size_t f = 0; f < count; f++)
+			out[f] = CRC32(bufs[f], len);
+		return;
+	}
+#endif
+	const SlicingTables &T = slicingTables();
+
+	size_t f = 0;
+	for (; f + 4 <= count; f += 4)
+	{
+		const uint8_t *b0 = bufs[f], *b1 = bufs[f + 1], *b2 = bufs[f + 2], *b3 = bufs[f + 3];
+		uint32_t c0 = 0xFFFFFFFF, c1 = 0xFFFFFFFF, c2 = 0xFFFFFFFF, c3 = 0xFFFFFFFF;
+
+		size_t i = 0;
+		for (; i + 8 <= len; i += 8)
+		{
+			c0 = crcStep8(T, c0, b0 + i);
+			c1 = crcStep8(T, c1, b1 + i);
+			c2 = crcStep8(T, c2, b2 + i);
+			c3 = crcStep8(T, c3, b3 + i);
+		}
+		for (; i < len; i++)
+		{
+			c0 = crcStep1(T, c0, b0[i]);
+			c1 = crcStep1(T, c1, b1[i]);
+			c2 = crcStep1(T, c2, b2[i]);
+			c3 = crcStep1(T, c3, b3[i]);
+		}
+
+		out[f] = c0 ^ 0xFFFFFFFF;
+		out[f + 1] = c1 ^ 0xFFFFFFFF;
+		out[f + 2] = c2 ^ 0xFFFFFFFF;
+		out[f + 3] = c3 ^ 0xFFFFFFFF;
+	}
+
+	for (; f < count; f++)
+		out[f] = crc32Software(bufs[f], len);
+}
+
+/****************************************** CRC-32C ****************************************/
+
+static const SlicingTables &castagnoliTables()
+{
+	static const SlicingTables tables(0x82F63B78);
+	return tables;
+}
+
+static uint32_t crc32cSoftware(const uint8_t* u, size_t len)
+{
+	const SlicingTables &T = castagnoliTables();
+	uint32_t c = 0xFFFFFFFF;
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8)
+		c = crcStep8(T, c, u + i);
+	for (; i < len; i++)
+		c = crcStep1(T, c, u[i]);
+	return c ^ 0xFFFFFFFF;
+}
+
+#ifdef NLS_HAS_SSE42_CRC
+__attribute__((target("sse4.2"))) static uint32_t crc32cHardware(const uint8_t* u, size_t len)
+{
+	uint64_t c = 0xFFFFFFFF;
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, u + i, 8);
+		c = _mm_crc32_u64(c, word);
+	}
+	uint32_t c32 = (uint32_t)c;
+	for (; i < len; i++)
+		c32 = _mm_crc32_u8(c32, u[i]);
+	return c32 ^ 0xFFFFFFFF;
+}
+
+//The crc32 instruction has a latency of 3 cycles but a throughput of 1 per cycle, so 4 independent streams keep it busy
+__attribute__((target("sse4.2"))) static void crc32cHardwareMulti(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out)
+{
+	size_t f = 0;
+	for (; f + 4 <= count; f += 4)
+	{
+		const uint8_t *b0 = bufs[f], *b1 = bufs[f + 1], *b2 = bufs[f + 2], *b3 = bufs[f + 3];
+		uint64_t c0 = 0xFFFFFFFF, c1 = 0xFFFFFFFF, c2 = 0xFFFFFFFF, c3 = 0xFFFFFFFF;
+
+		size_t i = 0;
+		for (; i + 8 <= len; i += 8)
+		{
+			uint64_t w0, w1, w2, w3;
+			memcpy(&w0, b0 + i, 8);
+			memcpy(&w1, b1 + i, 8);
+			memcpy(&w2, b2 + i, 8);
+			memcpy(&w3, b3 + i, 8);
+			c0 = _mm_crc32_u64(c0, w0);
+			c1 = _mm_crc32_u64(c1, w1);
+			c2 = _mm_crc32_u64(c2, w2);
+			c3 = _mm_crc32_u64(c3, w3);
+		}
+		for (; i < len; i++)
+		{
+			c0 = _mm_crc32_u8((uint32_t)c0, b0[i]);
+			c1 = _mm_crc32_u8((uint32_t)c1, b1[i]);
+			c2 = _mm_crc32_u8((uint32_t)c2, b2[i]);
+			c3 = _mm_crc32_u8((uint32_t)c3, b3[i]);
+		}
+
+		out[f] = (uint32_t)c0 ^ 0xFFFFFFFF;
+		out[f + 1] = (uint32_t)c1 ^ 0xFFFFFFFF;
+		out[f + 2] = (uint32_t)c2 ^ 0xFFFFFFFF;
+		out[f + 3] = (uint32_t)c3 ^ 0xFFFFFFFF;
+	}
+
+	for (; f < count; f++)
+		out[f] = crc32cHardware(bufs[f], len);
+}
+#endif
+
+bool CRC32CHardware()
+{
+#ifdef NLS_HAS_SSE42_CRC
+	static const bool supported = __builtin_cpu_supports("sse4.2");
+	return supported;
+#else
+	return false;
+#endif
+}
+
+uint32_t CRC32C(const void* buf, size_t len)
+{
+	const uint8_t* u = static_cast<const uint8_t*>(buf);
+#ifdef NLS_HAS_SSE42_CRC
+	if (CRC32CHardware())
+		return crc32cHardware(u, len);
+#endif
+	return crc32cSoftware(u, len);
+}
+
+void CRC32CMulti(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out)
+{
+#ifdef NLS_HAS_SSE42_CRC
+	if (CRC32CHardware())
+	{
+		crc32cHardwareMulti(bufs, count, len, out);
+		return;
+	}
+#endif
+	for (size_t f = 0; f < count; f++)
+		out[f] = crc32cSoftware(bufs[f], len);
+}
+
+/*********************************** Somas (Fletcher, Adler, Internet) ***********************************/
+
+/**
+ * As três somas são vetorizadas do mesmo jeito: o buffer é lido em blocos de 16 elementos (bytes ou palavras
+ * de 16 bits), alargados para 16 pistas de 32 bits. Por pista, 'acc' guarda a soma dos elementos e 'running'
+ * a soma acumulada de 'acc' a cada bloco, de onde saem a soma simples e a soma ponderada pela posição
+ * (a segunda soma de Fletcher/Adler) sem nenhuma dependência entre pistas.
+ */
+static constexpr size_t SUM_LANES = 16;
+//Chunks per block: keeps every 32-bit lane of 'running' below 2^32 for 16-bit elements (65535 * 256 * 257 / 2)
+static constexpr size_t SUM_BLOCK_CHUNKS = 256;
+
+/**
+ * Soma 'chunks' blocos de 16 elementos do tipo T (no máximo SUM_BLOCK_CHUNKS)
+ *
+ * Retorno: sum		=>	soma dos elementos
+ * 			weighted	=>	soma de (n - i) * elemento i, com n = chunks * 16 (apenas se Weighted)
+ */
+template <class T, bool Weighted>
+static void blockSums(const uint8_t* p, size_t chunks, uint64_t &sum, uint64_t &weighted)
+{
+	uint32_t acc[SUM_LANES], running[SUM_LANES];
+
+#ifdef __SSE2__
+	//Lanes are kept as 4 vectors of 4 (a0 holds elements 0..3 of every chunk, a1 holds 4..7...), all in registers
+	const __m128i zero = _mm_setzero_si128();
+	__m128i a0 = zero, a1 = zero, a2 = zero, a3 = zero;
+	__m128i r0 = zero, r1 = zero, r2 = zero, r3 = zero;
+	for (size_t j = 0; j < chunks; j++)
+	{
+		__m128i lo, hi;
+		if constexpr (sizeof(T) == 1)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i *)(p + j * SUM_LANES));
+			lo = _mm_unpacklo_epi8(v, zero);
+			hi = _mm_unpackhi_epi8(v, zero);
+		}
+		else
+		{
+			lo = _mm_loadu_si128((const __m128i *)(p + j * SUM_LANES * 2));
+			hi = _mm_loadu_si128((const __m128i *)(p + j * SUM_LANES * 2 + 16));
+		}
+		a0 = _mm_add_epi32(a0, _mm_unpacklo_epi16(lo, zero));
+		a1 = _mm_add_epi32(a1, _mm_unpackhi_epi16(lo, zero));
+		a2 = _mm_add_epi32(a2, _mm_unpacklo_epi16(hi, zero));
+		a3 = _mm_add_epi32(a3, _mm_unpackhi_epi16(hi, zero));
+		if (Weighted)
+		{
+			r0 = _mm_add_epi32(r0, a0);
+			r1 = _mm_add_epi32(r1, a1);
+			r2 = _mm_add_epi32(r2, a2);
+			r3 = _mm_add_epi32(r3, a3);
+		}
+	}
+	_mm_storeu_si128((__m128i *)(acc + 0), a0);
+	_mm_storeu_si128((__m128i *)(acc + 4), a1);
+	_mm_storeu_si128((__m128i *)(acc + 8), a2);
+	_mm_storeu_si128((__m128i *)(acc + 12), a3);
+	_mm_storeu_si128((__m128i *)(running + 0), r0);
+	_mm_storeu_si128((__m128i *)(running + 4), r1);
+	_mm_storeu_si128((__m128i *)(running + 8), r2);
+	_mm_storeu_si128((__m128i *)(running + 12), r3);
+#else
+	for (size_t l = 0; l < SUM_LANES; l++)
+		acc[l] = running[l] = 0;
+	for (size_t j = 0; j < chunks; j++)
+		for (size_t l = 0; l < SUM_LANES; l++)
+		{
+			T e;
+			memcpy(&e, p + (j * SUM_LANES + l) * sizeof(T), sizeof(T));
+			acc[l] += e;
+			if (Weighted)
+				running[l] += acc[l];
+		}
+#endif
+
+	//Element (chunk j, lane l) has weight 16 * (chunks - j) - l
+	sum = weighted = 0;
+	for (size_t l = 0; l < SUM_LANES; l++)
+	{
+		sum += acc[l];
+		if (Weighted)
+			weighted += SUM_LANES * (uint64_t)running[l] - l * (uint64_t)acc[l];
+	}
+}
+
+uint32_t Fletcher32(const void* buf, size_t len)
+{
+	const uint8_t* u = static_cast<const uint8_t*>(buf);
+	const size_t words = len / 2;
+	uint64_t c0 = 0, c1 = 0;
+
+	size_t w = 0;
+	while (words - w >= SUM_LANES)
+	{
+		size_t chunks = std::min((words - w) / SUM_LANES, SUM_BLOCK_CHUNKS), n = chunks * SUM_LANES;
+		uint64_t sum, weighted;
+		blockSums<uint16_t, true>(u + w * 2, chunks, sum, weighted);
+		c1 = (c1 + n * c0 + weighted) % 65535;
+		c0 = (c0 + sum) % 65535;
+		w += n;
+	}
+	//Fewer than 16 words are left, so the sums cannot overflow before the final reduction
+	for (; w < words; w++)
+	{
+		c0 += (uint16_t)(u[2 * w] | u[2 * w + 1] << 8);
+		c1 += c0;
+	}
+	//An odd trailing byte is padded with zero
+	if (len % 2)
+	{
+		c0 += u[len - 1];
+		c1 += c0;
+	}
+	c0 %= 65535;
+	c1 %= 65535;
+
+	return (uint32_t)(c1 << 16 | c0);
+}
+
+uint32_t Adler32(const void* buf, size_t len)
+{
+	const uint8_t* u = static_cast<const uint8_t*>(buf);
+	const uint64_t MOD = 65521;
+	uint64_t a = 1, b = 0;
+
+	size_t i = 0;
+	while (len - i >= SUM_LANES)
+	{
+		size_t chunks = std::min((len - i) / SUM_LANES, SUM_BLOCK_CHUNKS), n = chunks * SUM_LANES;
+		uint64_t sum, weighted;
+		blockSums<uint8_t, true>(u + i, chunks, sum, weighted);
+		b = (b + n * a + weighted) % MOD;
+		a = (a + sum) % MOD;
+		i += n;
+	}
+	for (; i < len; i++)
+	{
+		a += u[i];
+		b += a;
+	}
+	a %= MOD;
+	b %= MOD;
+
+	return (uint32_t)(b << 16 | a);
+}
+
+uint32_t InternetChecksum(const void* buf, size_t len)
+{
+	const uint8_t* u = static_cast<const uint8_t*>(buf);
+	const size_t words = len / 2;
+
+	//Ones' complement addition is byte order independent: words are summed in little endian and swapped at the end
+	uint64_t total = 0;
+	size_t w = 0;
+	while (words - w >= SUM_LANES)
+	{
+		size_t chunks = std::min((words - w) / SUM_LANES, SUM_BLOCK_CHUNKS);
+		uint64_t sum, unused;
+		blockSums<uint16_t, false>(u + w * 2, chunks, sum, unused);
+		total += sum;
+		w += chunks * SUM_LANES;
+	}
+	for (; w < words; w++)
+		total += (uint16_t)(u[2 * w] | u[2 * w + 1] << 8);
+	if (len % 2)
+		total += u[len - 1];
+
+	while (total >> 16)
+		total = (total & 0xFFFF) + (total >> 16);
+
+	uint16_t checksum = (uint16_t)~total;
+	return (uint32_t)(uint16_t)(checksum << 8 | checksum >> 8);
 }
 
 /**************************************************** Paridade **********************************/
@@ -67,9 +545,31 @@ unsigned int countBits(const void* buf, size_t len){
 	return num_bits;
 }
 
+uint8_t parity(const void* buf, size_t len){
+	const uint8_t* u = static_cast<const uint8_t*>(buf);
+
+	//XOR preserves the parity of the number of set bits, so the buffer is folded into one word first
+	uint64_t acc[4] = {0, 0, 0, 0};
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32)
+	{
+		uint64_t w[4];
+		memcpy(w, u + i, 32);
+		acc[0] ^= w[0];
+		acc[1] ^= w[1];
+		acc[2] ^= w[2];
+		acc[3] ^= w[3];
+	}
+
+	uint64_t folded = acc[0] ^ acc[1] ^ acc[2] ^ acc[3];
+	for (; i < len; i++)
+		folded ^= u[i];
+	return (uint8_t)__builtin_parityll(folded);
+}
+
 uint8_t paridadePar (const void* buf, size_t len){
 
-	int num_bits = countBits(buf, len);
+	int num_bits = parity(buf, len);
 	//Par
 	if(num_bits%2 == 0)
 	{
@@ -85,7 +585,7 @@ uint8_t paridadePar (const void* buf, size_t len){
 
 uint8_t paridadeImpar(const void* buf, size_t len){
 
-	int num_bits = countBits(buf, len);
+	int num_bits = parity(buf, len);
 
 	//Par
 	if(num_bits%2 == 0)
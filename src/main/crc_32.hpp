@@ -1,10 +1,14 @@
 /**
  * Header auxiliar que contém as definições das checagens de consistência da mensagem enviada
  * 
- * Possui 3 (três) tipos de checage,:
- * 	- CRC-32
+ * Possui 7 (sete) tipos de checagem:
+ * 	- CRC-32, com dobras pela instrução PCLMULQDQ quando disponível
  *  - Paridade de bits par
  *  - Paridade de bits impar
+ *  - CRC-32C (Castagnoli), com a instrução crc32 do SSE4.2 quando disponível
+ *  - Fletcher-32
+ *  - Adler-32
+ *  - Checksum da Internet (RFC 1071)
  */
 #pragma once
 
@@ -53,6 +57,78 @@ uint32_t update(uint32_t(&table)[1500], uint32_t initial, const void* buf, size_
  */
 uint32_t CRC32(const void* buf, size_t len);
 
+/**
+ * Método que retorna se o CRC-32 é calculado por dobras com a instrução PCLMULQDQ (checado uma vez, na CPU atual);
+ * caso contrário é usada a versão por tabelas (slicing-by-8)
+ */
+bool CRC32Hardware();
+
+/**
+ * Método que calcula o CRC-32 de vários buffers de mesmo tamanho de uma só vez (multi-buffer)
+ * 
+ * Com PCLMULQDQ, cada buffer é dobrado em 4 pistas de 128 bits (o paralelismo já está dentro de um buffer).
+ * Sem ela, os buffers são processados de 4 em 4 com os laços de tabela intercalados: como as 4 cadeias de
+ * dependência são independentes, a latência das consultas à tabela de uma é escondida pelas outras.
+ * 
+ * Parâmetros:	const uint8_t *const *bufs	=>	Vetor de ponteiros para os buffers
+ * 				size_t count				=>	Quantidade de buffers
+ * 				size_t len					=>	Tamanho de cada buffer
+ * 				uint32_t *out				=>	Vetor (de tamanho count) que recebe os CRCs
+ * 
+ * Retorno: void
+ */
+void CRC32Multi(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out);
+
+
+/****************************************** CRC-32C ****************************************/
+
+/**
+ * Método que retorna se o CRC-32C é calculado pela instrução crc32 do SSE4.2 (checado uma vez, na CPU atual);
+ * caso contrário é usada a versão por tabelas (slicing-by-8)
+ */
+bool CRC32CHardware();
+
+/**
+ * Método que calcula o CRC-32C (polinômio de Castagnoli, 0x1EDC6F41)
+ * 
+ * Parâmetros:	const void* buf	=>	Buffer do conteúdo
+ * 				size_t len		=>	Tamanho do conteúdo passado
+ * 
+ * Retorno:	uint32_t	=>	CRC-32C gerado
+ */
+uint32_t CRC32C(const void* buf, size_t len);
+
+/**
+ * Método análogo ao CRC32Multi, para o CRC-32C (4 fluxos da instrução crc32 intercalados)
+ */
+void CRC32CMulti(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out);
+
+
+/****************************************** Somas ****************************************/
+
+/**
+ * Método que calcula o Fletcher-32 (palavras de 16 bits little endian, somas módulo 65535;
+ * um byte final ímpar é completado com zero)
+ * 
+ * Retorno:	uint32_t	=>	(soma2 << 16) | soma1
+ */
+uint32_t Fletcher32(const void* buf, size_t len);
+
+/**
+ * Método que calcula o Adler-32 (somas de bytes módulo 65521, como no zlib)
+ * 
+ * Retorno:	uint32_t	=>	(b << 16) | a
+ */
+uint32_t Adler32(const void* buf, size_t len);
+
+/**
+ * Método que calcula o checksum da Internet (RFC 1071): complemento da soma em complemento de um
+ * das palavras de 16 bits big endian
+ * 
+ * Retorno:	uint32_t	=>	Checksum (16 bits, na ordem da rede)
+ */
+uint32_t InternetChecksum(const void* buf, size_t len);
+
 
 /**************************************************** Paridade **********************************/
 
@@ -61,6 +137,12 @@ uint32_t CRC32(const void* buf, size_t len);
  */
 unsigned int countBits(const void* buf, size_t len);
 
+/**
+ * Método auxiliar que retorna a paridade (0 ou 1) da quantidade de bits '1' do buffer,
+ * combinando o buffer em palavras de 64 bits com XOR (vetorizável) antes de contar
+ */
+uint8_t parity(const void* buf, size_t len);
+
 /**
  * Método que retorna o valor de bit de paridade par
  * 
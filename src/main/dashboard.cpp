@@ -0,0 +1,339 @@
+#include "dashboard.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <unistd.h>
+
+#include "sim.hpp"
+
+namespace tui
+{
+    /******************************************** Screen ******************************************/
+
+    Screen::Screen(int width, int height) : m_Width(0), m_Height(0) { resize(width, height); }
+
+    void Screen::resize(int width, int height)
+    {
+        m_Width = std::max(1, width);
+        m_Height = std::max(1, height);
+        m_Back.assign((size_t)m_Width * m_Height, Cell());
+        m_Front = m_Back;
+        m_Full = true;
+    }
+
+    void Screen::clear() { std::fill(m_Back.begin(), m_Back.end(), Cell()); }
+
+    void Screen::put(int x, int y, char32_t glyph, CellStyle style)
+    {
+        if (x < 0 || y < 0 || x >= m_Width || y >= m_Height)
+            return;
+        m_Back[(size_t)y * m_Width + x] = {glyph, style};
+    }
+
+    int Screen::put(int x, int y, std::string_view text, CellStyle style)
+    {
+        //Minimal UTF-8 decoding: each code point takes one cell
+        for (size_t i = 0; i < text.size() && x < m_Width;)
+        {
+            unsigned char c = (unsigned char)text[i];
+            int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+            char32_t glyph = extra ? c & (0x3F >> extra) : c;
+            for (int k = 1; k <= extra && i + k < text.size(); k++)
+                glyph = glyph << 6 | ((unsigned char)text[i + k] & 0x3F);
+            i += 1 + extra;
+            put(x++, y, glyph, style);
+        }
+        return x;
+    }
+
+    static void appendUtf8(std::string &out, char32_t c)
+    {
+        if (c < 0x80)
+            out += (char)c;
+        else if (c < 0x800)
+        {
+            out += (char)(0xC0 | c >> 6);
+            out += (char)(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+            out += (char)(0xE0 | c >> 12);
+            out += (char)(0x80 | (c >> 6 & 0x3F));
+            out += (char)(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            out += (char)(0xF0 | c >> 18);
+            out += (char)(0x80 | (c >> 12 & 0x3F));
+            out += (char)(0x80 | (c >> 6 & 0x3F));
+            out += (char)(0x80 | (c & 0x3F));
+        }
+    }
+
+    static void appendStyle(std::string &out, const CellStyle &style)
+    {
+        out += "\033[0";
+        if (style.bold)
+            out += ";1";
+        if (style.fg != text::TextColorF::None)
+            out += ";" + text::createColorString(style.fg);
+        if (style.bg != text::TextColorB::None)
+            out += ";" + text::createColorString(style.bg);
+        out += "m";
+    }
+
+    const std::string &Screen::diff()
+    {
+        m_Out.clear();
+
+        //Cursor and style the terminal is known to have (after a full clear: origin and default style)
+        int cx = -1, cy = -1;
+        CellStyle current;
+        if (m_Full)
+            m_Out += "\033[0m\033[H\033[2J";
+
+        for (int y = 0; y < m_Height; y++)
+            for (int x = 0; x < m_Width; x++)
+            {
+                size_t i = (size_t)y * m_Width + x;
+                const Cell &cell = m_Back[i];
+                if (m_Full ? cell == Cell() : cell == m_Front[i])
+                    continue;
+
+                //Consecutive changed cells need no cursor movement
+                if (cx != x || cy != y)
+                    m_Out += "\033[" + std::to_string(y + 1) + ";" + std::to_string(x + 1) + "H";
+                if (cell.style != current)
+                {
+                    appendStyle(m_Out, cell.style);
+                    current = cell.style;
+                }
+                appendUtf8(m_Out, cell.glyph);
+                cx = x + 1;
+                cy = y;
+            }
+
+        if (current != CellStyle())
+            m_Out += "\033[0m";
+        m_Front = m_Back;
+        m_Full = false;
+        return m_Out;
+    }
+
+    size_t Screen::present()
+    {
+        const std::string &out = diff();
+        if (out.empty())
+            return 0;
+
+        //Anything still buffered by stdio goes first, then the whole frame in one write
+        fflush(stdout);
+        size_t written = 0;
+        while (written < out.size())
+        {
+            ssize_t n = write(STDOUT_FILENO, out.data() + written, out.size() - written);
+            if (n <= 0)
+                break;
+            written += (size_t)n;
+        }
+        return written;
+    }
+
+    std::u32string sparkline(const std::deque<double> &values, size_t width)
+    {
+        static const char32_t BLOCKS[] = U"▁▂▃▄▅▆▇█";
+        size_t first = values.size() > width ? values.size() - width : 0;
+        double peak = 0;
+        for (size_t i = first; i < values.size(); i++)
+            peak = std::max(peak, values[i]);
+
+        std::u32string line;
+        for (size_t i = first; i < values.size(); i++)
+            line += peak > 0 ? BLOCKS[std::min<size_t>(7, (size_t)(values[i] / peak * 7.999))] : BLOCKS[0];
+        return line;
+    }
+
+    /******************************************* Dashboard ****************************************/
+
+    //Compact count: 999, 12.3k, 4.56M...
+    static std::string compact(double value)
+    {
+        const char *suffix = "";
+        for (const char *s : {"k", "M", "G", "T"})
+        {
+            if (value < 1000)
+                break;
+            value /= 1000;
+            suffix = s;
+        }
+        char buf[32];
+        snprintf(buf, sizeof(buf), *suffix ? "%.1f%s" : "%.0f%s", value, suffix);
+        return buf;
+    }
+
+    //Text right-aligned in 'width' cells
+    static std::string right(const std::string &text, size_t width) { return text.size() >= width ? text : std::string(width - text.size(), ' ') + text; }
+
+    Dashboard::Dashboard(unsigned maxFps, size_t history)
+        : m_Interval(std::max<int64_t>(1, 1000 / std::max(1u, maxFps))), m_History(std::max<size_t>(1, history)), m_Screen(100, 30),
+          m_LastSample(std::chrono::steady_clock::now())
+    {
+    }
+
+    Dashboard::~Dashboard() { stop(); }
+
+    void Dashboard::render()
+    {
+        auto [width, height] = getSize();
+        if (width <= 0 || height <= 0)
+            width = 100, height = 30;
+        if (width != m_Screen.width() || height != m_Screen.height())
+            m_Screen.resize(width, height);
+
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - m_LastSample).count();
+        m_LastSample = now;
+        std::vector<metrics::PeerSnapshot> snapshots = metrics::snapshotAll();
+
+        m_Screen.clear();
+        const CellStyle title = {text::TextColorF::Cyan, text::TextColorB::None, true};
+        const CellStyle header = {text::TextColorF::White, text::TextColorB::None, true};
+        const CellStyle dim = {text::TextColorF::Blue};
+
+        //Hosts are summed up in one line; every switch gets its own row
+        uint64_t hostRx = 0, hostTx = 0, hostDrops = 0, hosts = 0;
+        std::vector<const metrics::PeerSnapshot *> switches;
+        for (const metrics::PeerSnapshot &s : snapshots)
+        {
+            if (s.kind == PeerKind::Switch)
+            {
+                switches.push_back(&s);
+                continue;
+            }
+            if (s.kind != PeerKind::Host)
+                continue;
+            hosts++;
+            for (const metrics::PortSnapshot &p : s.ports)
+                hostRx += p.rxFrames, hostTx += p.txFrames;
+            for (uint64_t d : s.drops)
+                hostDrops += d;
+        }
+
+        char clock[64];
+        snprintf(clock, sizeof(clock), "%.3f ms", (double)sim::now() / sim::MILLISECOND);
+        int x = m_Screen.put(0, 0, " Network simulation ", {text::TextColorF::Black, text::TextColorB::Cyan, true});
+        x = m_Screen.put(x + 1, 0, "simulated time ", dim);
+        m_Screen.put(x, 0, clock, title);
+        m_Screen.put(0, 1, "hosts " + std::to_string(hosts) + "   rx " + compact((double)hostRx) + " frames   tx " + compact((double)hostTx) +
+                               " frames   drops " + compact((double)hostDrops));
+
+        //Columns: label, rx, tx, drops, table, occupancy bar, deepest queue, tx rate, throughput history
+        enum : int { RX = 10, TX = 18, DROPS = 26, TABLE = 34, BAR = 49, QUEUE = 59, RATE = 67, SPARK = 82 };
+        m_Screen.put(0, 3, "switch", header);
+        m_Screen.put(RX, 3, right("rx", 8) + right("tx", 8) + right("drops", 8) + right("table", 13) + "  occupancy" + right("queue", 9) +
+                                right("tx rate", 13) + "  throughput",
+                     header);
+
+        int row = 4;
+        for (const metrics::PeerSnapshot *s : switches)
+        {
+            //The last row above the status line tells how many switches did not fit
+            int last = m_Screen.height() - 2;
+            if (row > last)
+                break;
+            if (row == last && s != switches.back())
+            {
+                m_Screen.put(0, row, "... " + std::to_string(switches.size() - (row - 4)) + " more switches", dim);
+                break;
+            }
+
+            uint64_t rx = 0, tx = 0, txBytes = 0, drops = 0, queue = 0;
+            for (const metrics::PortSnapshot &p : s->ports)
+            {
+                rx += p.rxFrames, tx += p.txFrames, txBytes += p.txBytes;
+                queue = std::max(queue, p.queueDepth);
+            }
+            for (uint64_t d : s->drops)
+                drops += d;
+
+            Track &track = m_Tracks[s->label];
+            if (track.seen && seconds > 0)
+            {
+                track.rates.push_back((double)(txBytes - std::min(txBytes, track.txBytes)) / seconds);
+                if (track.rates.size() > m_History)
+                    track.rates.pop_front();
+            }
+            track.txBytes = txBytes;
+            track.seen = true;
+
+            double occupancy = (double)s->tableEntries / (double)s->tableCapacity;
+            CellStyle bar = {occupancy < 0.7 ? text::TextColorF::Green : occupancy < 0.9 ? text::TextColorF::Yellow : text::TextColorF::Red};
+            std::string table = std::to_string(s->tableEntries) + "/" + std::to_string(s->tableCapacity);
+            double rate = track.rates.empty() ? 0 : track.rates.back() * 8;
+
+            m_Screen.put(0, row, s->label);
+            m_Screen.put(RX, row, right(compact((double)rx), 8) + right(compact((double)tx), 8));
+            m_Screen.put(DROPS, row, right(compact((double)drops), 8), drops ? CellStyle{text::TextColorF::Red} : CellStyle{});
+            m_Screen.put(TABLE, row, right(table, 13));
+            for (int i = 0; i < 10; i++)
+                m_Screen.put(BAR + i, row, i < (int)(occupancy * 10 + 0.5) ? U'█' : U'·', bar);
+            m_Screen.put(QUEUE, row, right(std::to_string(queue), 8));
+            m_Screen.put(RATE, row, right(compact(rate) + "b/s", 13));
+
+            std::u32string spark = sparkline(track.rates, m_History);
+            for (size_t i = 0; i < spark.size(); i++)
+                m_Screen.put(SPARK + (int)i, row, spark[i], {text::TextColorF::Green});
+            row++;
+        }
+
+        m_Screen.put(0, m_Screen.height() - 1,
+                     "frames " + std::to_string(m_Frames) + "   written " + compact((double)m_Bytes) + "B   " +
+                         std::to_string(1000 / m_Interval.count()) + " fps max",
+                     dim);
+    }
+
+    void Dashboard::start()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Running)
+            return;
+        m_Running = true;
+
+        //Alternate screen, cursor hidden while drawing
+        saveScreen();
+        printf("\033[?25l");
+        fflush(stdout);
+        m_Screen.resize(m_Screen.width(), m_Screen.height());
+        m_LastSample = std::chrono::steady_clock::now();
+
+        m_Thread = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            while (m_Running)
+            {
+                lock.unlock();
+                render();
+                m_Bytes += m_Screen.present();
+                m_Frames++;
+                lock.lock();
+                m_Wakeup.wait_for(lock, m_Interval, [this]() { return !m_Running; });
+            }
+        });
+    }
+
+    void Dashboard::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (!m_Running)
+                return;
+            m_Running = false;
+        }
+        m_Wakeup.notify_all();
+        m_Thread.join();
+
+        printf("\033[0m\033[?25h");
+        rbScreen();
+        fflush(stdout);
+    }
+}
@@ -0,0 +1,145 @@
+/**
+ * Header criado para acompanhar uma simulação em andamento em um painel no terminal
+ *
+ * tui::Screen é uma grade de células fora da tela (buffer duplo): o quadro é desenhado nela e present()
+ * compara com o quadro anterior, emitindo só as células que mudaram (posição e estilo apenas quando necessário)
+ * em uma única escrita no terminal.
+ *
+ * tui::Dashboard roda em uma thread própria, lendo snapshots dos contadores publicados (metrics::snapshotAll),
+ * e desenha um quadro por intervalo, no máximo maxFps por segundo: contadores de cada switch, ocupação da tabela
+ * de MACs, fila de saída e um histórico da vazão (sparkline). A thread da simulação nunca espera pelo painel.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "metrics.hpp"
+#include "tui.hpp"
+
+namespace tui
+{
+    //Estilo de uma célula
+    struct CellStyle
+    {
+        text::TextColorF fg = text::TextColorF::None;
+        text::TextColorB bg = text::TextColorB::None;
+        bool bold = false;
+
+        bool operator==(const CellStyle &) const = default;
+    };
+
+    struct Cell
+    {
+        char32_t glyph = U' ';
+        CellStyle style;
+
+        bool operator==(const Cell &) const = default;
+    };
+
+    class Screen
+    {
+    private:
+        int m_Width, m_Height;
+        std::vector<Cell> m_Back;  //Quadro sendo desenhado
+        std::vector<Cell> m_Front; //Quadro que está no terminal
+        bool m_Full = true;        //O próximo present redesenha tudo (primeiro quadro, após resize)
+        std::string m_Out;
+
+    public:
+        Screen(int width, int height);
+
+        int width() const { return m_Width; }
+        int height() const { return m_Height; }
+
+        //Muda o tamanho (o próximo quadro é redesenhado por inteiro)
+        void resize(int width, int height);
+
+        //Apaga o quadro sendo desenhado
+        void clear();
+
+        /**
+         * Método que escreve um texto (UTF-8) a partir da célula (x, y), cortado na borda direita
+         *
+         * Parâmetros:	int x, y				=>	Coluna e linha (a partir de 0)
+         * 				std::string_view text	=>	Texto, sem quebras de linha
+         * 				CellStyle style			=>	Estilo das células escritas
+         *
+         * Retorno: int	=>	Coluna seguinte à última escrita
+         */
+        int put(int x, int y, std::string_view text, CellStyle style = {});
+        void put(int x, int y, char32_t glyph, CellStyle style = {});
+
+        const Cell &at(int x, int y) const { return m_Back[(size_t)y * m_Width + x]; }
+
+        //Sequência de escape que leva o terminal do quadro anterior a este (só as células que mudaram)
+        const std::string &diff();
+
+        /**
+         * Método que envia o quadro ao terminal em uma única escrita
+         *
+         * Retorno: size_t	=>	Bytes escritos (0 se nada mudou)
+         */
+        size_t present();
+    };
+
+    class Dashboard
+    {
+    public:
+        /**
+         * Construtor do painel (a thread só começa em start)
+         *
+         * Parâmetros:	unsigned maxFps		=>	Limite de quadros por segundo
+         * 				size_t history		=>	Amostras de vazão guardadas por switch (largura da sparkline)
+         */
+        explicit Dashboard(unsigned maxFps = 10, size_t history = 32);
+        ~Dashboard();
+
+        //Entra na tela alternativa do terminal e começa a desenhar
+        void start();
+        //Para a thread e devolve o terminal como estava
+        void stop();
+
+        //Lê os contadores e desenha um quadro (sem enviar ao terminal)
+        void render();
+
+        const Screen &screen() const { return m_Screen; }
+
+        //Quadros enviados e bytes escritos no terminal
+        uint64_t frames() const { return m_Frames.load(std::memory_order_relaxed); }
+        uint64_t bytesWritten() const { return m_Bytes.load(std::memory_order_relaxed); }
+
+    private:
+        //Histórico de um switch entre dois quadros
+        struct Track
+        {
+            uint64_t txBytes = 0;
+            std::deque<double> rates; //Bytes/s (tempo de parede) de cada intervalo
+            bool seen = false;
+        };
+
+        std::chrono::milliseconds m_Interval;
+        size_t m_History;
+        Screen m_Screen;
+        std::unordered_map<std::string, Track> m_Tracks;
+        std::chrono::steady_clock::time_point m_LastSample;
+        std::atomic<uint64_t> m_Frames{0}, m_Bytes{0}; //Atualizados pela thread do painel, lidos por qualquer thread
+
+        std::thread m_Thread;
+        std::mutex m_Mutex;
+        std::condition_variable m_Wakeup;
+        bool m_Running = false;
+    };
+
+    //Sparkline com um caractere de bloco (▁ a █) por valor, em relação ao maior deles
+    std::u32string sparkline(const std::deque<double> &values, size_t width);
+}
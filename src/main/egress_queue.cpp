@@ -0,0 +1,112 @@
+#include "egress_queue.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace queueing
+{
+    EgressQueue::EgressQueue(const QueueConfig &config, rng::Xoshiro256 rng) : m_Config(config), m_Rng(rng)
+    {
+        if (config.capacity == 0)
+            throw std::runtime_error("Egress queue capacity must be positive");
+        for (uint32_t quantum : config.quantum)
+            if (quantum == 0)
+                throw std::runtime_error("DWRR quantum must be positive");
+        if (config.drop == DropPolicy::RED && !(config.redMin < config.redMax))
+            throw std::runtime_error("RED thresholds must satisfy min < max");
+    }
+
+    Admission EgressQueue::push(const Ether2Frame &frame, unsigned cls)
+    {
+        std::deque<Ether2Frame> &queue = m_Queues[cls];
+
+        if (m_Config.drop == DropPolicy::RED)
+        {
+            //Average over arrivals (idle periods are not decayed)
+            double &avg = m_Average[cls];
+            avg += m_Config.redWeight * ((double)queue.size() - avg);
+            if (avg >= m_Config.redMax)
+                return Admission::RedDrop;
+            if (avg > m_Config.redMin)
+            {
+                double p = m_Config.redMaxProbability * (avg - m_Config.redMin) / (m_Config.redMax - m_Config.redMin);
+                if (m_Rng.nextDouble() < p)
+                    return Admission::RedDrop;
+            }
+        }
+
+        if (queue.size() >= m_Config.capacity)
+            return Admission::TailDrop;
+
+        queue.push_back(frame);
+        m_Size++;
+        return Admission::Accepted;
+    }
+
+    int EgressQueue::select(sim::Time now)
+    {
+        bool any = false;
+        for (unsigned cls = 0; cls < CLASSES && !any; cls++)
+            any = ready(cls, now);
+        if (!any)
+            return -1;
+
+        if (m_Config.scheduling == Scheduling::StrictPriority)
+        {
+            for (int cls = CLASSES - 1; cls >= 0; cls--)
+                if (ready(cls, now))
+                    return cls;
+        }
+
+        //DWRR: the class under the cursor gets its quantum once per visit and keeps the turn while its deficit covers the head frame
+        while (true)
+        {
+            unsigned cls = m_Cursor;
+            if (ready(cls, now))
+            {
+                if (!m_Visited)
+                {
+                    m_Deficit[cls] += m_Config.quantum[cls];
+                    m_Visited = true;
+                }
+                if (m_Queues[cls].front().wireSize() <= m_Deficit[cls])
+                    return cls;
+            }
+            else if (m_Queues[cls].empty())
+                m_Deficit[cls] = 0;
+
+            m_Cursor = (m_Cursor + 1) % CLASSES;
+            m_Visited = false;
+        }
+    }
+
+    Ether2Frame EgressQueue::pop(unsigned cls)
+    {
+        std::deque<Ether2Frame> &queue = m_Queues[cls];
+        Ether2Frame frame = queue.front();
+        queue.pop_front();
+        m_Size--;
+
+        if (m_Config.scheduling == Scheduling::DWRR)
+        {
+            m_Deficit[cls] -= std::min<uint32_t>(m_Deficit[cls], frame.wireSize());
+            //An emptied class gives up its turn and its remaining deficit
+            if (queue.empty())
+            {
+                m_Deficit[cls] = 0;
+                m_Cursor = (cls + 1) % CLASSES;
+                m_Visited = false;
+            }
+        }
+        return frame;
+    }
+
+    sim::Time EgressQueue::nextReady() const
+    {
+        sim::Time next = UINT64_MAX;
+        for (const std::deque<Ether2Frame> &queue : m_Queues)
+            if (!queue.empty())
+                next = std::min(next, queue.front().departedAt);
+        return next;
+    }
+}
@@ -0,0 +1,119 @@
+/**
+ * Header criado para modelar as filas de saída das portas de um switch
+ *
+ * Cada porta tem uma fila limitada por classe de prioridade 802.1p (PCP do tag de entrada, ou 0 sem tag). O enlace transmite
+ * um frame por vez: enquanto está ocupado, os frames esperam, e o escalonador escolhe a próxima classe
+ * (prioridade estrita ou DWRR). Na chegada, a fila cheia descarta o frame (tail drop) ou o RED descarta
+ * antecipadamente com probabilidade crescente conforme a ocupação média.
+ *
+ * As filas só andam dentro do laço de eventos (sim::run): sem ele, um switch com filas não transmite nada.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include "frame.hpp"
+#include "rng.hpp"
+#include "sim.hpp"
+
+namespace checkpoint
+{
+    struct Access;
+}
+
+namespace queueing
+{
+    //Classes de tráfego (uma por valor de PCP)
+    constexpr unsigned CLASSES = 8;
+
+    enum class Scheduling
+    {
+        StrictPriority, //Sempre a classe de maior PCP com frame pronto
+        DWRR            //Deficit Weighted Round Robin: cada classe recebe 'quantum' bytes por rodada
+    };
+
+    enum class DropPolicy
+    {
+        TailDrop, //Descarta só quando a fila da classe está cheia
+        RED       //Random Early Detection sobre a ocupação média da classe (e tail drop quando cheia)
+    };
+
+    struct QueueConfig
+    {
+        size_t capacity = 64; //Frames por classe
+        Scheduling scheduling = Scheduling::StrictPriority;
+        uint32_t quantum[CLASSES] = {1522, 1522, 1522, 1522, 1522, 1522, 1522, 1522}; //Bytes por rodada (DWRR)
+
+        DropPolicy drop = DropPolicy::TailDrop;
+        double redMin = 16, redMax = 48;  //Limiares da ocupação média (frames)
+        double redMaxProbability = 0.1;   //Probabilidade de descarte ao atingir redMax
+        double redWeight = 0.002;         //Peso da amostra atual na média móvel exponencial
+    };
+
+    //Resultado da chegada de um frame à fila
+    enum class Admission
+    {
+        Accepted,
+        TailDrop,
+        RedDrop
+    };
+
+    class EgressQueue
+    {
+    private:
+        QueueConfig m_Config;
+        std::deque<Ether2Frame> m_Queues[CLASSES];
+        double m_Average[CLASSES] = {};
+        uint32_t m_Deficit[CLASSES] = {};
+        unsigned m_Cursor = 0;
+        bool m_Visited = false;
+        size_t m_Size = 0;
+        rng::Xoshiro256 m_Rng;
+
+        //A classe tem um frame pronto (o instante de saída do primeiro já passou)
+        bool ready(unsigned cls, sim::Time now) const { return !m_Queues[cls].empty() && m_Queues[cls].front().departedAt <= now; }
+
+        friend struct checkpoint::Access;
+
+    public:
+        //Enlace ocupado até este instante
+        sim::Time busyUntil = 0;
+        //Instante do evento de serviço agendado para esta fila (NO_SERVICE: nenhum); eventos de outros instantes são obsoletos
+        static constexpr sim::Time NO_SERVICE = UINT64_MAX;
+        sim::Time serviceAt = NO_SERVICE;
+
+        EgressQueue(const QueueConfig &config, rng::Xoshiro256 rng);
+
+        /**
+         * Método que tenta colocar uma cópia do frame na fila de uma classe
+         * (frame.departedAt é o instante a partir do qual o frame pode sair)
+         *
+         * Parâmetros:	const Ether2Frame &frame	=>	Frame a enfileirar
+         * 				unsigned cls				=>	Classe de tráfego (prioridade com que o frame entrou no switch)
+         *
+         * Retorno: Admission	=>	Aceito ou o motivo do descarte
+         */
+        Admission push(const Ether2Frame &frame, unsigned cls);
+
+        /**
+         * Método que escolhe a próxima classe a transmitir no instante now
+         *
+         * Retorno: int	=>	Classe escolhida, ou -1 se nenhum frame está pronto
+         */
+        int select(sim::Time now);
+
+        //Retira o primeiro frame da classe (escolhida por select)
+        Ether2Frame pop(unsigned cls);
+
+        //Menor instante em que um frame da fila fica pronto
+        sim::Time nextReady() const;
+
+        size_t size() const { return m_Size; }
+        size_t size(unsigned cls) const { return m_Queues[cls].size(); }
+        bool empty() const { return m_Size == 0; }
+
+        const QueueConfig &config() const { return m_Config; }
+    };
+}
@@ -0,0 +1,165 @@
+/**
+ * Header criado para tornar o método de checagem (ERROR_CONTROL) um parâmetro de compilação
+ *
+ * Cada método é um tipo de política com funções estáticas. Frames, peers e histórias são instanciados
+ * para uma política, de modo que o caminho de um frame não testa o método de checagem a cada passo:
+ * o valor de ERROR_CONTROL escolhido em tempo de execução é convertido na política uma única vez,
+ * na entrada (error_control::dispatch).
+ */
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "crc_32.hpp"
+#include "types.hpp"
+
+namespace error_control
+{
+    //CRC-32
+    struct Crc
+    {
+        static constexpr ERROR_CONTROL kind = ERROR_CONTROL::CRC;
+        static constexpr const char *name = "CRC";
+        static constexpr const char *field = "CRC";
+
+        static uint32_t compute(const uint8_t *buf, size_t len) { return CRC32(buf, len); }
+        static void computeMany(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out) { CRC32Multi(bufs, count, len, out); }
+    };
+
+    //Paridade par
+    struct Even
+    {
+        static constexpr ERROR_CONTROL kind = ERROR_CONTROL::EVEN;
+        static constexpr const char *name = "Even bits";
+        static constexpr const char *field = "parity bit (even)";
+
+        static uint32_t compute(const uint8_t *buf, size_t len) { return parity(buf, len); }
+        static void computeMany(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out)
+        {
+            for (size_t i = 0; i < count; i++)
+                out[i] = compute(bufs[i], len);
+        }
+    };
+
+    //Paridade ímpar (complemento da paridade par)
+    struct Odd
+    {
+        static constexpr ERROR_CONTROL kind = ERROR_CONTROL::ODD;
+        static constexpr const char *name = "Odd bits";
+        static constexpr const char *field = "parity bit (odd)";
+
+        static uint32_t compute(const uint8_t *buf, size_t len) { return parity(buf, len) ^ 1u; }
+        static void computeMany(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out)
+        {
+            for (size_t i = 0; i < count; i++)
+                out[i] = compute(bufs[i], len);
+        }
+    };
+
+    //CRC-32C (Castagnoli): instrução crc32 do SSE4.2 quando disponível
+    struct Crc32c
+    {
+        static constexpr ERROR_CONTROL kind = ERROR_CONTROL::CRC32C;
+        static constexpr const char *name = "CRC-32C";
+        static constexpr const char *field = "CRC-32C";
+
+        static uint32_t compute(const uint8_t *buf, size_t len) { return CRC32C(buf, len); }
+        static void computeMany(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out) { CRC32CMulti(bufs, count, len, out); }
+    };
+
+    //Fletcher-32
+    struct Fletcher32
+    {
+        static constexpr ERROR_CONTROL kind = ERROR_CONTROL::FLETCHER32;
+        static constexpr const char *name = "Fletcher-32";
+        static constexpr const char *field = "Fletcher-32 checksum";
+
+        static uint32_t compute(const uint8_t *buf, size_t len) { return ::Fletcher32(buf, len); }
+        static void computeMany(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out)
+        {
+            for (size_t i = 0; i < count; i++)
+                out[i] = compute(bufs[i], len);
+        }
+    };
+
+    //Adler-32
+    struct Adler32
+    {
+        static constexpr ERROR_CONTROL kind = ERROR_CONTROL::ADLER32;
+        static constexpr const char *name = "Adler-32";
+        static constexpr const char *field = "Adler-32 checksum";
+
+        static uint32_t compute(const uint8_t *buf, size_t len) { return ::Adler32(buf, len); }
+        static void computeMany(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out)
+        {
+            for (size_t i = 0; i < count; i++)
+                out[i] = compute(bufs[i], len);
+        }
+    };
+
+    //Checksum da Internet (RFC 1071)
+    struct Internet
+    {
+        static constexpr ERROR_CONTROL kind = ERROR_CONTROL::INTERNET;
+        static constexpr const char *name = "Internet checksum";
+        static constexpr const char *field = "Internet checksum";
+
+        static uint32_t compute(const uint8_t *buf, size_t len) { return InternetChecksum(buf, len); }
+        static void computeMany(const uint8_t *const *bufs, size_t count, size_t len, uint32_t *out)
+        {
+            for (size_t i = 0; i < count; i++)
+                out[i] = compute(bufs[i], len);
+        }
+    };
+
+    //Requisitos de um tipo de política
+    template <class P>
+    concept Policy = requires(const uint8_t *buf, const uint8_t *const *bufs, size_t len, uint32_t *out) {
+        { P::kind } -> std::convertible_to<ERROR_CONTROL>;
+        { P::compute(buf, len) } -> std::same_as<uint32_t>;
+        P::computeMany(bufs, len, len, out);
+    };
+
+    //Aplica X(Política) a cada política (para instanciações explícitas)
+#define ERROR_CONTROL_POLICIES(X) X(Crc) X(Even) X(Odd) X(Crc32c) X(Fletcher32) X(Adler32) X(Internet)
+
+    /**
+     * Converte o método escolhido em tempo de execução na política correspondente, chamando f(Política{})
+     *
+     * Parâmetros:	ERROR_CONTROL type	=>	Método de checagem
+     * 				F &&f				=>	Função genérica (ex.: [&]<class P>(P) { ... })
+     *
+     * Retorno: o retorno de f
+     */
+    template <class F>
+    decltype(auto) dispatch(ERROR_CONTROL type, F &&f)
+    {
+        switch (type)
+        {
+        case ERROR_CONTROL::CRC:
+            return f(Crc{});
+        case ERROR_CONTROL::EVEN:
+            return f(Even{});
+        case ERROR_CONTROL::ODD:
+            return f(Odd{});
+        case ERROR_CONTROL::CRC32C:
+            return f(Crc32c{});
+        case ERROR_CONTROL::FLETCHER32:
+            return f(Fletcher32{});
+        case ERROR_CONTROL::ADLER32:
+            return f(Adler32{});
+        case ERROR_CONTROL::INTERNET:
+            return f(Internet{});
+        }
+        throw std::runtime_error("Unknown error control type");
+    }
+
+    //Verificador do buffer com o método escolhido em tempo de execução
+    inline uint32_t compute(ERROR_CONTROL type, const uint8_t *buf, size_t len)
+    {
+        return dispatch(type, [&]<class P>(P) { return P::compute(buf, len); });
+    }
+}
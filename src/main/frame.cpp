@@ -3,6 +3,7 @@
 #include <iostream>
 #include <stdint.h>
 #include <string.h>
+#include <stdexcept>
 
 #include "mac.hpp"
 #include "crc_32.hpp"
@@ -17,23 +18,23 @@ Ether2Frame::Ether2Frame(
     size_t data_size,
     ERROR_CONTROL errorType)
     : dst(dst.bytes),
-      src(src.bytes)
+      src(src.bytes),
+      type(0)
+{
+    fill(data, data_size);
+    verifyContent = error_control::compute(errorType, this->data, 1500);
+}
+
+void Ether2Frame::fill(const char *const data, size_t data_size)
 {
     if (data_size > 1499) data_size = 1499;
     memset(this->data, '\0', 1500);
     memcpy(this->data, data, data_size);
-    if (errorType == ERROR_CONTROL::CRC)
-    {
-        verifyContent = CRC32(this->data, 1500);
-    }
-    else if (errorType == ERROR_CONTROL::EVEN)
-    {
-        verifyContent = paridadePar((void *)this->data, 1500);
-    }
-    else
-    {
-        verifyContent = paridadeImpar((void *)this->data, 1500);
-    }
+}
+
+Ether2Frame::Ether2Frame() : dst(0), src(0), type(0), verifyContent(0)
+{
+    memset(this->data, '\0', 1500);
 }
 
 void Ether2Frame::prettyPrint()
@@ -41,43 +42,29 @@ void Ether2Frame::prettyPrint()
     std::cout << " [ dst: " << std::hex << std::setfill('0') << std::setw(2) << (uint64_t)dst;
     std::cout << " | src: " << std::hex << std::setfill('0') << std::setw(2) << (uint64_t)src;
     std::cout << " | type: " << std::setw(2) << type;
+    if (tagged())
+        std::cout << " | vlan: " << std::dec << vid() << " pcp " << (unsigned)pcp() << std::hex;
     std::cout << " | payload: " << data;
     std::cout << " | verificador: " << verifyContent;
     std::cout << " ] " << std::endl;
 }
 
-void Ether2Frame::_simulation_fake_noise(float probability, size_t randomize_below)
-{
-    if (randomize_below == (size_t)-1)
-        randomize_below = strlen((const char *)data);
-
-    if (rand() % 100 <= probability * 100)
-    {
-        size_t byteToRandomize = rand() % randomize_below;
-        size_t bitToRandomize = rand() % 8;
-        std::cout << std::endl;
-        std::cout << "*** Simulating ERROR!!! *** "_fred << std::endl;
-        std::cout << "  Flipping bit "_fred << bitToRandomize << " of byte "_fred << byteToRandomize << std::endl;
-        std::cout << "  Data before: "_fblu << data << std::endl;
-        data[byteToRandomize] ^= 0b00000001 << (bitToRandomize);
-        std::cout << "  Data after: "_fblu << data << std::endl;
-        std::cout << "*** Simulated error *** "_fred << std::endl;
-
-        std::cout << std::endl;
-    }
-}
-
 bool Ether2Frame::checkCRC()
 {
-    return verifyContent == CRC32(this->data, 1500);
+    return check<error_control::Crc>();
 }
 
 bool Ether2Frame::checkEven()
 {
-    return verifyContent == paridadePar((void *)this->data, 1500);
+    return check<error_control::Even>();
 }
 
 bool Ether2Frame::checkOdd()
 {
-    return verifyContent == paridadeImpar((void *)this->data, 1500);
-}
\ No newline at end of file
+    return check<error_control::Odd>();
+}
+
+uint64_t verifyFrames(std::span<Ether2Frame *const> frames, ERROR_CONTROL errorType)
+{
+    return error_control::dispatch(errorType, [&]<class P>(P) { return verifyFrames<P>(frames); });
+}
@@ -6,20 +6,39 @@
 #include <iostream>
 #include <stdint.h>
 #include <string.h>
+#include <span>
 
 #include "mac.hpp"
 #include "crc_32.hpp"
+#include "error_control.hpp"
 #include "tui.hpp"
+#include "sim.hpp"
+#include "trace.hpp"
 
 using namespace tui::text_literals;
 
 struct Ether2Frame
 {
+	//Tamanho do frame no fio: cabeçalho (dst, src, type) + payload máximo + verificador
+	static constexpr size_t HEADER_SIZE = 14;
+	static constexpr size_t PAYLOAD_SIZE = 1500;
+	static constexpr size_t WIRE_SIZE = HEADER_SIZE + PAYLOAD_SIZE + sizeof(uint32_t);
+	//Bytes até o fim do MAC de destino (o que um switch cut-through lê antes de decidir)
+	static constexpr size_t DST_SIZE = 6;
+
+	//Tag IEEE 802.1Q: TPID + TCI (PCP 3 bits | DEI 1 bit | VID 12 bits), inserido antes do type
+	static constexpr uint16_t VLAN_TPID = 0x8100;
+	static constexpr size_t VLAN_TAG_SIZE = 4;
+
 	uint64_t
 		dst : 48,
 		src : 48,
 		type : 16;
 
+	//Tag 802.1Q (tpid == VLAN_TPID se o frame está marcado; 0 caso contrário)
+	uint16_t tpid = 0;
+	uint16_t tci = 0;
+
 	/**
 	 * Vetor de bytes do frame ethernet 2: varia de 46 a 1500 bytes.
 	 * No C, não é possível fazer um vetor dinâmico 
@@ -31,11 +50,56 @@ struct Ether2Frame
 	uint8_t data[1500];
 	uint32_t verifyContent;
 
+	//Metadados da simulação (não fazem parte do frame no fio), usados para medir latência
+	sim::Time sentAt = 0;      //Instante em que o host de origem enviou o frame
+	sim::Time hopStart = 0;    //Instante em que o peer anterior terminou de receber o frame (ou sentAt)
+	sim::Time departedAt = 0;  //Instante em que o frame começou a ser transmitido no enlace atual
+	sim::Time arrivedAt = 0;   //Instante em que o último bit chegou ao peer atual
+	uint64_t wallSentAt = 0;   //Tempo de parede do envio (0 se desabilitado)
+#ifdef NLS_TRACE
+	uint64_t traceFlow = 0;    //Fluxo do trace que segue o frame pelos saltos (0 se não gravado)
+#endif
+
 	/**
 	 * Construtor da classe Ether2Frame, já settando o tipo de checagem a ser feita (CRC, paridade par, paridade ímpar)
 	 */
 	Ether2Frame(const MAC &dst, const MAC &src, const char *const data, size_t data_size, ERROR_CONTROL errorType);
 
+	/**
+	 * Construtor com o método de checagem fixado em tempo de compilação (ex.: Ether2Frame(dst, src, data, size, error_control::Crc{}))
+	 */
+	template <error_control::Policy P>
+	Ether2Frame(const MAC &dst, const MAC &src, const char *const data, size_t data_size, P)
+		: dst(dst.bytes), src(src.bytes), type(0)
+	{
+		fill(data, data_size);
+		TRACE_SCOPE("checksum");
+		verifyContent = P::compute(this->data, PAYLOAD_SIZE);
+	}
+
+	/**
+	 * Construtor de um frame zerado (usado pelos frames em trânsito e pelos registros de checkpoint)
+	 */
+	Ether2Frame();
+
+	//Métodos auxiliares da tag 802.1Q
+	inline bool tagged() const { return tpid == VLAN_TPID; }
+	inline uint16_t vid() const { return tci & 0x0FFF; }
+	inline uint8_t pcp() const { return tci >> 13; }
+	inline void tag(uint16_t vid, uint8_t pcp = 0)
+	{
+		tpid = VLAN_TPID;
+		tci = (uint16_t)(pcp << 13 | (vid & 0x0FFF));
+	}
+	inline void untag() { tpid = tci = 0; }
+
+	//Tamanho no fio (a tag acrescenta 4 bytes)
+	inline size_t wireSize() const { return WIRE_SIZE + (tagged() ? VLAN_TAG_SIZE : 0); }
+
+private:
+	//Copia o payload (truncado em 1499 bytes) e zera o restante
+	void fill(const char *const data, size_t data_size);
+
 public:
 	/**
 	 * Método auxiliar para imprimir na tela dados do frame
@@ -43,24 +107,27 @@ public:
 	void prettyPrint();
 
 	/**
-	 * Método que simula um ruído na transmissão do frame, ocasionando na alteração do valor de um bit aleatório
+	 * Método de checagem se a verificação do CRC corresponde com o esperado
 	 * 
-	 * Parâmetros: float probability		=>	Probabilidade da alteração ocorrer
-	 * 				size_t randomize_below	=>	Valor máximo da posição para se alterar um bit (para efeitos de visualização)
+	 * Parâmetros: void
 	 * 
-	 * Retorno: void
+	 * Return: bool	=>	true - conteúdo íntegro
+	 * 					false - conteúdo alterado
 	 */
-	void _simulation_fake_noise(float probability = 0.1, size_t randomize_below = -1);
+	bool checkCRC();
 
 	/**
-	 * Método de checagem se a verificação do CRC corresponde com o esperado
-	 * 
-	 * Parâmetros: void
+	 * Método de checagem do verificador com o método de checagem da política P
 	 * 
 	 * Return: bool	=>	true - conteúdo íntegro
 	 * 					false - conteúdo alterado
 	 */
-	bool checkCRC();
+	template <error_control::Policy P>
+	bool check() const
+	{
+		TRACE_SCOPE("checksum");
+		return verifyContent == P::compute(data, PAYLOAD_SIZE);
+	}
 
 	/**
 	 * Método de checagem se a verificação do bit de paridade par corresponde com o esperado
@@ -81,4 +148,58 @@ public:
 	 * 					false - conteúdo alterado
 	 */
 	bool checkOdd();
-};
\ No newline at end of file
+};
+
+//Ethertype dos frames de controle de grupo multicast (0x88B5: ethertype local experimental do IEEE 802)
+constexpr uint16_t GROUP_CONTROL_TYPE = 0x88B5;
+
+/**
+ * Operação de um frame de controle de grupo, enviado por um host ao endereço do grupo.
+ * Payload: [operação (1 byte)][MAC do grupo (6 bytes, big endian)]
+ */
+enum class GroupOp : uint8_t
+{
+	Join = 1,
+	Leave = 2
+};
+
+//Quantidade máxima de frames em um lote de verificação (um bit por frame no resultado)
+constexpr size_t VERIFY_BATCH_MAX = 64;
+
+/**
+ * Método que verifica um lote de frames de uma só vez, com o método de checagem dado
+ * 
+ * No CRC, os frames são verificados de 4 em 4 com fluxos de CRC intercalados (CRC32Multi);
+ * na paridade, cada payload é reduzido com XOR em palavras de 64 bits.
+ * 
+ * Parâmetros:	std::span<Ether2Frame *const> frames	=>	Frames a verificar (no máximo VERIFY_BATCH_MAX)
+ * 				ERROR_CONTROL errorType					=>	Método de checagem
+ * 
+ * Retorno: uint64_t	=>	Máscara em que o bit i é 1 se o frame i está íntegro
+ */
+uint64_t verifyFrames(std::span<Ether2Frame *const> frames, ERROR_CONTROL errorType);
+
+/**
+ * Método análogo ao acima, com o método de checagem fixado em tempo de compilação
+ */
+template <error_control::Policy P>
+uint64_t verifyFrames(std::span<Ether2Frame *const> frames)
+{
+	if (frames.size() > VERIFY_BATCH_MAX)
+		throw std::runtime_error("Verification batch is larger than VERIFY_BATCH_MAX");
+
+	const uint8_t *payloads[VERIFY_BATCH_MAX] = {};
+	uint32_t expected[VERIFY_BATCH_MAX];
+	for (size_t i = 0; i < frames.size(); i++)
+		payloads[i] = frames[i]->data;
+
+	{
+		TRACE_SCOPE("checksum (batch)");
+		P::computeMany(payloads, frames.size(), Ether2Frame::PAYLOAD_SIZE, expected);
+	}
+
+	uint64_t valid = 0;
+	for (size_t i = 0; i < frames.size(); i++)
+		valid |= (uint64_t)(expected[i] == frames[i]->verifyContent) << i;
+	return valid;
+}
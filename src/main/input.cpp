@@ -0,0 +1,334 @@
+#include "input.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace tui
+{
+    /******************************************** RawMode *****************************************/
+
+    RawMode::RawMode(int fd) : m_Fd(fd)
+    {
+        if (!isatty(fd) || tcgetattr(fd, &m_Saved) != 0)
+            return;
+
+        termios raw = m_Saved;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        m_Active = tcsetattr(fd, TCSANOW, &raw) == 0;
+    }
+
+    RawMode::~RawMode()
+    {
+        if (m_Active)
+            tcsetattr(m_Fd, TCSANOW, &m_Saved);
+    }
+
+    /******************************************* KeyReader ****************************************/
+
+    //Time the rest of an escape sequence may take to arrive; after that the ESC was a key of its own
+    static constexpr int ESCAPE_TIMEOUT_MS = 50;
+
+    KeyReader::KeyReader(int fd) : m_Fd(fd) {}
+
+    KeyReader &KeyReader::standard()
+    {
+        static KeyReader reader(STDIN_FILENO);
+        return reader;
+    }
+
+    void KeyReader::decode()
+    {
+        size_t i = 0;
+        while (i < m_Bytes.size())
+        {
+            unsigned char c = (unsigned char)m_Bytes[i];
+            if (c == '\033')
+            {
+                //An incomplete sequence waits for the rest of its bytes (see next); an ESC not starting one is ignored
+                if (i + 1 >= m_Bytes.size())
+                    break;
+                char kind = m_Bytes[i + 1];
+                if (kind != '[' && kind != 'O')
+                {
+                    i++;
+                    continue;
+                }
+                if (i + 2 >= m_Bytes.size())
+                    break;
+                char code = m_Bytes[i + 2];
+                size_t length = 3;
+                switch (code)
+                {
+                case 'C':
+                    m_Keys.push_back({KeyEvent::Right});
+                    break;
+                case 'D':
+                    m_Keys.push_back({KeyEvent::Left});
+                    break;
+                case 'H':
+                    m_Keys.push_back({KeyEvent::Home});
+                    break;
+                case 'F':
+                    m_Keys.push_back({KeyEvent::End});
+                    break;
+                case '3':
+                    if (i + 3 >= m_Bytes.size())
+                        return m_Bytes.erase(0, i), void();
+                    if (m_Bytes[i + 3] == '~')
+                        m_Keys.push_back({KeyEvent::Delete});
+                    length = 4;
+                    break;
+                default: //Up/down and other keys are ignored
+                    break;
+                }
+                i += length;
+                continue;
+            }
+
+            if (c == '\n' || c == '\r')
+                m_Keys.push_back({KeyEvent::Enter});
+            else if (c == 127 || c == '\b')
+                m_Keys.push_back({KeyEvent::Backspace});
+            else if (c == 4)
+                m_Keys.push_back({KeyEvent::EndOfInput});
+            else if (c >= 32 || c == '\t')
+                m_Keys.push_back({KeyEvent::Char, (char)c});
+            i++;
+        }
+        m_Bytes.erase(0, i);
+    }
+
+    bool KeyReader::next(KeyEvent &key, int timeoutMs)
+    {
+        while (m_Keys.empty() && !m_Closed)
+        {
+            //A sequence cut at the end of the input only waits ESCAPE_TIMEOUT_MS for the rest: then its ESC is
+            //dropped (a lone ESC press) and the bytes after it are decoded as typed
+            int wait = timeoutMs;
+            bool escape = false;
+            if (!m_Bytes.empty())
+            {
+                auto waited = std::chrono::steady_clock::now() - m_PendingSince;
+                int left = ESCAPE_TIMEOUT_MS - (int)std::chrono::duration_cast<std::chrono::milliseconds>(waited).count();
+                if (left <= 0)
+                {
+                    m_Bytes.erase(0, 1);
+                    decode();
+                    m_PendingSince = std::chrono::steady_clock::now();
+                    continue;
+                }
+                if (wait < 0 || wait > left)
+                    wait = left, escape = true;
+            }
+
+            pollfd p = {m_Fd, POLLIN, 0};
+            int ready = poll(&p, 1, wait);
+            if (ready < 0 && errno == EINTR)
+                continue;
+            if (ready == 0 && escape)
+                continue;
+            if (ready <= 0)
+                return false;
+
+            char buf[256];
+            ssize_t n = (p.revents & POLLNVAL) ? 0 : read(m_Fd, buf, sizeof(buf));
+            if (n < 0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+            if (n <= 0)
+            {
+                //The input is gone: whatever is pending is delivered, then the end
+                m_Closed = true;
+                m_Keys.push_back({KeyEvent::EndOfInput});
+                break;
+            }
+            //The escape timeout counts from the read that left a new incomplete sequence behind
+            size_t pending = m_Bytes.size();
+            m_Bytes.append(buf, (size_t)n);
+            decode();
+            if (!m_Bytes.empty() && (pending == 0 || m_Bytes.size() < pending + (size_t)n))
+                m_PendingSince = std::chrono::steady_clock::now();
+            timeoutMs = 0;
+        }
+
+        if (m_Keys.empty())
+            return false;
+        key = m_Keys.front();
+        m_Keys.pop_front();
+        if (key.kind == KeyEvent::EndOfInput)
+        {
+            //Ctrl-D and the end of the input both close it; later reads see it again
+            m_Closed = true;
+            m_Keys.clear();
+            m_Keys.push_back({KeyEvent::EndOfInput});
+        }
+        return true;
+    }
+
+    /****************************************** LineEditor ****************************************/
+
+    static std::string moveLeft(size_t n) { return n ? "\033[" + std::to_string(n) + "D" : ""; }
+    static std::string moveRight(size_t n) { return n ? "\033[" + std::to_string(n) + "C" : ""; }
+
+    bool LineEditor::feed(const KeyEvent &key, std::string &echo)
+    {
+        std::string tail;
+        switch (key.kind)
+        {
+        case KeyEvent::Char:
+            if (m_Buffer.size() >= m_MaxChars)
+                break;
+            m_Buffer.insert(m_Cursor++, 1, key.ch);
+            tail = m_Buffer.substr(m_Cursor);
+            echo += key.ch + tail + moveLeft(tail.size());
+            break;
+        case KeyEvent::Backspace:
+            if (m_Cursor == 0)
+                break;
+            m_Buffer.erase(--m_Cursor, 1);
+            tail = m_Buffer.substr(m_Cursor);
+            echo += "\b" + tail + " " + moveLeft(tail.size() + 1);
+            break;
+        case KeyEvent::Delete:
+            if (m_Cursor == m_Buffer.size())
+                break;
+            m_Buffer.erase(m_Cursor, 1);
+            tail = m_Buffer.substr(m_Cursor);
+            echo += tail + " " + moveLeft(tail.size() + 1);
+            break;
+        case KeyEvent::Left:
+            if (m_Cursor > 0)
+                echo += moveLeft(1), m_Cursor--;
+            break;
+        case KeyEvent::Right:
+            if (m_Cursor < m_Buffer.size())
+                echo += moveRight(1), m_Cursor++;
+            break;
+        case KeyEvent::Home:
+            echo += moveLeft(m_Cursor);
+            m_Cursor = 0;
+            break;
+        case KeyEvent::End:
+            echo += moveRight(m_Buffer.size() - m_Cursor);
+            m_Cursor = m_Buffer.size();
+            break;
+        case KeyEvent::Enter:
+        case KeyEvent::EndOfInput:
+            echo += "\n";
+            return true;
+        }
+        return false;
+    }
+
+    std::string LineEditor::render(const std::string &prefix) const
+    {
+        return "\r\033[2K" + prefix + m_Buffer + moveLeft(m_Buffer.size() - m_Cursor);
+    }
+
+    std::string LineEditor::take()
+    {
+        m_Cursor = 0;
+        return std::exchange(m_Buffer, {});
+    }
+
+    /******************************************** Console *****************************************/
+
+    //Keys are read at most this often while there is something else to simulate
+    static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(2);
+    //The status before the prompt is redrawn at most this often
+    static constexpr auto STATUS_INTERVAL = std::chrono::milliseconds(200);
+
+    Console::Console(sim::Time period) : m_Reader(KeyReader::standard()), m_Raw(STDIN_FILENO), m_Period(std::max<sim::Time>(1, period)) {}
+
+    Console::~Console() { stop(); }
+
+    void Console::start()
+    {
+        if (m_Running)
+            return;
+        m_Running = true;
+        sim::schedule(sim::now(), [this, stamp = ++m_Stamp]() { pump(stamp); });
+    }
+
+    void Console::stop()
+    {
+        m_Running = false;
+        m_Stamp++;
+    }
+
+    void Console::write(const std::string &out)
+    {
+        fwrite(out.data(), 1, out.size(), stdout);
+        fflush(stdout);
+    }
+
+    void Console::redraw()
+    {
+        std::string prefix = m_Status ? m_Status() + " " : "";
+        write(m_Editor.render(prefix + m_Prompt));
+        m_LastDraw = std::chrono::steady_clock::now();
+    }
+
+    void Console::print(const std::string &line)
+    {
+        //The line being edited is cleared, the text goes above it, and the line comes back
+        write("\r\033[2K" + line + "\n");
+        if (m_Waiter)
+            redraw();
+    }
+
+    void Console::pump(uint64_t stamp)
+    {
+        if (!m_Running || stamp != m_Stamp)
+            return;
+
+        //With nothing else to simulate, the console waits for the keyboard; otherwise it only looks now and then
+        auto now = std::chrono::steady_clock::now();
+        bool idle = sim::pendingEvents() == 0;
+        if (idle && !m_Waiter)
+        {
+            //Nothing left to simulate and nobody waiting for a line: the console lets the simulation end
+            m_Running = false;
+            return;
+        }
+        if (idle || now - m_LastPoll >= POLL_INTERVAL)
+        {
+            m_LastPoll = now;
+            KeyEvent key;
+            std::string echo;
+            bool done = false;
+            while (m_Waiter && !done && m_Reader.next(key, idle && echo.empty() ? -1 : 0))
+                done = m_Editor.feed(key, echo);
+            if (!echo.empty())
+                write(echo);
+
+            //The waiting coroutine is resumed as an event, like any other wake-up
+            if (done)
+            {
+                *m_Line = m_Editor.take();
+                sim::schedule(sim::now(), [h = std::exchange(m_Waiter, {})]() { h.resume(); });
+            }
+            else if (m_Waiter && m_Status && now - m_LastDraw >= STATUS_INTERVAL)
+                redraw();
+        }
+
+        sim::schedule(sim::now() + m_Period, [this, stamp]() { pump(stamp); });
+    }
+
+    void Console::LineAwaiter::await_suspend(std::coroutine_handle<> handle)
+    {
+        if (console->m_Waiter)
+            throw std::runtime_error("Only one coroutine at a time can wait for a console line");
+        console->m_Waiter = handle;
+        console->m_Line = &line;
+        console->m_Prompt = prompt;
+        console->redraw();
+    }
+}
@@ -0,0 +1,184 @@
+/**
+ * Header criado para ler o teclado sem bloquear a simulação
+ *
+ * KeyReader lê a entrada com poll()/read() (sem stdio) e decodifica as teclas, inclusive as sequências de escape
+ * das setas; LineEditor edita uma linha a partir dessas teclas, devolvendo o eco de cada uma. O tui::readline()
+ * bloqueante usa os dois (esperando em poll(), não em getchar()).
+ *
+ * Console liga a entrada ao laço de eventos: um evento periódico da simulação lê as teclas prontas (sem esperar)
+ * e retoma a corrotina que espera uma linha (co_await console.readLine(...)). Enquanto o usuário digita,
+ * o resto da simulação continua rodando na velocidade máxima; só quando não há mais nada a simular o evento
+ * espera pelo teclado.
+ *
+ *   sim::Task chat(tui::Console &console)
+ *   {
+ *       std::string line = co_await console.readLine("> ");
+ *       ...
+ *   }
+ */
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <string>
+
+#include <termios.h>
+
+#include "sim.hpp"
+
+namespace tui
+{
+    struct KeyEvent
+    {
+        enum Kind : uint8_t
+        {
+            Char,
+            Enter,
+            Backspace,
+            Delete,
+            Left,
+            Right,
+            Home,
+            End,
+            EndOfInput //Entrada fechada (fim do arquivo/pipe ou Ctrl-D)
+        } kind;
+        char ch = 0; //Char: o caractere digitado
+    };
+
+    //Desliga o modo canônico e o eco do terminal enquanto existir (nada muda se a entrada não é um terminal)
+    class RawMode
+    {
+    private:
+        int m_Fd;
+        bool m_Active = false;
+        termios m_Saved = {};
+
+    public:
+        explicit RawMode(int fd);
+        ~RawMode();
+
+        RawMode(const RawMode &) = delete;
+        RawMode &operator=(const RawMode &) = delete;
+    };
+
+    class KeyReader
+    {
+    private:
+        int m_Fd;
+        std::string m_Bytes;          //Bytes lidos e ainda não decodificados (ex.: uma sequência de escape pela metade)
+        std::chrono::steady_clock::time_point m_PendingSince; //Quando m_Bytes ficou com uma sequência pela metade
+        std::deque<KeyEvent> m_Keys;  //Teclas decodificadas e ainda não entregues
+        bool m_Closed = false;
+
+        void decode();
+
+    public:
+        explicit KeyReader(int fd);
+
+        /**
+         * Método que entrega a próxima tecla, esperando no máximo timeoutMs por ela
+         *
+         * Parâmetros:	KeyEvent &key	=>	Tecla lida
+         * 				int timeoutMs	=>	Espera máxima (0: não espera; -1: espera sem limite)
+         *
+         * Retorno: bool	=>	Se havia uma tecla
+         */
+        bool next(KeyEvent &key, int timeoutMs);
+
+        bool closed() const { return m_Closed && m_Keys.empty(); }
+
+        //Leitor da entrada padrão (compartilhado: teclas digitadas adiante não se perdem entre leituras)
+        static KeyReader &standard();
+    };
+
+    class LineEditor
+    {
+    private:
+        std::string m_Buffer;
+        size_t m_Cursor = 0;
+        size_t m_MaxChars;
+
+    public:
+        explicit LineEditor(size_t maxChars = 4096) : m_MaxChars(maxChars) {}
+
+        /**
+         * Método que aplica uma tecla à linha
+         *
+         * Parâmetros:	const KeyEvent &key	=>	Tecla
+         * 				std::string &echo	=>	Recebe o que escrever no terminal para mostrar a mudança (a partir do cursor)
+         *
+         * Retorno: bool	=>	Se a linha terminou (Enter ou fim da entrada)
+         */
+        bool feed(const KeyEvent &key, std::string &echo);
+
+        //Sequência que redesenha a linha inteira (prefixo + texto) e põe o cursor no lugar
+        std::string render(const std::string &prefix) const;
+
+        const std::string &text() const { return m_Buffer; }
+
+        //Devolve a linha e começa uma nova
+        std::string take();
+    };
+
+    class Console
+    {
+    private:
+        KeyReader &m_Reader;
+        RawMode m_Raw;
+        LineEditor m_Editor;
+
+        sim::Time m_Period;
+        bool m_Running = false;
+        uint64_t m_Stamp = 0; //Invalida o evento de leitura agendado por um start anterior
+
+        std::string m_Prompt;
+        std::function<std::string()> m_Status;
+        std::chrono::steady_clock::time_point m_LastPoll, m_LastDraw;
+
+        //Corrotina esperando uma linha e onde guardar a linha
+        std::coroutine_handle<> m_Waiter;
+        std::string *m_Line = nullptr;
+
+        void pump(uint64_t stamp);
+        void redraw();
+        void write(const std::string &out);
+
+    public:
+        /**
+         * Construtor do console sobre a entrada padrão
+         *
+         * Parâmetros: sim::Time period	=>	Intervalo (simulado) entre as leituras do teclado
+         */
+        explicit Console(sim::Time period = 100 * sim::MICROSECOND);
+        ~Console();
+
+        //Começa/para de ler o teclado como um evento periódico da simulação
+        void start();
+        void stop();
+
+        //Texto mostrado antes do prompt, atualizado algumas vezes por segundo (ex.: o relógio simulado)
+        void setStatus(std::function<std::string()> status) { m_Status = std::move(status); }
+
+        //Escreve uma linha acima da linha sendo editada
+        void print(const std::string &line);
+
+        //A entrada foi fechada (readLine passa a devolver linhas vazias imediatamente)
+        bool closed() const { return m_Reader.closed(); }
+
+        struct LineAwaiter
+        {
+            Console *console;
+            std::string prompt;
+            std::string line;
+
+            bool await_ready() const { return console->closed(); }
+            void await_suspend(std::coroutine_handle<> handle);
+            std::string await_resume() { return std::move(line); }
+        };
+
+        //Espera o usuário digitar uma linha (co_await dentro de uma sim::Task; uma corrotina por vez)
+        LineAwaiter readLine(std::string prompt) { return {this, std::move(prompt), {}}; }
+    };
+}
@@ -0,0 +1,122 @@
+/**
+ * Header auxiliar com o cabeçalho IPv4 carregado no payload de um Ether2Frame (ethertype 0x0800)
+ *
+ * Endereços são uint32_t na ordem do host (10.0.0.1 == 0x0A000001); no payload, o cabeçalho fica na ordem
+ * da rede, como no fio. Só o cabeçalho de 20 bytes é gerado (sem opções), mas IHL maiores são aceitos.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "crc_32.hpp"
+#include "frame.hpp"
+
+namespace ipv4
+{
+    constexpr uint16_t ETHERTYPE = 0x0800;
+    constexpr size_t HEADER_SIZE = 20;
+    constexpr uint8_t DEFAULT_TTL = 64;
+
+    //Posição dos campos no cabeçalho
+    enum Field : size_t
+    {
+        VERSION_IHL = 0,
+        TOTAL_LENGTH = 2,
+        TTL = 8,
+        PROTOCOL = 9,
+        CHECKSUM = 10,
+        SOURCE = 12,
+        DESTINATION = 16
+    };
+
+    inline uint16_t load16(const uint8_t *p) { return (uint16_t)(p[0] << 8 | p[1]); }
+    inline uint32_t load32(const uint8_t *p) { return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]; }
+    inline void store16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)(v >> 8), p[1] = (uint8_t)v; }
+    inline void store32(uint8_t *p, uint32_t v) { p[0] = (uint8_t)(v >> 24), p[1] = (uint8_t)(v >> 16), p[2] = (uint8_t)(v >> 8), p[3] = (uint8_t)v; }
+
+    //Tamanho do cabeçalho em bytes (IHL * 4)
+    inline size_t headerLength(const uint8_t *header) { return (size_t)(header[VERSION_IHL] & 0x0F) * 4; }
+
+    //Checksum do cabeçalho (RFC 791): com o campo de checksum preenchido, o resultado de um cabeçalho íntegro é 0
+    inline uint16_t checksum(const uint8_t *header, size_t length) { return (uint16_t)InternetChecksum(header, length); }
+
+    //Versão 4, IHL entre 5 e 15 (dentro do payload) e checksum correto
+    inline bool valid(const uint8_t *header, size_t available)
+    {
+        size_t length = headerLength(header);
+        return (header[VERSION_IHL] >> 4) == 4 && length >= HEADER_SIZE && length <= available && checksum(header, length) == 0;
+    }
+
+    /**
+     * Função que decrementa o TTL e atualiza o checksum de forma incremental (RFC 1624), sem somar o cabeçalho de novo
+     *
+     * Parâmetros: uint8_t *header	=>	Cabeçalho (já validado, com TTL > 0)
+     *
+     * Retorno: void
+     */
+    inline void decrementTtl(uint8_t *header)
+    {
+        //The TTL is the high byte of its 16-bit word, so the word drops by 0x0100: HC' = ~(~HC + ~m + m')
+        uint16_t word = load16(header + TTL);
+        uint16_t updated = (uint16_t)(word - 0x0100);
+        uint32_t sum = (uint16_t)~load16(header + CHECKSUM) + (uint32_t)(uint16_t)~word + updated;
+        sum = (sum & 0xFFFF) + (sum >> 16);
+        sum = (sum & 0xFFFF) + (sum >> 16);
+        store16(header + TTL, updated);
+        store16(header + CHECKSUM, (uint16_t)~sum);
+    }
+
+    //Endereço em texto ("10.0.0.1")
+    inline std::string toString(uint32_t address)
+    {
+        return std::to_string(address >> 24) + "." + std::to_string(address >> 16 & 0xFF) + "." + std::to_string(address >> 8 & 0xFF) + "." +
+               std::to_string(address & 0xFF);
+    }
+
+    //Endereço a partir do texto (lança std::invalid_argument se não for um endereço IPv4)
+    inline uint32_t parse(const std::string &text)
+    {
+        unsigned a, b, c, d;
+        char end;
+        if (sscanf(text.c_str(), "%u.%u.%u.%u%c", &a, &b, &c, &d, &end) != 4 || a > 255 || b > 255 || c > 255 || d > 255)
+            throw std::invalid_argument("Invalid IPv4 address: " + text);
+        return a << 24 | b << 16 | c << 8 | d;
+    }
+
+    //Máscara de um prefixo de 'length' bits
+    inline uint32_t mask(unsigned length) { return length ? ~0u << (32 - length) : 0; }
+
+    /**
+     * Função que monta um frame com um pacote IPv4 (cabeçalho de 20 bytes + dados)
+     *
+     * Parâmetros:	const MAC &dst, &src			=>	MACs do enlace (o próximo salto e quem envia)
+     * 				uint32_t source, destination	=>	Endereços IPv4
+     * 				const char *data, size_t size	=>	Dados (truncados para caber no payload)
+     * 				uint8_t ttl						=>	TTL inicial
+     *
+     * Retorno: Ether2Frame	=>	Frame com ethertype IPv4 e o verificador da política P
+     */
+    template <error_control::Policy P>
+    Ether2Frame packet(const MAC &dst, const MAC &src, uint32_t source, uint32_t destination, const char *data, size_t size, uint8_t ttl = DEFAULT_TTL)
+    {
+        uint8_t bytes[Ether2Frame::PAYLOAD_SIZE] = {};
+        size = std::min(size, sizeof(bytes) - 1 - HEADER_SIZE);
+        bytes[VERSION_IHL] = 0x45;
+        store16(bytes + TOTAL_LENGTH, (uint16_t)(HEADER_SIZE + size));
+        bytes[TTL] = ttl;
+        bytes[PROTOCOL] = 253; //Experimental (RFC 3692)
+        store32(bytes + SOURCE, source);
+        store32(bytes + DESTINATION, destination);
+        store16(bytes + CHECKSUM, checksum(bytes, HEADER_SIZE));
+        memcpy(bytes + HEADER_SIZE, data, size);
+
+        Ether2Frame frame(dst, src, (const char *)bytes, HEADER_SIZE + size, P{});
+        frame.type = ETHERTYPE;
+        return frame;
+    }
+}
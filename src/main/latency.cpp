@@ -0,0 +1,137 @@
+#include "latency.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+#include "mac.hpp"
+
+namespace latency
+{
+    void Histogram::reset() { *this = Histogram(); }
+
+    void Histogram::merge(const Histogram &other)
+    {
+        for (size_t i = 0; i < BUCKETS; i++)
+            m_Counts[i] += other.m_Counts[i];
+        m_Count += other.m_Count;
+        m_Sum += other.m_Sum;
+        m_Min = std::min(m_Min, other.m_Min);
+        m_Max = std::max(m_Max, other.m_Max);
+    }
+
+    uint64_t Histogram::lowerBound(size_t index)
+    {
+        if (index < (1ull << SUB_BITS))
+            return index;
+
+        unsigned exponent = (index >> SUB_BITS) + SUB_BITS - 1;
+        uint64_t sub = index & ((1ull << SUB_BITS) - 1);
+        return ((1ull << SUB_BITS) + sub) << (exponent - SUB_BITS);
+    }
+
+    uint64_t Histogram::percentile(double q) const
+    {
+        if (m_Count == 0)
+            return 0;
+
+        uint64_t target = (uint64_t)(q * m_Count + 0.5);
+        target = std::clamp<uint64_t>(target, 1, m_Count);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++)
+        {
+            seen += m_Counts[i];
+            if (seen >= target)
+            {
+                uint64_t low = lowerBound(i);
+                uint64_t high = i + 1 < BUCKETS ? lowerBound(i + 1) - 1 : low;
+                return std::clamp<uint64_t>(low + (high - low) / 2, min(), max());
+            }
+        }
+        return m_Max;
+    }
+
+    Summary summarize(const Histogram &h)
+    {
+        return {h.count(), h.min(), h.max(), h.mean(), h.percentile(0.5), h.percentile(0.99), h.percentile(0.999)};
+    }
+
+    void printSummary(std::ostream &out, const std::string &label, const Summary &s)
+    {
+        auto us = [](double ns) { return ns / 1000.0; };
+        out << std::dec << std::fixed << std::setprecision(2)
+            << label << ": n=" << s.count
+            << " min=" << us(s.min) << "us"
+            << " p50=" << us(s.p50) << "us"
+            << " p99=" << us(s.p99) << "us"
+            << " p99.9=" << us(s.p999) << "us"
+            << " max=" << us(s.max) << "us"
+            << " mean=" << us(s.mean) << "us" << std::endl;
+    }
+
+    /****************************************** Fluxos ****************************************/
+
+    FlowTable::FlowTable(size_t capacity) : m_Flows(capacity) {}
+
+    FlowStats &FlowTable::get(uint64_t src, uint64_t dst)
+    {
+        size_t capacity = m_Flows.size();
+        size_t slot = std::hash<uint64_t>()(src * 0x9E3779B97F4A7C15ull ^ dst) % capacity;
+
+        //Linear probing: stops at the flow or at the first free slot
+        for (size_t probe = 0; probe < capacity; probe++)
+        {
+            FlowStats &f = m_Flows[(slot + probe) % capacity];
+            if (f.used && f.src == src && f.dst == dst)
+                return f;
+            if (!f.used)
+            {
+                f.used = true;
+                f.src = src;
+                f.dst = dst;
+                return f;
+            }
+        }
+        return m_Overflow;
+    }
+
+    void FlowTable::reset()
+    {
+        for (FlowStats &f : m_Flows)
+            f = FlowStats();
+        m_Overflow = FlowStats();
+    }
+
+    FlowTable &flows()
+    {
+        static FlowTable table;
+        return table;
+    }
+
+    static bool __wall_clock = false;
+
+    void setWallClock(bool enabled) { __wall_clock = enabled; }
+    bool wallClockEnabled() { return __wall_clock; }
+
+    uint64_t wallNow()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void printFlowReport(std::ostream &out)
+    {
+        auto report = [&](const FlowStats &f, const std::string &label) {
+            printSummary(out, label + " (sim)", summarize(f.endToEnd));
+            if (f.endToEndWall.count())
+                printSummary(out, label + " (wall)", summarize(f.endToEndWall));
+        };
+
+        for (const FlowStats &f : flows().flows())
+            if (f.used && f.endToEnd.count())
+                report(f, MAC(f.src).to_string() + " -> " + MAC(f.dst).to_string());
+
+        if (flows().overflow().endToEnd.count())
+            report(flows().overflow(), "other flows");
+    }
+}
@@ -0,0 +1,122 @@
+/**
+ * Header criado para registrar distribuições de latência (por salto e fim-a-fim)
+ *
+ * Os histogramas são log-lineares (estilo HDR): cada potência de 2 é dividida em 2^SUB_BITS
+ * sub-faixas lineares, o que dá erro relativo máximo de 1/2^SUB_BITS com memória fixa.
+ * Registrar um valor é um cálculo de índice e um incremento: nenhuma alocação no caminho quente.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "sim.hpp"
+
+namespace latency
+{
+    class Histogram
+    {
+    public:
+        static constexpr unsigned SUB_BITS = 5;  //32 sub-faixas por potência de 2 (~3% de erro)
+        static constexpr unsigned MAX_BITS = 42; //Valores até 2^42 ns (~73 minutos), acima disso são saturados
+        static constexpr size_t BUCKETS = (size_t)(MAX_BITS - SUB_BITS + 1) << SUB_BITS;
+
+        inline void record(uint64_t value)
+        {
+            m_Counts[indexOf(value)]++;
+            m_Count++;
+            m_Sum += value;
+            if (value < m_Min)
+                m_Min = value;
+            if (value > m_Max)
+                m_Max = value;
+        }
+
+        void reset();
+        void merge(const Histogram &other);
+
+        uint64_t count() const { return m_Count; }
+        uint64_t min() const { return m_Count ? m_Min : 0; }
+        uint64_t max() const { return m_Max; }
+        double mean() const { return m_Count ? (double)m_Sum / m_Count : 0; }
+
+        //Valor abaixo do qual estão 'q' (0..1) das amostras (ponto médio da faixa, limitado por min/max)
+        uint64_t percentile(double q) const;
+
+        static inline size_t indexOf(uint64_t value)
+        {
+            if (value >= (1ull << MAX_BITS))
+                value = (1ull << MAX_BITS) - 1;
+            if (value < (1ull << SUB_BITS))
+                return value;
+
+            unsigned exponent = 63 - __builtin_clzll(value);
+            uint64_t sub = (value >> (exponent - SUB_BITS)) - (1ull << SUB_BITS);
+            return ((size_t)(exponent - SUB_BITS + 1) << SUB_BITS) | sub;
+        }
+
+        //Menor valor que cai na faixa 'index'
+        static uint64_t lowerBound(size_t index);
+
+    private:
+        std::array<uint64_t, BUCKETS> m_Counts{};
+        uint64_t m_Count = 0, m_Sum = 0;
+        uint64_t m_Min = UINT64_MAX, m_Max = 0;
+    };
+
+    //Resumo de um histograma (valores em ns)
+    struct Summary
+    {
+        uint64_t count, min, max;
+        double mean;
+        uint64_t p50, p99, p999;
+    };
+
+    Summary summarize(const Histogram &h);
+    void printSummary(std::ostream &out, const std::string &label, const Summary &s);
+
+    //Estatísticas de um fluxo (par origem -> destino)
+    struct FlowStats
+    {
+        uint64_t src = 0, dst = 0;
+        bool used = false;
+        Histogram endToEnd;     //Tempo simulado
+        Histogram endToEndWall; //Tempo de parede (apenas se habilitado)
+    };
+
+    /**
+     * Tabela de fluxos de capacidade fixa (endereçamento aberto), pré-alocada:
+     * encontrar/criar um fluxo nunca aloca. Fluxos além da capacidade são somados no fluxo de transbordo.
+     */
+    class FlowTable
+    {
+    public:
+        FlowTable(size_t capacity = 64);
+
+        FlowStats &get(uint64_t src, uint64_t dst);
+        void reset();
+
+        const std::vector<FlowStats> &flows() const { return m_Flows; }
+        const FlowStats &overflow() const { return m_Overflow; }
+
+    private:
+        std::vector<FlowStats> m_Flows;
+        FlowStats m_Overflow;
+    };
+
+    //Tabela global de fluxos, alimentada pelos hosts de destino
+    FlowTable &flows();
+
+    //Habilita o carimbo de tempo de parede na origem (desabilitado por padrão: custa uma leitura de relógio por frame)
+    void setWallClock(bool enabled);
+    bool wallClockEnabled();
+
+    //Tempo de parede monotônico, em ns
+    uint64_t wallNow();
+
+    //Imprime o resumo de todos os fluxos com amostras
+    void printFlowReport(std::ostream &out);
+}
@@ -0,0 +1,146 @@
+#include "lpm.hpp"
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+#include <sys/mman.h>
+
+namespace lpm
+{
+    static uint32_t prefixMask(unsigned length) { return length ? ~0u << (32 - length) : 0; }
+    static uint64_t ruleKey(uint32_t prefix, unsigned length) { return (uint64_t)length << 32 | prefix; }
+
+    Dir24_8::Dir24_8()
+    {
+        //Anonymous pages read as zero (no route) and only take memory once written
+        void *table = mmap(nullptr, TBL24_SIZE * sizeof(uint32_t), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (table == MAP_FAILED)
+            throw std::bad_alloc();
+        m_Tbl24 = static_cast<uint32_t *>(table);
+    }
+
+    Dir24_8::~Dir24_8() { munmap(m_Tbl24, TBL24_SIZE * sizeof(uint32_t)); }
+
+    uint32_t Dir24_8::allocateGroup(uint32_t fill)
+    {
+        uint32_t group;
+        if (!m_FreeGroups.empty())
+        {
+            group = m_FreeGroups.back();
+            m_FreeGroups.pop_back();
+        }
+        else
+        {
+            group = (uint32_t)(m_Tbl8.size() / GROUP_SIZE);
+            if (group > VALUE_MASK)
+                throw std::length_error("DIR-24-8: out of tbl8 groups");
+            m_Tbl8.resize(m_Tbl8.size() + GROUP_SIZE);
+        }
+        std::fill_n(m_Tbl8.begin() + (size_t)group * GROUP_SIZE, GROUP_SIZE, fill);
+        return group;
+    }
+
+    void Dir24_8::write(uint32_t prefix, unsigned depth, uint32_t value, bool removing)
+    {
+        auto replace = [&](uint32_t &e) {
+            bool owned = removing ? (e & VALID) && depthOf(e) == depth : !(e & VALID) || depthOf(e) <= depth;
+            if (owned)
+                e = value;
+        };
+
+        if (depth <= 24)
+        {
+            size_t first = prefix >> 8, count = (size_t)1 << (24 - depth);
+            for (size_t i = first; i < first + count; i++)
+            {
+                uint32_t &e = m_Tbl24[i];
+                if (!(e & EXTENDED))
+                {
+                    replace(e);
+                    continue;
+                }
+                //Longer prefixes below this /24 keep their entries; the others inherit the new route
+                uint32_t *group = &m_Tbl8[(size_t)(e & VALUE_MASK) * GROUP_SIZE];
+                for (size_t j = 0; j < GROUP_SIZE; j++)
+                    replace(group[j]);
+            }
+            return;
+        }
+
+        size_t index = prefix >> 8;
+        if (!(m_Tbl24[index] & EXTENDED))
+        {
+            if (removing)
+                return;
+            m_Tbl24[index] = EXTENDED | allocateGroup(m_Tbl24[index]);
+        }
+
+        uint32_t group = m_Tbl24[index] & VALUE_MASK;
+        uint32_t *entries = &m_Tbl8[(size_t)group * GROUP_SIZE];
+        size_t first = prefix & 0xFF, count = (size_t)1 << (32 - depth);
+        for (size_t j = first; j < first + count; j++)
+            replace(entries[j]);
+
+        //A group left with a single route of at most 24 bits folds back into tbl24
+        if (removing && std::all_of(entries, entries + GROUP_SIZE, [&](uint32_t e) { return e == entries[0]; }) &&
+            (!(entries[0] & VALID) || depthOf(entries[0]) <= 24))
+        {
+            m_Tbl24[index] = entries[0];
+            m_FreeGroups.push_back(group);
+        }
+    }
+
+    uint32_t Dir24_8::covering(uint32_t prefix, unsigned depth) const
+    {
+        for (unsigned length = depth - 1; length > 0; length--)
+        {
+            auto it = m_Rules.find(ruleKey(prefix & prefixMask(length), length));
+            if (it != m_Rules.end())
+                return entry(it->second, length);
+        }
+        return 0;
+    }
+
+    void Dir24_8::insert(uint32_t prefix, unsigned length, uint32_t nextHop)
+    {
+        if (length > 32)
+            throw std::invalid_argument("DIR-24-8: prefix length above 32");
+        if (nextHop > MAX_NEXT_HOP)
+            throw std::invalid_argument("DIR-24-8: next hop above MAX_NEXT_HOP");
+
+        prefix &= prefixMask(length);
+        m_Rules[ruleKey(prefix, length)] = nextHop;
+        if (length == 0)
+            m_Default = nextHop;
+        else
+            write(prefix, length, entry(nextHop, length), false);
+    }
+
+    bool Dir24_8::remove(uint32_t prefix, unsigned length)
+    {
+        if (length > 32)
+            return false;
+        prefix &= prefixMask(length);
+        if (!m_Rules.erase(ruleKey(prefix, length)))
+            return false;
+
+        if (length == 0)
+            m_Default = NO_ROUTE;
+        else
+            write(prefix, length, covering(prefix, length), true);
+        return true;
+    }
+
+    void Dir24_8::lookup(std::span<const uint32_t> addresses, std::span<uint32_t> nextHops) const
+    {
+        constexpr size_t AHEAD = 8;
+        size_t n = std::min(addresses.size(), nextHops.size());
+        for (size_t i = 0; i < n; i++)
+        {
+            if (i + AHEAD < n)
+                __builtin_prefetch(&m_Tbl24[addresses[i + AHEAD] >> 8]);
+            nextHops[i] = lookup(addresses[i]);
+        }
+    }
+}
@@ -0,0 +1,94 @@
+/**
+ * Header criado para a busca do prefixo mais longo (LPM) de endereços IPv4 com a estrutura DIR-24-8
+ *
+ * tbl24 tem uma entrada por prefixo /24 (2^24 entradas): para rotas de até 24 bits, a resposta está nela,
+ * em um único acesso à memória. Um /24 coberto por rotas mais longas aponta para um grupo de 256 entradas em tbl8,
+ * indexado pelo último byte do endereço (no máximo dois acessos). Cada entrada guarda o tamanho do prefixo que a
+ * preencheu, então as rotas podem ser inseridas e removidas em qualquer ordem.
+ *
+ * tbl24 é reservada com mmap e as páginas só ocupam memória quando escritas; a rota padrão (/0) fica fora dela,
+ * para que uma tabela pequena com rota padrão não toque os 64 MiB inteiros.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace lpm
+{
+    //Próximo salto de um endereço sem rota
+    constexpr uint32_t NO_ROUTE = ~0u;
+    //Maior identificador de próximo salto (24 bits)
+    constexpr uint32_t MAX_NEXT_HOP = (1u << 24) - 1;
+
+    class Dir24_8
+    {
+    private:
+        //Entrada: válida | estendida (aponta para um grupo de tbl8) | tamanho do prefixo (6 bits) | próximo salto ou grupo (24 bits)
+        static constexpr uint32_t VALID = 1u << 31;
+        static constexpr uint32_t EXTENDED = 1u << 30;
+        static constexpr unsigned DEPTH_SHIFT = 24;
+        static constexpr uint32_t VALUE_MASK = (1u << 24) - 1;
+        static constexpr size_t TBL24_SIZE = 1u << 24;
+        static constexpr size_t GROUP_SIZE = 256;
+
+        static uint32_t entry(uint32_t nextHop, unsigned depth) { return VALID | depth << DEPTH_SHIFT | nextHop; }
+        static unsigned depthOf(uint32_t e) { return e >> DEPTH_SHIFT & 0x3F; }
+
+        uint32_t *m_Tbl24 = nullptr;
+        std::vector<uint32_t> m_Tbl8;
+        std::vector<uint32_t> m_FreeGroups;
+
+        //Rotas inseridas ((tamanho << 32) | prefixo -> próximo salto), para reconstruir a cobertura ao remover
+        std::unordered_map<uint64_t, uint32_t> m_Rules;
+        uint32_t m_Default = NO_ROUTE;
+
+        uint32_t allocateGroup(uint32_t fill);
+        //Escreve 'value' nas entradas do prefixo preenchidas por prefixos mais curtos (inserção) ou pelo próprio prefixo (remoção)
+        void write(uint32_t prefix, unsigned depth, uint32_t value, bool removing);
+        //Regra que passa a cobrir o prefixo quando ele é removido (a mais longa entre as mais curtas)
+        uint32_t covering(uint32_t prefix, unsigned depth) const;
+
+    public:
+        Dir24_8();
+        ~Dir24_8();
+
+        Dir24_8(const Dir24_8 &) = delete;
+        Dir24_8 &operator=(const Dir24_8 &) = delete;
+
+        /**
+         * Método que insere (ou substitui) uma rota
+         *
+         * Parâmetros:	uint32_t prefix		=>	Prefixo (os bits além de 'length' são ignorados)
+         * 				unsigned length		=>	Tamanho do prefixo (0 a 32)
+         * 				uint32_t nextHop	=>	Identificador do próximo salto (até MAX_NEXT_HOP)
+         *
+         * Retorno: void
+         */
+        void insert(uint32_t prefix, unsigned length, uint32_t nextHop);
+
+        //Remove uma rota (retorna se ela existia)
+        bool remove(uint32_t prefix, unsigned length);
+
+        //Próximo salto do prefixo mais longo que contém o endereço (NO_ROUTE se nenhum)
+        inline uint32_t lookup(uint32_t address) const
+        {
+            uint32_t e = m_Tbl24[address >> 8];
+            if (e & EXTENDED)
+                e = m_Tbl8[(size_t)(e & VALUE_MASK) * GROUP_SIZE + (address & 0xFF)];
+            return (e & VALID) ? (e & VALUE_MASK) : m_Default;
+        }
+
+        //Busca em lote: os acessos a tbl24 são adiantados (prefetch) para esconder as faltas de cache
+        void lookup(std::span<const uint32_t> addresses, std::span<uint32_t> nextHops) const;
+
+        size_t size() const { return m_Rules.size(); }
+        size_t groups() const { return m_Tbl8.size() / GROUP_SIZE - m_FreeGroups.size(); }
+
+        //Memória das tabelas: tbl24 inteira (reservada) e os grupos de tbl8
+        size_t memoryBytes() const { return TBL24_SIZE * sizeof(uint32_t) + m_Tbl8.capacity() * sizeof(uint32_t); }
+    };
+}
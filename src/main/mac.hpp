@@ -13,6 +13,9 @@
 
 struct MAC
 {
+    //Endereço de broadcast (FF:FF:FF:FF:FF:FF)
+    static constexpr uint64_t BROADCAST = 0xFFFFFFFFFFFF;
+
     uint64_t bytes;
 
     //Transforma o endereço MAC em uma string
@@ -29,6 +32,11 @@ struct MAC
 
     bool operator==(const MAC &other) const;
 
+    //Endereço de broadcast
+    inline bool isBroadcast() const { return bytes == BROADCAST; }
+    //Endereço de grupo (bit I/G, o menos significativo do primeiro octeto); o broadcast também é de grupo
+    inline bool isMulticast() const { return (bytes >> 40) & 1; }
+
     //Tranformas suas partes em bytes, facilitando comparação
     static uint64_t partsToBytes(const MAC_PARTS &parts);
 
@@ -0,0 +1,192 @@
+#include "mac_table.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace mactable
+{
+    uint64_t ShardedTable::hash(uint64_t key)
+    {
+        //Fibonacci hashing after a xor-shift: the top bits pick the shard, the low bits the slot
+        key ^= key >> 29;
+        return key * 0x9E3779B97F4A7C15ull;
+    }
+
+    ShardedTable::ShardedTable(size_t capacity, unsigned shards)
+    {
+        unsigned count = std::bit_ceil(std::max(1u, shards));
+        m_ShardBits = (unsigned)std::countr_zero(count);
+        m_ShardCapacity = (uint32_t)std::max<size_t>(1, (capacity + count - 1) / count);
+
+        //At most half of the slots in use keeps the probe sequences short
+        uint64_t slots = std::bit_ceil((uint64_t)m_ShardCapacity * 2);
+        m_SlotMask = slots - 1;
+
+        m_Shards = std::make_unique<Shard[]>(count);
+        for (unsigned s = 0; s < count; s++)
+            m_Shards[s].slots = std::make_unique<Slot[]>(slots);
+    }
+
+    uint64_t ShardedTable::probe(const Shard &shard, uint64_t key, uint64_t h) const
+    {
+        for (uint64_t i = h & m_SlotMask;; i = (i + 1) & m_SlotMask)
+        {
+            uint64_t k = shard.slots[i].key.load(std::memory_order_relaxed);
+            if (k == key || k == EMPTY)
+                return i;
+        }
+    }
+
+    bool ShardedTable::lookup(uint64_t key, Entry &entry) const
+    {
+        uint64_t h = hash(key);
+        const Shard &shard = shardOf(h);
+        while (true)
+        {
+            uint32_t before = shard.sequence.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+
+            //The probe never runs forever: the table is at most half full while no writer is moving entries,
+            //and a torn read during a move is bounded by the mask and discarded below
+            bool found = false;
+            uint64_t value = 0;
+            uint64_t i = h & m_SlotMask;
+            for (uint64_t n = 0; n <= m_SlotMask; n++, i = (i + 1) & m_SlotMask)
+            {
+                uint64_t k = shard.slots[i].key.load(std::memory_order_relaxed);
+                if (k == EMPTY)
+                    break;
+                if (k == key)
+                {
+                    value = shard.slots[i].value.load(std::memory_order_relaxed);
+                    found = true;
+                    break;
+                }
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (shard.sequence.load(std::memory_order_relaxed) != before)
+                continue;
+            if (found)
+                entry = unpack(value);
+            return found;
+        }
+    }
+
+    bool ShardedTable::learn(uint64_t key, uint16_t interface, uint64_t currentTime)
+    {
+        uint64_t h = hash(key);
+        Shard &shard = shardOf(h);
+        uint64_t value = pack({interface, currentTime});
+
+        //Most frames come from known stations on the same port within the same tick: nothing to write
+        Entry known;
+        if (lookup(key, known) && known.interface == interface && known.lastUpdate == currentTime)
+            return false;
+
+        std::lock_guard<std::mutex> lock(shard.writer);
+        uint64_t i = probe(shard, key, h);
+        if (shard.slots[i].key.load(std::memory_order_relaxed) == key)
+        {
+            //A refresh moves nothing, so readers see either the old or the new value
+            shard.slots[i].value.store(value, std::memory_order_relaxed);
+            return false;
+        }
+
+        //Full shard: the entry updated the longest time ago leaves (like the Switch does for the whole table)
+        if (shard.size.load(std::memory_order_relaxed) >= m_ShardCapacity)
+        {
+            uint64_t oldest = 0, oldestTime = ~0ull;
+            for (uint64_t s = 0; s <= m_SlotMask; s++)
+            {
+                if (shard.slots[s].key.load(std::memory_order_relaxed) == EMPTY)
+                    continue;
+                uint64_t t = unpack(shard.slots[s].value.load(std::memory_order_relaxed)).lastUpdate;
+                if (t < oldestTime)
+                    oldest = s, oldestTime = t;
+            }
+            erase(shard, oldest);
+            i = probe(shard, key, h);
+        }
+
+        uint32_t sequence = shard.sequence.load(std::memory_order_relaxed);
+        shard.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        shard.slots[i].value.store(value, std::memory_order_relaxed);
+        shard.slots[i].key.store(key, std::memory_order_relaxed);
+        shard.sequence.store(sequence + 2, std::memory_order_release);
+        shard.size.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void ShardedTable::erase(Shard &shard, uint64_t i)
+    {
+        uint32_t sequence = shard.sequence.load(std::memory_order_relaxed);
+        shard.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        //Backward-shift deletion: later entries of the run move into the hole if their home is not between it and them
+        uint64_t hole = i;
+        for (uint64_t j = (i + 1) & m_SlotMask;; j = (j + 1) & m_SlotMask)
+        {
+            uint64_t k = shard.slots[j].key.load(std::memory_order_relaxed);
+            if (k == EMPTY)
+                break;
+            uint64_t home = hash(k) & m_SlotMask;
+            if (((j - home) & m_SlotMask) >= ((j - hole) & m_SlotMask))
+            {
+                shard.slots[hole].key.store(k, std::memory_order_relaxed);
+                shard.slots[hole].value.store(shard.slots[j].value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                hole = j;
+            }
+        }
+        shard.slots[hole].key.store(EMPTY, std::memory_order_relaxed);
+
+        shard.sequence.store(sequence + 2, std::memory_order_release);
+        shard.size.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    bool ShardedTable::erase(uint64_t key)
+    {
+        uint64_t h = hash(key);
+        Shard &shard = shardOf(h);
+        std::lock_guard<std::mutex> lock(shard.writer);
+        uint64_t i = probe(shard, key, h);
+        if (shard.slots[i].key.load(std::memory_order_relaxed) != key)
+            return false;
+        erase(shard, i);
+        return true;
+    }
+
+    size_t ShardedTable::age(uint64_t currentTime, uint64_t ttl)
+    {
+        size_t removed = 0;
+        for (unsigned s = 0; s < shards(); s++)
+        {
+            Shard &shard = m_Shards[s];
+            std::lock_guard<std::mutex> lock(shard.writer);
+            //An erase may shift a later entry into slot i, so i is checked again before moving on
+            for (uint64_t i = 0; i <= m_SlotMask;)
+            {
+                uint64_t k = shard.slots[i].key.load(std::memory_order_relaxed);
+                if (k != EMPTY && currentTime - unpack(shard.slots[i].value.load(std::memory_order_relaxed)).lastUpdate > ttl)
+                {
+                    erase(shard, i);
+                    removed++;
+                }
+                else
+                    i++;
+            }
+        }
+        return removed;
+    }
+
+    size_t ShardedTable::size() const
+    {
+        size_t total = 0;
+        for (unsigned s = 0; s < shards(); s++)
+            total += m_Shards[s].size.load(std::memory_order_relaxed);
+        return total;
+    }
+}
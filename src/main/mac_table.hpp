@@ -0,0 +1,121 @@
+/**
+ * Header criado para uma tabela de MACs que pode ser lida por várias threads de ingresso ao mesmo tempo
+ *
+ * Modela os switches com vários pipelines (um por grupo de portas, como nos ASICs): a tabela é dividida em
+ * shards pelo hash da chave, cada um com endereçamento aberto (sondagem linear) em um vetor de tamanho fixo.
+ *
+ * Leituras não travam: o leitor lê o contador de sequência do shard (seqlock), procura a chave e relê o contador;
+ * se um escritor mexeu no shard nesse meio tempo, a leitura é refeita. Escritores (aprendizado e envelhecimento)
+ * travam só o shard que alteram. Renovar uma entrada que já existe na mesma porta não move nada no shard, então
+ * é uma escrita atômica do valor, sem invalidar os leitores; só inserções e remoções incrementam a sequência.
+ *
+ * A chave é a mesma do Switch ((VID << 48) | MAC) e o tempo é o relógio da tabela (ms), então o TTL é
+ * verificado por quem consulta, como em Switch::lookup.
+ *
+ * O Switch da simulação continua com a sua tabela própria: a simulação roda em uma thread só (o laço de eventos),
+ * então esta tabela é a estrutura para um ingresso com várias threads, medida isoladamente em bench mactable.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace mactable
+{
+    struct Entry
+    {
+        uint16_t interface;
+        uint64_t lastUpdate;
+    };
+
+    class ShardedTable
+    {
+    private:
+        //Chave de um slot vazio (VID 0xFFFF não existe: o VID tem 12 bits)
+        static constexpr uint64_t EMPTY = ~0ull;
+
+        struct Slot
+        {
+            std::atomic<uint64_t> key{EMPTY};
+            std::atomic<uint64_t> value{0}; //(lastUpdate << 16) | interface
+        };
+
+        //Cada shard em suas próprias linhas de cache: escritores de shards diferentes não disputam nada
+        struct alignas(64) Shard
+        {
+            std::atomic<uint32_t> sequence{0}; //Ímpar enquanto um escritor move entradas
+            std::atomic<uint32_t> size{0};
+            std::mutex writer;
+            std::unique_ptr<Slot[]> slots;
+        };
+
+        std::unique_ptr<Shard[]> m_Shards;
+        unsigned m_ShardBits;
+        uint64_t m_SlotMask;
+        uint32_t m_ShardCapacity; //Entradas por shard antes de expulsar a mais antiga
+
+        static uint64_t hash(uint64_t key);
+        static uint64_t pack(const Entry &entry) { return entry.lastUpdate << 16 | entry.interface; }
+        static Entry unpack(uint64_t value) { return {(uint16_t)value, value >> 16}; }
+
+        //Bits altos do hash (com um só shard, o deslocamento seria de 64 bits, indefinido)
+        Shard &shardOf(uint64_t h) const { return m_Shards[m_ShardBits ? h >> (64 - m_ShardBits) : 0]; }
+
+        //Índice da chave no shard (ou do slot vazio que encerra a sondagem); o escritor deve ter a trava
+        uint64_t probe(const Shard &shard, uint64_t key, uint64_t h) const;
+        //Remove o slot i, puxando para trás as entradas da mesma sequência de sondagem (sem marcas de remoção)
+        void erase(Shard &shard, uint64_t i);
+
+    public:
+        /**
+         * Construtor da tabela
+         *
+         * Parâmetros:	size_t capacity	=>	Entradas no total (divididas igualmente entre os shards)
+         * 				unsigned shards	=>	Quantidade de shards (arredondada para uma potência de 2)
+         */
+        explicit ShardedTable(size_t capacity, unsigned shards = 64);
+
+        ShardedTable(const ShardedTable &) = delete;
+        ShardedTable &operator=(const ShardedTable &) = delete;
+
+        /**
+         * Método que procura uma chave sem travar (pode ser chamado de qualquer thread)
+         *
+         * Parâmetros:	uint64_t key	=>	Chave ((VID << 48) | MAC)
+         * 				Entry &entry	=>	Recebe a porta e o instante da última atualização
+         *
+         * Retorno: bool	=>	Se a chave estava na tabela
+         */
+        bool lookup(uint64_t key, Entry &entry) const;
+
+        /**
+         * Método que aprende (ou renova) a porta de uma chave
+         *
+         * Com o shard cheio, a entrada atualizada há mais tempo nele é expulsa.
+         *
+         * Parâmetros:	uint64_t key			=>	Chave ((VID << 48) | MAC)
+         * 				uint16_t interface		=>	Porta onde a chave foi vista
+         * 				uint64_t currentTime	=>	Relógio da tabela
+         *
+         * Retorno: bool	=>	Se a chave foi inserida (false: já existia e foi renovada)
+         */
+        bool learn(uint64_t key, uint16_t interface, uint64_t currentTime);
+
+        //Remove uma chave (retorna se ela existia)
+        bool erase(uint64_t key);
+
+        /**
+         * Método que remove as entradas não atualizadas há mais de ttl, shard por shard
+         *
+         * Retorno: size_t	=>	Entradas removidas
+         */
+        size_t age(uint64_t currentTime, uint64_t ttl);
+
+        size_t size() const;
+        size_t capacity() const { return (size_t)m_ShardCapacity << m_ShardBits; }
+        unsigned shards() const { return 1u << m_ShardBits; }
+    };
+}
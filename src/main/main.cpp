@@ -17,6 +17,7 @@
 #include <ctime>
 
 #include "tui.hpp"
+#include "input.hpp"
 
 using namespace std::chrono_literals;
 using namespace tui::text_literals;
@@ -28,46 +29,139 @@ using TT = tui::text::Text;
 #include "crc_32.hpp"
 #include "tests.hpp"
 #include "peers.hpp"
+#include "metrics.hpp"
+#include "latency.hpp"
+#include "sim.hpp"
+#include "noise.hpp"
+#include "error_control.hpp"
+#include "task.hpp"
+#include "trace.hpp"
 
-void interactive(ERROR_CONTROL errorControl)
+//Tráfego de fundo da sessão interativa: manda frames para o outro host a meia banda do enlace até quit
+template <error_control::Policy P>
+static sim::Task interactive_background(Ref<Host> host, MAC other, const bool *quit)
 {
-    srand(time(NULL));
+    sim::Time interval = 2 * sim::LinkTiming{}.serialization(Ether2Frame::WIRE_SIZE);
+    while (!*quit)
+    {
+        Ether2Frame frame(other, host->m_MAC, "background", 11, P{});
+        host->sendFrameT<P>(0, frame);
+        co_await sim::sleep(interval);
+    }
+}
+
+//Conta os frames de fundo recebidos por um host
+static sim::Task interactive_sink(Ref<Host> host, uint64_t *received)
+{
+    while (true)
+    {
+        co_await host->receive();
+        (*received)++;
+    }
+}
 
-    static const TT error_names[] = {"Even bits"_b, "Odd bits"_b, "CRC"_b};
+//Mostra (acima da linha sendo digitada) as mensagens que chegam em C
+static sim::Task interactive_receiver(Ref<Host> C, tui::Console *console)
+{
+    while (true)
+    {
+        Ether2Frame frame = co_await C->receive();
+        char when[32];
+        snprintf(when, sizeof(when), "%.3f ms", (double)sim::now() / sim::MILLISECOND);
+        console->print(TT("[C] received '" + std::string((const char *)frame.data) + "' at " + when).FCyan());
+    }
+}
+
+//Lê as mensagens do usuário e as manda de B para C, até 'q' ou o fim da entrada
+template <error_control::Policy P>
+static sim::Task interactive_chat(tui::Console *console, Ref<Host> B, MAC C, bool *quit)
+{
+    while (true)
+    {
+        std::string msg = co_await console->readLine(TT("Type a message to be sent from B to C (or 'q' to quit): ").FWhite().Bold());
+        if (msg == "q" || console->closed())
+            break;
+
+        Ether2Frame frame(C, B->m_MAC, msg.c_str(), msg.size() + 1, P{});
+        B->sendFrameT<P>(0, frame);
+    }
+    *quit = true;
+    console->stop();
+}
+
+template <error_control::Policy P>
+void interactive()
+{
+    noise::setSeed(time(NULL));
+
+    ERROR_CONTROL errorControl = P::kind;
     tui::clear();
     tui::printl("Interactive Session:"_fgre);
-    tui::printl("All peers will be created using "_t + error_names[(int)errorControl]);
+    tui::printl("All peers will be created using "_t + TT(P::name).Bold());
+    tui::printl("D and E exchange background traffic while you type; the simulation keeps running meanwhile."_fblu);
 
-    Ref<Host> B = std::make_shared<Host>(MAC("BB:BB:BB:BB:BB:BB"), errorControl);
-    Ref<Host> C = std::make_shared<Host>(MAC("CC:CC:CC:CC:CC:CC"), errorControl);
+    Ref<Host> B = std::make_shared<Host>(MAC("02:BB:BB:BB:BB:BB"), errorControl);
+    Ref<Host> C = std::make_shared<Host>(MAC("02:CC:CC:CC:CC:CC"), errorControl);
+    Ref<Host> D = std::make_shared<Host>(MAC("02:DD:DD:DD:DD:DD"), errorControl);
+    Ref<Host> E = std::make_shared<Host>(MAC("02:EE:EE:EE:EE:EE"), errorControl);
 
-    Ref<Switch> S2 = std::make_shared<Switch>(errorControl, 3);
+    Ref<Switch> S2 = std::make_shared<Switch>(errorControl, 5);
 
     EthernetPeer::connect(B, S2, 0, 1);
     EthernetPeer::connect(C, S2, 0, 2);
+    EthernetPeer::connect(D, S2, 0, 3);
+    EthernetPeer::connect(E, S2, 0, 4);
 
-    std::string msg;
-    while(true)
-    {
-        tui::print("Type a message to be sent from B to C (or 'q' to quit): "_fwhi.Bold());
-        msg = tui::readline();
-
-		if(msg == "q")
-		{
-			break;
-		}
-        Ether2Frame frame(C->m_MAC, B->m_MAC, msg.c_str(), msg.size() + 1, errorControl);
-        B->sendFrame(0, frame);
-
-        tui::printl();
-        tui::printl("Press enter to clear the screen...");
-        tui::readline();
-        tui::clear();
-    }
+    //The narrative log of the background frames would scroll over the prompt
+    bool log = __nezumi_log_on__;
+    __nezumi_log_on__ = false;
+
+    bool quit = false;
+    uint64_t background = 0;
+    tui::Console console;
+    console.setStatus([&]() {
+        char status[64];
+        snprintf(status, sizeof(status), "[%.3f ms | %llu bg frames]", (double)sim::now() / sim::MILLISECOND, (unsigned long long)background);
+        return std::string(status);
+    });
+
+    sim::spawn(interactive_background<P>(D, E->m_MAC, &quit));
+    sim::spawn(interactive_background<P>(E, D->m_MAC, &quit));
+    sim::spawn(interactive_sink(D, &background));
+    sim::spawn(interactive_sink(E, &background));
+    sim::spawn(interactive_receiver(C, &console));
+    sim::spawn(interactive_chat<P>(&console, B, C->m_MAC, &quit));
+
+    console.start();
+    sim::run();
+
+    //The receivers are still waiting for frames
+    sim::reset();
+    __nezumi_log_on__ = log;
+    tui::printl();
 }
 
 int main(int argc, char const *argv[])
 {
+    //--metrics <arquivo>: exporta os contadores periodicamente (formato deduzido da extensão: .json, .csv, .prom)
+    std::unique_ptr<metrics::Exporter> exporter;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::string(argv[i]) == "--metrics")
+        {
+            exporter = std::make_unique<metrics::Exporter>(metrics::formatFromPath(argv[i + 1]), argv[i + 1]);
+            exporter->start();
+        }
+    }
+
+    //--trace <arquivo>: grava o caminho dos frames de cada história em um Chrome trace (precisa de make TRACE=1)
+    std::string tracePath;
+    for (int i = 1; i + 1 < argc; i++)
+        if (std::string(argv[i]) == "--trace")
+            tracePath = argv[i + 1];
+    if (!tracePath.empty() && !trace::COMPILED)
+        std::cerr << "--trace ignored: built without TRACE=1" << std::endl;
+
     while (true)
     {
         tui::clear();
@@ -79,10 +173,14 @@ int main(int argc, char const *argv[])
         tui::printl("  3. (CRC):  B-C (S2 only) with bit flipping (tranmission interference)"_fgre);
         tui::printl("  4. (EVEN): B-C (S2 only) with bit flipping (tranmission interference)"_fgre);
         tui::printl("  5. (ODD):  B-C (S2 only) with bit flipping (tranmission interference)"_fgre);
+        tui::printl("  6. (...):  B-C (S2 only) with bit flipping, choosing another check method"_fgre);
         tui::printl(""_fgre);
         tui::printl("  7. (CRC):  Interactive with 10% chance of bit flipping"_fgre);
         tui::printl("  8. (EVEN): Interactive with 10% chance of bit flipping"_fgre);
         tui::printl("  9. (ODD):  Interactive with 10% chance of bit flipping"_fgre);
+        tui::printl(""_fgre);
+        tui::printl("  r. (CRC):  A-C through a router, with ARP gleaning, TTL expiring and dropped packets"_fgre);
+        tui::printl("  d. (CRC):  Live dashboard of a loaded leaf-spine fabric (press enter to stop)"_fgre);
 
         tui::printl("");
         tui::printl("  q. quit"_fred);
@@ -90,42 +188,82 @@ int main(int argc, char const *argv[])
 
         if (opt.size() < 1)
             continue;
+
+        sim::reset();
+        latency::flows().reset();
+        if (!tracePath.empty())
+        {
+            trace::clear();
+            trace::start();
+        }
+
         switch (opt[0])
         {
         case '1':
-            srand(1);
+            noise::setSeed(3);
             A_B_ttl_andPromC();
             break;
         case '2':
-            srand(1);
+            noise::setSeed(3);
             B_C_self_andPromA();
             break;
         case '3':
-            srand(10);
-            B_C_error(ERROR_CONTROL::CRC);
+            noise::setSeed(9);
+            B_C_error<error_control::Crc>();
             break;
         case '4':
-            srand(10);
-            B_C_error(ERROR_CONTROL::EVEN);
+            noise::setSeed(9);
+            B_C_error<error_control::Even>();
             break;
         case '5':
-            srand(10);
-            B_C_error(ERROR_CONTROL::EVEN);
+            noise::setSeed(9);
+            B_C_error<error_control::Odd>();
+            break;
+        case '6':
+        {
+            static const ERROR_CONTROL others[] = {ERROR_CONTROL::CRC32C, ERROR_CONTROL::FLETCHER32, ERROR_CONTROL::ADLER32, ERROR_CONTROL::INTERNET};
+            tui::printl("Check method:"_fwhi.Bold());
+            for (size_t i = 0; i < std::size(others); i++)
+                error_control::dispatch(others[i], [&]<class P>(P) { tui::printl("  "_t + std::to_string(i + 1) + ". " + P::name); });
+            auto method = tui::readline();
+
+            size_t choice = method.size() > 0 ? (size_t)(method[0] - '1') : std::size(others);
+            if (choice >= std::size(others))
+                continue;
+            noise::setSeed(9);
+            B_C_error(others[choice]);
             break;
+        }
         case '7':
-            interactive(ERROR_CONTROL::CRC);
+            interactive<error_control::Crc>();
             break;
         case '8':
-            interactive(ERROR_CONTROL::EVEN);
+            interactive<error_control::Even>();
             break;
         case '9':
-            interactive(ERROR_CONTROL::ODD);
+            interactive<error_control::Odd>();
+            break;
+        case 'r':
+            noise::setSeed(3);
+            A_C_router();
+            break;
+        case 'd':
+            dashboardStory();
             break;
 
         case 'q':
             return 0;
         }
 
+        if (!tracePath.empty() && trace::COMPILED)
+        {
+            trace::stop();
+            size_t events = trace::writeChrome(tracePath);
+            tui::printl("Trace: "_t + std::to_string(events) + " events written to " + tracePath + " (" + std::to_string(trace::dropped()) + " dropped)");
+        }
+
+        tui::printl("End-to-end latency (per flow):"_fwhi.Bold());
+        latency::printFlowReport(std::cout);
         tui::printl("End of the story!"_fmag);
         tui::printl("Press enter to restart..."_fwhi.Bold());
         tui::readline();
@@ -0,0 +1,319 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace metrics
+{
+    //Registro global dos contadores publicados (protegido por mutex, fora do caminho quente)
+    static std::mutex __registry_mutex;
+    static std::vector<const PeerMetrics *> __registry;
+
+    const char *dropReasonName(DropReason reason)
+    {
+        switch (reason)
+        {
+        case DropReason::NotForUs:
+            return "not_for_us";
+        case DropReason::Checksum:
+            return "checksum";
+        case DropReason::SameInterface:
+            return "same_interface";
+        case DropReason::Vlan:
+            return "vlan";
+        case DropReason::QueueFull:
+            return "queue_full";
+        case DropReason::Red:
+            return "red";
+        case DropReason::InboxFull:
+            return "inbox_full";
+        case DropReason::Malformed:
+            return "malformed";
+        case DropReason::TtlExpired:
+            return "ttl_expired";
+        case DropReason::NoRoute:
+            return "no_route";
+        case DropReason::NoArp:
+            return "no_arp";
+        default:
+            return "unknown";
+        }
+    }
+
+    PeerMetrics::PeerMetrics(unsigned port_count) : ports(port_count) {}
+
+    PeerMetrics::~PeerMetrics()
+    {
+        if (!m_Published)
+            return;
+
+        std::lock_guard<std::mutex> lock(__registry_mutex);
+        __registry.erase(std::remove(__registry.begin(), __registry.end(), this), __registry.end());
+    }
+
+    void PeerMetrics::publish(const std::string &label, PeerKind kind)
+    {
+        std::lock_guard<std::mutex> lock(__registry_mutex);
+        m_Label = label;
+        m_Kind = kind;
+        if (!m_Published)
+            __registry.push_back(this);
+        m_Published = true;
+    }
+
+    PeerSnapshot PeerMetrics::snapshot() const
+    {
+        PeerSnapshot s;
+        s.label = m_Label;
+        s.kind = m_Kind;
+
+        s.ports.reserve(ports.size());
+        for (const PortCounters &p : ports)
+            s.ports.push_back({p.rxFrames.load(), p.rxBytes.load(), p.txFrames.load(), p.txBytes.load(), p.tailDrops.load(), p.redDrops.load(),
+                               p.queueDepth.load(), p.queueDepth.loadPeak()});
+
+        s.floods = forwarding.floods.load();
+        s.unknownUnicast = forwarding.unknownUnicast.load();
+        s.broadcasts = forwarding.broadcasts.load();
+        s.multicasts = forwarding.multicasts.load();
+        s.replications = forwarding.replications.load();
+        s.corruptForwarded = switching.corruptForwarded.load();
+        s.wastedBytes = switching.wastedBytes.load();
+
+        for (size_t i = 0; i < (size_t)DropReason::COUNT; i++)
+            s.drops[i] = drops.byReason[i].load();
+        s.checksumFailures = drops.checksumFailures.load();
+
+        s.tableHits = table.hits.load();
+        s.tableMisses = table.misses.load();
+        s.tableInserts = table.inserts.load();
+        s.tableEvictions = table.evictions.load();
+        s.tableEntries = table.entries.load();
+        s.tableCapacity = table.capacity;
+        s.groupJoins = table.groupJoins.load();
+        s.groupLeaves = table.groupLeaves.load();
+        return s;
+    }
+
+    std::vector<PeerSnapshot> snapshotAll()
+    {
+        std::lock_guard<std::mutex> lock(__registry_mutex);
+        std::vector<PeerSnapshot> snapshots;
+        snapshots.reserve(__registry.size());
+        for (const PeerMetrics *m : __registry)
+            snapshots.push_back(m->snapshot());
+        return snapshots;
+    }
+
+    /****************************************** Escritores ****************************************/
+
+    using NamedValues = std::vector<std::pair<const char *, uint64_t>>;
+
+    //Lista (nome, valor) dos contadores do peer, compartilhada pelos três formatos
+    static NamedValues peerCounters(const PeerSnapshot &s)
+    {
+        return {{"floods", s.floods},
+                {"unknown_unicast", s.unknownUnicast},
+                {"broadcasts", s.broadcasts},
+                {"multicasts", s.multicasts},
+                {"replications", s.replications},
+                {"corrupt_forwarded", s.corruptForwarded},
+                {"wasted_bytes", s.wastedBytes},
+                {"checksum_failures", s.checksumFailures},
+                {"table_hits", s.tableHits},
+                {"table_misses", s.tableMisses},
+                {"table_inserts", s.tableInserts},
+                {"table_evictions", s.tableEvictions},
+                {"group_joins", s.groupJoins},
+                {"group_leaves", s.groupLeaves}};
+    }
+
+    //As últimas PORT_GAUGES entradas de portCounters são valores instantâneos (gauge), não contadores
+    static constexpr size_t PORT_GAUGES = 2;
+
+    static NamedValues portCounters(const PortSnapshot &p)
+    {
+        return {{"rx_frames", p.rxFrames},     {"rx_bytes", p.rxBytes},       {"tx_frames", p.txFrames},
+                {"tx_bytes", p.txBytes},       {"tail_drops", p.tailDrops},   {"red_drops", p.redDrops},
+                {"queue_depth", p.queueDepth}, {"queue_peak", p.queuePeak}};
+    }
+
+    void writeJSON(std::ostream &out, const std::vector<PeerSnapshot> &snapshots, uint64_t timestamp_ms)
+    {
+        out << "{\"timestamp_ms\":" << timestamp_ms << ",\"peers\":[";
+        for (size_t i = 0; i < snapshots.size(); i++)
+        {
+            const PeerSnapshot &s = snapshots[i];
+            out << (i ? "," : "") << "{\"peer\":\"" << s.label << "\"";
+            for (auto &[name, v] : peerCounters(s))
+                out << ",\"" << name << "\":" << v;
+
+            out << ",\"drops\":{";
+            for (size_t r = 0; r < (size_t)DropReason::COUNT; r++)
+                out << (r ? "," : "") << "\"" << dropReasonName((DropReason)r) << "\":" << s.drops[r];
+            out << "}";
+
+            out << ",\"ports\":[";
+            for (size_t p = 0; p < s.ports.size(); p++)
+            {
+                out << (p ? ",{" : "{");
+                bool first = true;
+                for (auto &[name, v] : portCounters(s.ports[p]))
+                {
+                    out << (first ? "" : ",") << "\"" << name << "\":" << v;
+                    first = false;
+                }
+                out << "}";
+            }
+            out << "]}";
+        }
+        out << "]}\n";
+    }
+
+    void writeCSVHeader(std::ostream &out)
+    {
+        out << "timestamp_ms,peer,port,metric,value\n";
+    }
+
+    void writeCSV(std::ostream &out, const std::vector<PeerSnapshot> &snapshots, uint64_t timestamp_ms)
+    {
+        for (const PeerSnapshot &s : snapshots)
+        {
+            for (auto &[name, v] : peerCounters(s))
+                out << timestamp_ms << "," << s.label << ",," << name << "," << v << "\n";
+            for (size_t r = 0; r < (size_t)DropReason::COUNT; r++)
+                out << timestamp_ms << "," << s.label << ",,drops_" << dropReasonName((DropReason)r) << "," << s.drops[r] << "\n";
+            for (size_t p = 0; p < s.ports.size(); p++)
+                for (auto &[name, v] : portCounters(s.ports[p]))
+                    out << timestamp_ms << "," << s.label << "," << p << "," << name << "," << v << "\n";
+        }
+    }
+
+    void writePrometheus(std::ostream &out, const std::vector<PeerSnapshot> &snapshots)
+    {
+        //O formato exige que todas as amostras de uma métrica fiquem juntas, então itera por métrica e depois por peer
+        if (snapshots.empty())
+            return;
+
+        size_t peerCounterCount = peerCounters(snapshots[0]).size();
+        for (size_t c = 0; c < peerCounterCount; c++)
+        {
+            out << "# TYPE nls_" << peerCounters(snapshots[0])[c].first << "_total counter\n";
+            for (const PeerSnapshot &s : snapshots)
+            {
+                auto [name, v] = peerCounters(s)[c];
+                out << "nls_" << name << "_total{peer=\"" << s.label << "\"} " << v << "\n";
+            }
+        }
+
+        out << "# TYPE nls_drops_total counter\n";
+        for (const PeerSnapshot &s : snapshots)
+            for (size_t r = 0; r < (size_t)DropReason::COUNT; r++)
+                out << "nls_drops_total{peer=\"" << s.label << "\",reason=\"" << dropReasonName((DropReason)r) << "\"} " << s.drops[r] << "\n";
+
+        size_t portCounterCount = portCounters(PortSnapshot{}).size();
+        for (size_t c = 0; c < portCounterCount; c++)
+        {
+            bool gauge = c >= portCounterCount - PORT_GAUGES;
+            const char *suffix = gauge ? "" : "_total";
+            out << "# TYPE nls_port_" << portCounters(PortSnapshot{})[c].first << suffix << (gauge ? " gauge\n" : " counter\n");
+            for (const PeerSnapshot &s : snapshots)
+                for (size_t p = 0; p < s.ports.size(); p++)
+                {
+                    auto [name, v] = portCounters(s.ports[p])[c];
+                    out << "nls_port_" << name << suffix << "{peer=\"" << s.label << "\",port=\"" << p << "\"} " << v << "\n";
+                }
+        }
+    }
+
+    ExportFormat formatFromPath(const std::string &path)
+    {
+        auto endsWith = [&](const std::string &suffix) {
+            return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+        };
+
+        if (endsWith(".json") || endsWith(".jsonl"))
+            return ExportFormat::JSON;
+        if (endsWith(".csv"))
+            return ExportFormat::CSV;
+        if (endsWith(".prom"))
+            return ExportFormat::PROMETHEUS;
+
+        throw std::runtime_error("Unknown metrics format (expected .json, .csv or .prom): " + path);
+    }
+
+    /****************************************** Exportador ****************************************/
+
+    Exporter::Exporter(ExportFormat format, const std::string &path, std::chrono::milliseconds interval)
+        : m_Format(format), m_Path(path), m_Interval(interval)
+    {
+    }
+
+    Exporter::~Exporter() { stop(); }
+
+    void Exporter::start()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Running)
+            return;
+        m_Running = true;
+
+        m_Thread = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            while (m_Running)
+            {
+                m_Wakeup.wait_for(lock, m_Interval, [this]() { return !m_Running; });
+                write();
+            }
+        });
+    }
+
+    void Exporter::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (!m_Running)
+                return;
+            m_Running = false;
+        }
+        m_Wakeup.notify_all();
+        m_Thread.join();
+    }
+
+    void Exporter::exportOnce()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        write();
+    }
+
+    void Exporter::write()
+    {
+        uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        auto snapshots = snapshotAll();
+
+        if (m_Format == ExportFormat::PROMETHEUS)
+        {
+            //Escreve em um arquivo temporário e renomeia, para que o coletor nunca leia um arquivo pela metade
+            std::string tmp = m_Path + ".tmp";
+            {
+                std::ofstream out(tmp, std::ios::trunc);
+                writePrometheus(out, snapshots);
+            }
+            std::rename(tmp.c_str(), m_Path.c_str());
+            return;
+        }
+
+        std::ofstream out(m_Path, m_WroteHeader ? std::ios::app : std::ios::trunc);
+        if (m_Format == ExportFormat::CSV)
+        {
+            if (!m_WroteHeader)
+                writeCSVHeader(out);
+            writeCSV(out, snapshots, now);
+        }
+        else
+            writeJSON(out, snapshots, now);
+        m_WroteHeader = true;
+    }
+}
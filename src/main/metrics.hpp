@@ -0,0 +1,235 @@
+/**
+ * Header criado para contabilizar o que cada peer (Host/Switch) fez durante a simulação
+ *
+ * Os contadores são atômicos relaxados, agrupados em blocos alinhados à linha de cache,
+ * de forma que threads diferentes atualizando portas diferentes não disputem a mesma linha.
+ *
+ * A leitura é feita por snapshots (cópias simples dos valores) e pode ser exportada
+ * periodicamente em JSON (uma linha por amostra), CSV ou no formato texto do Prometheus.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "topology.hpp"
+
+namespace metrics
+{
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    //Contador monotônico com incremento relaxado (não ordena memória, apenas soma)
+    struct Counter
+    {
+        std::atomic<uint64_t> value{0};
+
+        inline void add(uint64_t amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+        inline uint64_t load() const { return value.load(std::memory_order_relaxed); }
+    };
+
+    //Valor instantâneo (ex.: ocupação de uma fila), com o maior valor já observado
+    struct Gauge
+    {
+        std::atomic<uint64_t> value{0}, peak{0};
+
+        inline void set(uint64_t v)
+        {
+            value.store(v, std::memory_order_relaxed);
+            if (v > peak.load(std::memory_order_relaxed))
+                peak.store(v, std::memory_order_relaxed);
+        }
+        inline uint64_t load() const { return value.load(std::memory_order_relaxed); }
+        inline uint64_t loadPeak() const { return peak.load(std::memory_order_relaxed); }
+    };
+
+    //Motivos pelos quais um frame pode ser descartado
+    enum class DropReason : uint8_t
+    {
+        NotForUs,       //Host recebeu um frame destinado a outro MAC
+        Checksum,       //Verificação (CRC/paridade) falhou
+        SameInterface,  //Switch: destino está na mesma interface de onde o frame veio
+        Vlan,           //Switch: frame de uma VLAN não permitida na porta de entrada
+        QueueFull,      //Switch: fila de saída cheia (tail drop)
+        Red,            //Switch: descarte antecipado aleatório (RED) na fila de saída
+        InboxFull,      //Host: caixa de entrada das aplicações cheia (ver Host::receive)
+        Malformed,      //Router: não é IPv4 ou o cabeçalho é inválido
+        TtlExpired,     //Router: TTL chegou a zero
+        NoRoute,        //Router: nenhum prefixo contém o destino
+        NoArp,          //Router: MAC do próximo salto desconhecido
+        COUNT
+    };
+
+    //Nome (snake_case) de cada motivo de descarte, usado na exportação
+    const char *dropReasonName(DropReason reason);
+
+    //Contadores de uma porta, ocupando uma linha de cache própria
+    struct alignas(CACHE_LINE_SIZE) PortCounters
+    {
+        Counter rxFrames, rxBytes;
+        Counter txFrames, txBytes;
+        Counter tailDrops, redDrops; //Descartes na fila de saída da porta
+        Gauge queueDepth;            //Frames na fila de saída (todas as classes)
+    };
+
+    //Cópia dos contadores de uma porta em um dado instante
+    struct PortSnapshot
+    {
+        uint64_t rxFrames, rxBytes;
+        uint64_t txFrames, txBytes;
+        uint64_t tailDrops, redDrops;
+        uint64_t queueDepth, queuePeak;
+    };
+
+    //Cópia de todos os contadores de um peer em um dado instante
+    struct PeerSnapshot
+    {
+        std::string label;
+        PeerKind kind;
+        std::vector<PortSnapshot> ports;
+
+        uint64_t floods, unknownUnicast;
+        uint64_t broadcasts, multicasts, replications;
+        uint64_t corruptForwarded, wastedBytes;
+        uint64_t drops[(size_t)DropReason::COUNT];
+        uint64_t checksumFailures;
+
+        uint64_t tableHits, tableMisses, tableInserts, tableEvictions;
+        uint64_t tableEntries, tableCapacity;
+        uint64_t groupJoins, groupLeaves;
+    };
+
+    /**
+     * Conjunto de contadores de um peer.
+     *
+     * Os contadores de encaminhamento, descarte e tabela ficam em blocos separados (cada um alinhado),
+     * para que o caminho de recepção de um switch não invalide a linha usada pelo exportador nem por outras portas.
+     */
+    class PeerMetrics
+    {
+    public:
+        std::vector<PortCounters> ports;
+
+        struct alignas(CACHE_LINE_SIZE)
+        {
+            Counter floods, unknownUnicast;
+            Counter broadcasts, multicasts; //Frames recebidos para broadcast / para um grupo registrado
+            Counter replications;           //Cópias enviadas de frames para grupos registrados (fan-out = replications / multicasts)
+        } forwarding;
+
+        struct alignas(CACHE_LINE_SIZE)
+        {
+            Counter corruptForwarded; //Frames com checagem inválida encaminhados (cut-through)
+            Counter wastedBytes;      //Bytes transmitidos com esses frames (soma de todas as cópias)
+        } switching;
+
+        struct alignas(CACHE_LINE_SIZE)
+        {
+            Counter byReason[(size_t)DropReason::COUNT];
+            Counter checksumFailures;
+        } drops;
+
+        struct alignas(CACHE_LINE_SIZE)
+        {
+            Counter hits, misses, inserts, evictions;
+            Counter groupJoins, groupLeaves;
+            Gauge entries;         //Entradas na tabela de MACs
+            uint64_t capacity = 0; //Máximo de entradas (0: o peer não tem tabela); definido antes de publish
+        } table;
+
+        PeerMetrics(unsigned port_count);
+        ~PeerMetrics();
+
+        PeerMetrics(const PeerMetrics &) = delete;
+        PeerMetrics &operator=(const PeerMetrics &) = delete;
+
+        inline void rx(uint16_t port, uint64_t bytes)
+        {
+            ports[port].rxFrames.add();
+            ports[port].rxBytes.add(bytes);
+        }
+
+        inline void tx(uint16_t port, uint64_t bytes)
+        {
+            ports[port].txFrames.add();
+            ports[port].txBytes.add(bytes);
+        }
+
+        inline void drop(DropReason reason) { drops.byReason[(size_t)reason].add(); }
+
+        /**
+         * Registra este conjunto de contadores no registro global, tornando-o visível aos exportadores
+         *
+         * Parâmetros:	const std::string &label	=>	Nome do peer na exportação (ex.: "switch-3")
+         * 				PeerKind kind				=>	Tipo do peer (usado por quem agrupa os peers, como o painel)
+         *
+         * Retorno: void
+         */
+        void publish(const std::string &label, PeerKind kind);
+
+        //Copia os valores atuais (cada contador é lido atomicamente, mas o conjunto não é um corte consistente)
+        PeerSnapshot snapshot() const;
+
+    private:
+        std::string m_Label;
+        PeerKind m_Kind = PeerKind::Other;
+        bool m_Published = false;
+    };
+
+    //Retorna um snapshot de todos os peers publicados
+    std::vector<PeerSnapshot> snapshotAll();
+
+    //Escritores dos formatos de exportação
+    void writeJSON(std::ostream &out, const std::vector<PeerSnapshot> &snapshots, uint64_t timestamp_ms);
+    void writeCSVHeader(std::ostream &out);
+    void writeCSV(std::ostream &out, const std::vector<PeerSnapshot> &snapshots, uint64_t timestamp_ms);
+    void writePrometheus(std::ostream &out, const std::vector<PeerSnapshot> &snapshots);
+
+    enum class ExportFormat
+    {
+        JSON,      //JSON Lines: uma amostra (objeto) por linha, anexada ao arquivo
+        CSV,       //Formato longo (timestamp, peer, porta, métrica, valor), anexado ao arquivo
+        PROMETHEUS //Arquivo texto do Prometheus, reescrito atomicamente a cada amostra
+    };
+
+    //Deduz o formato a partir da extensão do arquivo (.json, .csv, .prom)
+    ExportFormat formatFromPath(const std::string &path);
+
+    /**
+     * Exportador periódico: uma thread própria tira snapshots de todos os peers a cada intervalo
+     * e escreve no arquivo configurado
+     */
+    class Exporter
+    {
+    public:
+        Exporter(ExportFormat format, const std::string &path, std::chrono::milliseconds interval = std::chrono::seconds(1));
+        ~Exporter();
+
+        void start();
+        //Para a thread, escrevendo uma última amostra
+        void stop();
+
+        //Escreve uma amostra imediatamente
+        void exportOnce();
+
+    private:
+        ExportFormat m_Format;
+        std::string m_Path;
+        std::chrono::milliseconds m_Interval;
+
+        std::thread m_Thread;
+        std::mutex m_Mutex;
+        std::condition_variable m_Wakeup;
+        bool m_Running = false;
+        bool m_WroteHeader = false;
+
+        //Escreve uma amostra (com m_Mutex já travado)
+        void write();
+    };
+}
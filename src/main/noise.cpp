@@ -0,0 +1,68 @@
+#include "noise.hpp"
+
+#include <cmath>
+
+namespace noise
+{
+    static uint64_t __seed = 0;
+    static uint64_t __next_stream = 0;
+
+    void setSeed(uint64_t seed)
+    {
+        __seed = seed;
+        __next_stream = 0;
+    }
+
+    rng::Xoshiro256 nextStream() { return rng::Xoshiro256(__seed, __next_stream++); }
+
+    uint64_t seed() { return __seed; }
+
+    uint64_t streamsUsed() { return __next_stream; }
+
+    void setStreams(uint64_t seed, uint64_t streamsUsed)
+    {
+        __seed = seed;
+        __next_stream = streamsUsed;
+    }
+
+    NoiseModel::NoiseModel() : NoiseModel(0, rng::Xoshiro256()) {}
+
+    NoiseModel::NoiseModel(double bitErrorRate, const rng::Xoshiro256 &stream)
+        : m_BitErrorRate(bitErrorRate), m_LogComplement(std::log1p(-bitErrorRate)), m_Rng(stream)
+    {
+        m_BitsUntilError = drawSkip();
+    }
+
+    uint64_t NoiseModel::drawSkip()
+    {
+        if (m_BitErrorRate <= 0)
+            return UINT64_MAX;
+        if (m_BitErrorRate >= 1)
+            return 0;
+
+        //Inverse transform of the geometric distribution: floor(ln(U) / ln(1 - p)), with U in (0, 1]
+        double u = 1.0 - m_Rng.nextDouble();
+        double skip = std::floor(std::log(u) / m_LogComplement);
+        return skip >= (double)UINT64_MAX ? UINT64_MAX : (uint64_t)skip;
+    }
+
+    size_t NoiseModel::corrupt(uint8_t *buf, size_t len)
+    {
+        uint64_t bits = (uint64_t)len * 8;
+        uint64_t position = 0;
+        size_t flipped = 0;
+
+        //Each error consumes its own bit, then the next gap is drawn
+        while (m_BitsUntilError < bits - position)
+        {
+            position += m_BitsUntilError;
+            buf[position / 8] ^= (uint8_t)(1u << (position % 8));
+            flipped++;
+            position++;
+            m_BitsUntilError = drawSkip();
+        }
+
+        m_BitsUntilError -= bits - position;
+        return flipped;
+    }
+}
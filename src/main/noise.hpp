@@ -0,0 +1,83 @@
+/**
+ * Header criado para simular ruído nos enlaces (inversão de bits)
+ *
+ * Cada sentido de cada enlace tem seu próprio modelo, configurado pela taxa de erro de bit (BER),
+ * e seu próprio gerador pseudo-aleatório. Em vez de sortear cada bit, o modelo sorteia quantos bits
+ * corretos faltam até o próximo erro (distribuição geométrica): frames sem erro custam apenas uma subtração.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rng.hpp"
+
+namespace checkpoint
+{
+    struct Access;
+}
+
+namespace noise
+{
+    /**
+     * BER padrão dos enlaces: com ela ~10% dos frames (1500 bytes de payload) sofrem ao menos um erro,
+     * a mesma chance por salto usada nas histórias originais
+     */
+    constexpr double DEFAULT_BIT_ERROR_RATE = 8.78e-6;
+
+    /**
+     * Reinicia a semente global e a contagem de fluxos.
+     * Os enlaces conectados depois disso recebem os fluxos 0, 1, 2... na ordem em que forem conectados.
+     */
+    void setSeed(uint64_t seed);
+
+    //Reserva o próximo fluxo independente de números aleatórios (para um enlace, thread, etc.)
+    rng::Xoshiro256 nextStream();
+
+    //Semente global e quantidade de fluxos já reservados (restaurados juntos por um checkpoint)
+    uint64_t seed();
+    uint64_t streamsUsed();
+    void setStreams(uint64_t seed, uint64_t streamsUsed);
+
+    class NoiseModel
+    {
+    public:
+        //Por padrão não há ruído
+        NoiseModel();
+        NoiseModel(double bitErrorRate, const rng::Xoshiro256 &stream);
+
+        double bitErrorRate() const { return m_BitErrorRate; }
+
+        //true se nenhum erro ocorre nos próximos 'bits' bits (consome esses bits do fluxo)
+        inline bool clean(uint64_t bits)
+        {
+            if (m_BitsUntilError >= bits)
+            {
+                m_BitsUntilError -= bits;
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * Inverte os bits atingidos por erros nos próximos len*8 bits, a partir da posição já sorteada
+         *
+         * Parâmetros:	uint8_t *buf	=>	Buffer a ser corrompido
+         * 				size_t len		=>	Tamanho do buffer
+         *
+         * Retorno: size_t	=>	Quantidade de bits invertidos
+         */
+        size_t corrupt(uint8_t *buf, size_t len);
+
+    private:
+        double m_BitErrorRate;
+        double m_LogComplement; //ln(1 - BER), usado no sorteio geométrico
+        rng::Xoshiro256 m_Rng;
+        uint64_t m_BitsUntilError;
+
+        //Sorteia quantos bits corretos vêm antes do próximo erro
+        uint64_t drawSkip();
+
+        friend struct checkpoint::Access;
+    };
+}
@@ -4,31 +4,165 @@
 #include <stdexcept>
 #include <unordered_map>
 #include <chrono>
+#include <algorithm>
+#include <deque>
 
 #include "frame.hpp"
 #include "types.hpp"
 #include "mac.hpp"
+#include "metrics.hpp"
 
 using namespace std::chrono_literals;
 
 const static auto TTL = std::chrono::duration_cast<std::chrono::milliseconds>(15s).count();
 
-EthernetPeer::EthernetPeer(ERROR_CONTROL error_control_type, unsigned port_count)
-    : interfaces(port_count), m_ErrorControlType(error_control_type)
+static DispatchMode __dispatch_mode = DispatchMode::Closed;
+
+void EthernetPeer::setDispatchMode(DispatchMode mode) { __dispatch_mode = mode; }
+DispatchMode EthernetPeer::dispatchMode() { return __dispatch_mode; }
+
+//Frames in flight, in slots reused once delivered: the arrival event only carries the slot (a deque keeps the
+//frame in place while its delivery puts others in flight). Slots of an earlier sim epoch belong to discarded events
+static std::deque<WireFrame> __wire;
+static std::vector<uint32_t> __free_wire;
+static uint64_t __wire_order = 0;
+static uint64_t __wire_epoch = 0;
+
+static void syncWireEpoch()
+{
+    if (__wire_epoch == sim::epoch())
+        return;
+    __wire.clear();
+    __free_wire.clear();
+    __wire_epoch = sim::epoch();
+}
+
+template <error_control::Policy P>
+void EthernetPeer::scheduleArrival(const PortLink &link, const Ether2Frame &frame)
+{
+    syncWireEpoch();
+    uint32_t slot;
+    if (__free_wire.empty())
+    {
+        slot = (uint32_t)__wire.size();
+        __wire.emplace_back();
+    }
+    else
+    {
+        slot = __free_wire.back();
+        __free_wire.pop_back();
+    }
+    __wire[slot].link = link;
+    __wire[slot].order = __wire_order++;
+    __wire[slot].frame = frame;
+
+    sim::schedule(frame.arrivedAt, [slot]() {
+        WireFrame &wire = __wire[slot];
+        if (Topology::global().peer(wire.link.peer))
+            deliver<P>(wire.link, wire.frame);
+        wire.link = PortLink();
+        __free_wire.push_back(slot);
+    });
+}
+
+std::vector<WireFrame> EthernetPeer::framesInFlight()
+{
+    syncWireEpoch();
+    std::vector<WireFrame> frames;
+    for (const WireFrame &wire : __wire)
+        if (wire.link.connected())
+            frames.push_back(wire);
+    std::sort(frames.begin(), frames.end(), [](const WireFrame &a, const WireFrame &b) { return a.order < b.order; });
+    return frames;
+}
+
+void EthernetPeer::putInFlight(const PortLink &link, const Ether2Frame &frame)
+{
+    EthernetPeer *receiver = Topology::global().peer(link.peer);
+    if (!receiver)
+        throw std::runtime_error("Frame in flight to a peer that does not exist");
+    error_control::dispatch(receiver->m_ErrorControlType, [&]<class P>(P) { scheduleArrival<P>(link, frame); });
+}
+
+EthernetPeer::EthernetPeer(ERROR_CONTROL error_control_type, unsigned port_count, PeerKind kind)
+    : m_ErrorControlType(error_control_type), m_Id(Topology::global().add(this, port_count, kind)), m_Metrics(port_count),
+      m_Noise(port_count)
+{
+}
+
+template <error_control::Policy P>
+void EthernetPeer::deliver(const PortLink &link, Ether2Frame &frame)
+{
+    Topology &topology = Topology::global();
+    EthernetPeer *receiver = topology.peer(link.peer);
+
+    //Host and Switch are final, so these calls are direct (and can be inlined)
+    if (__dispatch_mode == DispatchMode::Closed)
+    {
+        switch (topology.kind(link.peer))
+        {
+        case PeerKind::Host:
+            static_cast<Host *>(receiver)->receiveFrameT<P>(link.port, frame);
+            return;
+        case PeerKind::Switch:
+            static_cast<Switch *>(receiver)->receiveFrameT<P>(link.port, frame);
+            return;
+        default:
+            break;
+        }
+    }
+
+    receiver->receiveFrame(link.port, frame);
+}
+
+template <error_control::Policy P>
+void EthernetPeer::deliverBurst(const PortLink &link, std::span<Ether2Frame *const> frames)
+{
+    if (frames.empty())
+        return;
+
+    //Only a switch takes the burst in one call; every other receiver gets the frames one by one
+    Topology &topology = Topology::global();
+    if (__dispatch_mode == DispatchMode::Closed && topology.kind(link.peer) == PeerKind::Switch)
+    {
+        static_cast<Switch *>(topology.peer(link.peer))->receiveFramesT<P>(link.port, frames);
+        return;
+    }
+
+    for (Ether2Frame *frame : frames)
+        deliver<P>(link, *frame);
+}
+
+//Calls f(burst) for each piece of at most BURST_MAX frames of the span (a burst is a span of frame pointers)
+template <class F>
+static void forEachBurst(std::span<Ether2Frame> frames, F &&f)
+{
+    Ether2Frame *burst[EthernetPeer::BURST_MAX];
+    for (size_t first = 0; first < frames.size(); first += EthernetPeer::BURST_MAX)
+    {
+        size_t n = std::min(EthernetPeer::BURST_MAX, frames.size() - first);
+        for (size_t i = 0; i < n; i++)
+            burst[i] = &frames[first + i];
+        f(std::span<Ether2Frame *const>(burst, n));
+    }
+}
+
+EthernetPeer::~EthernetPeer()
 {
+    Topology::global().remove(m_Id);
 }
 
-void EthernetPeer::connect(const Ref<EthernetPeer> &A, const Ref<EthernetPeer> &B, unsigned portA, unsigned portB)
+void EthernetPeer::connect(const Ref<EthernetPeer> &A, const Ref<EthernetPeer> &B, unsigned portA, unsigned portB, double bitErrorRate)
 {
-    //Check if port already has a valid pointer
-    if (A->interfaces[portA] == nullptr)
-        A->interfaces[portA] = B;
-    else if (A->interfaces[portA] != B)
+    Topology &topology = Topology::global();
+    const PortLink &linkA = topology.link(A->m_Id, portA);
+    const PortLink &linkB = topology.link(B->m_Id, portB);
+
+    //Check if port is already connected to something else
+    if (linkA.connected() && (linkA.peer != B->m_Id || linkA.port != portB))
         throw std::runtime_error("In A, portA is already connected to a different peer");
 
-    if (B->interfaces[portB] == nullptr)
-        B->interfaces[portB] = A;
-    else if (B->interfaces[portB] != A)
+    if (linkB.connected() && (linkB.peer != A->m_Id || linkB.port != portA))
         throw std::runtime_error("In B, portB is already connected to a different peer");
 
     //Raise exception if both error checking methods are not the same
@@ -36,174 +170,1129 @@ void EthernetPeer::connect(const Ref<EthernetPeer> &A, const Ref<EthernetPeer> &
         throw std::runtime_error("Error control type of peers are different");
 
     //TODO: in case A and B are already connected, it will cause a reconnection (is this desirable?)
-    A->interfaces[portA] = B;
-    B->interfaces[portB] = A;
+    topology.connect(A->m_Id, (uint16_t)portA, B->m_Id, (uint16_t)portB);
+
+    //Each direction of the link gets its own random stream
+    A->setBitErrorRate(portA, bitErrorRate);
+    B->setBitErrorRate(portB, bitErrorRate);
 }
 
-void EthernetPeer::disconnect(const Ref<EthernetPeer> &A, const Ref<EthernetPeer> &B)
+void EthernetPeer::setBitErrorRate(unsigned port, double bitErrorRate)
 {
-    //Get in which port B is connected
-    unsigned portA = 0;
-    for (; portA < A->interfaces.size(); portA++)
-        if (A->interfaces[portA] == B)
-            break;
+    m_Noise[port] = noise::NoiseModel(bitErrorRate, noise::nextStream());
+}
 
-    //Get in which port a is connected
-    unsigned portB = 0;
-    for (; portB < B->interfaces.size(); portB++)
-        if (B->interfaces[portB] == A)
-            break;
+void EthernetPeer::disconnect(const Ref<EthernetPeer> &A, const Ref<EthernetPeer> &B)
+{
+    //Get in which port B is connected (the link itself tells the port on B)
+    std::span<PortLink> portsA = A->ports();
+    auto it = std::find_if(portsA.begin(), portsA.end(), [&](const PortLink &l) { return l.peer == B->m_Id; });
 
-    //If not found portA or portB, throw an exception
-    if (portA == A->interfaces.size() || portB == B->interfaces.size())
+    //If not found, throw an exception
+    if (it == portsA.end())
         throw std::runtime_error("Peers are not connected");
 
-    //Disconect peers
-    A->interfaces[portA] = nullptr;
-    B->interfaces[portB] = nullptr;
+    //Disconect peers (both ends of the link)
+    Topology::global().disconnect(A->m_Id, (uint16_t)(it - portsA.begin()));
 }
 
 void EthernetPeer::sendFrame(uint16_t interface, Ether2Frame &frame)
 {
-    interfaces[interface]->receiveFrame(this, frame);
+    error_control::dispatch(m_ErrorControlType, [&]<class P>(P) { transmit<P>(interface, frame); });
 }
 
-void Host::receiveFrame(const EthernetPeer *const sender_ptr, Ether2Frame &frame)
+template <error_control::Policy P>
+void EthernetPeer::transmit(uint16_t interface, Ether2Frame &frame)
 {
+    m_Metrics.tx(interface, frame.wireSize());
+
+    //The receiver overwrites the timestamps when forwarding, so they are restored for the next egress (flood)
+    sim::Time hopStart = frame.hopStart, departedAt = frame.departedAt;
+    frame.arrivedAt = departedAt + m_LinkTiming.propagation + m_LinkTiming.serialization(frame.wireSize());
+
+    //Clean frames (the common case) are delivered as is; corrupted ones are copied so other egress ports see the original
+    const PortLink &link = Topology::global().link(m_Id, interface);
+    if (!link.connected())
+        return;
+
+    //The other process was granted everything before (this clock + lookahead), so a frame handed to it cannot leave
+    //before now: a cut-through switch starts sending before the frame fully arrived, which would arrive in its past
+    if (Topology::global().kind(link.peer) == PeerKind::Remote && departedAt < sim::now())
+        frame.arrivedAt = sim::now() + m_LinkTiming.propagation + m_LinkTiming.serialization(frame.wireSize());
+
+    //Inside the event loop the frame reaches the other side as an event at its arrival time, so the clock
+    //never runs ahead of events still pending (e.g. frames waiting in an egress queue). A link to another
+    //process takes the frame at once: the other process schedules it at its arrival time
+    auto handOff = [](const PortLink &link, Ether2Frame &frame) {
+        if (!sim::running() || Topology::global().kind(link.peer) == PeerKind::Remote)
+        {
+            deliver<P>(link, frame);
+            return;
+        }
+        scheduleArrival<P>(link, frame);
+    };
+
+    if (m_Noise[interface].clean(sizeof(frame.data) * 8))
+        handOff(link, frame);
+    else
+    {
+        Ether2Frame noisy = corrupted(interface, frame);
+        handOff(link, noisy);
+    }
+
+    frame.hopStart = hopStart;
+    frame.departedAt = departedAt;
+}
+
+Ether2Frame EthernetPeer::corrupted(uint16_t interface, const Ether2Frame &frame)
+{
+    TRACE_SCOPE("noise::corrupt");
+    Ether2Frame noisy = frame;
+    size_t flipped = m_Noise[interface].corrupt(noisy.data, sizeof(noisy.data));
+
     L("");
-    frame._simulation_fake_noise();
+    L("*** Simulating ERROR!!! *** "_fred);
+    L("  Flipped "_fred << flipped << " bit(s) on the link"_fred);
+    for (size_t byte = 0; byte < sizeof(noisy.data) && __nezumi_log_on__; byte++)
+        for (unsigned bit = 0; bit < 8; bit++)
+            if ((frame.data[byte] ^ noisy.data[byte]) & (1u << bit))
+                L("  Flipping bit "_fred << bit << " of byte "_fred << byte);
+    L("  Data before: "_fblu << frame.data);
+    L("  Data after: "_fblu << noisy.data);
+    L("*** Simulated error *** "_fred);
+    L("");
+
+    return noisy;
+}
+
+void EthernetPeer::sendFrames(uint16_t interface, std::span<Ether2Frame> frames)
+{
+    error_control::dispatch(m_ErrorControlType, [&]<class P>(P) {
+        forEachBurst(frames, [&](std::span<Ether2Frame *const> burst) { transmitBurst<P>(interface, burst); });
+    });
+}
+
+void EthernetPeer::receiveFrames(uint16_t interface, std::span<Ether2Frame> frames)
+{
+    for (Ether2Frame &frame : frames)
+        receiveFrame(interface, frame);
+}
+
+template <error_control::Policy P>
+void EthernetPeer::transmitBurst(uint16_t interface, std::span<Ether2Frame *const> frames)
+{
+    //Inside the event loop each frame is its own arrival event
+    if (sim::running())
+    {
+        for (Ether2Frame *frame : frames)
+            transmit<P>(interface, *frame);
+        return;
+    }
+
+    sim::Time hopStart[BURST_MAX], departedAt[BURST_MAX];
+    size_t bytes = 0;
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        Ether2Frame &frame = *frames[i];
+        hopStart[i] = frame.hopStart;
+        departedAt[i] = frame.departedAt;
+        frame.arrivedAt = frame.departedAt + m_LinkTiming.propagation + m_LinkTiming.serialization(frame.wireSize());
+        bytes += frame.wireSize();
+    }
+    m_Metrics.ports[interface].txFrames.add(frames.size());
+    m_Metrics.ports[interface].txBytes.add(bytes);
+
+    //Runs of clean frames go on as one burst; a corrupted copy is delivered alone between them, keeping the order
+    const PortLink &link = Topology::global().link(m_Id, interface);
+    if (link.connected())
+    {
+        size_t first = 0;
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            if (m_Noise[interface].clean(sizeof(frames[i]->data) * 8))
+                continue;
+            Ether2Frame noisy = corrupted(interface, *frames[i]);
+            deliverBurst<P>(link, frames.subspan(first, i - first));
+            deliver<P>(link, noisy);
+            first = i + 1;
+        }
+        deliverBurst<P>(link, frames.subspan(first));
+    }
+
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        frames[i]->hopStart = hopStart[i];
+        frames[i]->departedAt = departedAt[i];
+    }
+}
+
+void Host::sendFrame(uint16_t interface, Ether2Frame &frame)
+{
+    error_control::dispatch(m_ErrorControlType, [&]<class P>(P) { sendFrameT<P>(interface, frame); });
+}
+
+template <error_control::Policy P>
+void Host::sendFrameT(uint16_t interface, Ether2Frame &frame)
+{
+    TRACE_SCOPE("Host::sendFrame");
+    TRACE_FLOW_BEGIN(frame);
+    frame.sentAt = frame.hopStart = frame.departedAt = sim::now();
+    frame.wallSentAt = latency::wallClockEnabled() ? latency::wallNow() : 0;
+    transmit<P>(interface, frame);
+}
+
+void Host::sendFrames(uint16_t interface, std::span<Ether2Frame> frames)
+{
+    error_control::dispatch(m_ErrorControlType, [&]<class P>(P) { sendFramesT<P>(interface, frames); });
+}
+
+template <error_control::Policy P>
+void Host::sendFramesT(uint16_t interface, std::span<Ether2Frame> frames)
+{
+    TRACE_SCOPE("Host::sendFrames");
+    //Back to back on the link: each frame departs when the previous one was serialized
+    sim::Time at = sim::now();
+    uint64_t wallSentAt = latency::wallClockEnabled() ? latency::wallNow() : 0;
+    forEachBurst(frames, [&](std::span<Ether2Frame *const> burst) {
+        for (Ether2Frame *frame : burst)
+        {
+            frame->sentAt = frame->hopStart = frame->departedAt = at;
+            frame->wallSentAt = wallSentAt;
+            TRACE_FLOW_BEGIN(*frame);
+            at += m_LinkTiming.serialization(frame->wireSize());
+        }
+        transmitBurst<P>(interface, burst);
+    });
+}
+
+void Host::receiveFrame(uint16_t interface, Ether2Frame &frame)
+{
+    error_control::dispatch(m_ErrorControlType, [&]<class P>(P) { receiveFrameT<P>(interface, frame); });
+}
+
+template <error_control::Policy P>
+void Host::receiveFrameT(uint16_t interface, Ether2Frame &frame)
+{
+    TRACE_SCOPE("Host::receiveFrame");
+    TRACE_FLOW_END(frame);
+    L("");
+
+    m_Metrics.rx(interface, frame.wireSize());
+    sim::advanceTo(frame.arrivedAt);
 
     //Announce that this host has received the frame
     L("(Host) Received frame from "_fblu << MAC(frame.src).to_string());
     L("(Host) Frame destination: "_fblu << MAC(frame.dst).to_string());
 
     L("(Host) CurrentMAC: "_fblu << m_MAC.to_string());
+    //Frames for this host: its own MAC, broadcast and the groups it joined
+    MAC dst(frame.dst);
+    bool addressed = frame.dst == this->m_MAC.bytes || dst.isBroadcast() || (dst.isMulticast() && m_Groups.count(frame.dst));
+
     //If the destination is not this host, drop the frame and return
     if (m_PromiscuousMode)
     {
         L("(Host) WARNING: Promiscuous mode enabled!!"_fyel);
     }
-    else if (frame.dst != this->m_MAC.bytes)
+    else if (!addressed)
     {
         L("The frame was not destinated to this host, dropping it"_fwhi);
+        m_Metrics.drop(metrics::DropReason::NotForUs);
         return;
     }
 
     L("(Host) Frame accepted!"_fgre);
-    frame.prettyPrint();
+    if (__nezumi_log_on__)
+        frame.prettyPrint();
 
-    if (this->m_ErrorControlType == ERROR_CONTROL::CRC)
+    if (!frame.check<P>())
     {
-        if (!frame.checkCRC())
+        L(tui::text::Text("The frame " + std::string(P::field) + " is invalid, dropping it").FRed());
+        m_Metrics.drops.checksumFailures.add();
+        m_Metrics.drop(metrics::DropReason::Checksum);
+        return;
+    }
+
+    if (m_Listening)
+        toApplication(frame);
+
+    //Frames only seen because of promiscuous mode are not part of the flow latency
+    if (!addressed)
+        return;
+
+    latency::FlowStats &flow = latency::flows().get(frame.src, frame.dst);
+    flow.endToEnd.record(frame.arrivedAt - frame.sentAt);
+    if (frame.wallSentAt)
+        flow.endToEndWall.record(latency::wallNow() - frame.wallSentAt);
+}
+
+void Host::setPromiscuousMode(bool promiscuous) { m_PromiscuousMode = promiscuous; }
+
+void Host::toApplication(const Ether2Frame &frame)
+{
+    if (!m_Waiters.empty())
+    {
+        FrameAwaiter *waiter = m_Waiters.front();
+        m_Waiters.pop_front();
+        waiter->m_Frame = frame;
+        waiter->m_Host = nullptr;
+        sim::schedule(sim::now(), [h = waiter->m_Handle]() { h.resume(); });
+        return;
+    }
+
+    if (m_Inbox.size() >= INBOX_CAPACITY)
+    {
+        m_Metrics.drop(metrics::DropReason::InboxFull);
+        return;
+    }
+    m_Inbox.push_back(frame);
+}
+
+Host::FrameAwaiter Host::receive()
+{
+    m_Listening = true;
+    return FrameAwaiter(this);
+}
+
+bool Host::FrameAwaiter::await_ready()
+{
+    if (m_Host->m_Inbox.empty())
+        return false;
+    m_Frame = m_Host->m_Inbox.front();
+    m_Host->m_Inbox.pop_front();
+    return true;
+}
+
+void Host::FrameAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    m_Handle = handle;
+    m_Host->m_Waiters.push_back(this);
+}
+
+Host::FrameAwaiter::~FrameAwaiter()
+{
+    if (m_Handle && m_Host)
+        std::erase(m_Host->m_Waiters, this);
+}
+
+void Host::sendGroupControl(GroupOp op, const MAC &group, uint16_t interface)
+{
+    uint8_t payload[7] = {(uint8_t)op};
+    for (int i = 0; i < 6; i++)
+        payload[1 + i] = (uint8_t)(group.bytes >> (40 - 8 * i));
+
+    Ether2Frame frame(group, m_MAC, (const char *)payload, sizeof(payload), m_ErrorControlType);
+    frame.type = GROUP_CONTROL_TYPE;
+    sendFrame(interface, frame);
+}
+
+void Host::joinGroup(const MAC &group, uint16_t interface)
+{
+    if (!group.isMulticast() || group.isBroadcast())
+        throw std::runtime_error("Not a multicast group address");
+
+    m_Groups.insert(group.bytes);
+    sendGroupControl(GroupOp::Join, group, interface);
+}
+
+void Host::leaveGroup(const MAC &group, uint16_t interface)
+{
+    m_Groups.erase(group.bytes);
+    sendGroupControl(GroupOp::Leave, group, interface);
+}
+
+Host::Host(const MAC &mac, ERROR_CONTROL error_control_type, unsigned int port_count)
+    : EthernetPeer(error_control_type, port_count, PeerKind::Host), m_MAC(mac)
+{
+    m_Metrics.publish("host-" + m_MAC.to_string(), PeerKind::Host);
+}
+
+Host::~Host()
+{
+    //Applications still waiting on this host are never resumed (sim::reset destroys them)
+    for (FrameAwaiter *waiter : m_Waiters)
+        waiter->m_Host = nullptr;
+}
+
+template <error_control::Policy P>
+size_t Switch::sendToAllExceptSender(uint16_t senderInterface, uint16_t vid, Ether2Frame &frame)
+{
+    TRACE_SCOPE("Switch::flood");
+    m_Metrics.forwarding.floods.add();
+
+    //The flood stays inside the VLAN: its ports that have a peer, minus the ingress one
+    const PortMask *members = vlanPorts(vid);
+    if (!members)
+        return 0;
+
+    //A LAG gets one copy, through the member hashed for the flow; the LAG the frame came from gets none
+    uint16_t ingressLag = m_PortLag[senderInterface];
+    uint64_t stamp = ++m_FloodStamp;
+    size_t first = m_Egress.size();
+    members->forEachAnd(
+        activePorts(),
+        [&](size_t i) {
+            uint16_t lag = m_PortLag[i];
+            if (lag == NO_LAG)
+                m_Egress.push_back((uint16_t)i);
+            else if (lag != ingressLag && m_Lags[lag].floodStamp != stamp)
+            {
+                m_Lags[lag].floodStamp = stamp;
+                m_Egress.push_back(lagMember((uint16_t)i, frame.src, frame.dst, vid));
+            }
+        },
+        senderInterface);
+    return egressBatch<P>(first, vid, frame);
+}
+
+template <error_control::Policy P>
+size_t Switch::sendToGroup(uint16_t senderInterface, uint16_t vid, const PortMask &group, Ether2Frame &frame)
+{
+    const PortMask *members = vlanPorts(vid);
+    if (!members)
+        return 0;
+
+    //Group ports are logical ports (a LAG is registered by its first port)
+    const PortMask &active = activePorts();
+    uint16_t ingress = logicalPort(senderInterface);
+    size_t first = m_Egress.size();
+    group.forEachAnd(
+        *members,
+        [&](size_t i) {
+            if (m_PortLag[i] == NO_LAG)
+            {
+                if (active.test(i))
+                    m_Egress.push_back((uint16_t)i);
+            }
+            else if (uint16_t member = lagMember((uint16_t)i, frame.src, frame.dst, vid); member != NO_MEMBER)
+                m_Egress.push_back(member);
+        },
+        ingress);
+
+    m_Metrics.forwarding.replications.add(m_Egress.size() - first);
+    return egressBatch<P>(first, vid, frame);
+}
+
+template <error_control::Policy P>
+size_t Switch::egress(uint16_t port, uint16_t vid, Ether2Frame &frame)
+{
+    //The same frame object is reused for every egress port, so the tag is restored afterwards
+    uint16_t tpid = frame.tpid, tci = frame.tci;
+
+    const PortVlan &config = m_PortVlans[port];
+    if (config.trunk && vid != config.pvid)
+    {
+        frame.tpid = Ether2Frame::VLAN_TPID;
+        frame.tci = (uint16_t)((tci & 0xF000) | vid);
+    }
+    else
+        frame.untag();
+
+    send<P>(port, frame, tpid == Ether2Frame::VLAN_TPID ? tci >> 13 : 0);
+    size_t bytes = frame.wireSize();
+
+    frame.tpid = tpid;
+    frame.tci = tci;
+    return bytes;
+}
+
+template <error_control::Policy P>
+size_t Switch::egressBatch(size_t first, uint16_t vid, Ether2Frame &frame)
+{
+    uint16_t tpid = frame.tpid, tci = frame.tci;
+
+    //Indexes (not iterators): a delivery may flood again through this switch and grow m_Egress
+    size_t last = m_Egress.size(), tagged = 0;
+    size_t bytes = (last - first) * Ether2Frame::WIRE_SIZE;
+    unsigned priority = tpid == Ether2Frame::VLAN_TPID ? tci >> 13 : 0;
+    frame.untag();
+    for (size_t i = first; i < last; i++)
+    {
+        const PortVlan &config = m_PortVlans[m_Egress[i]];
+        if (!config.trunk || vid == config.pvid)
+            send<P>(m_Egress[i], frame, priority);
+        else
+            tagged++;
+    }
+
+    //Second pass only when some port is a trunk carrying this VLAN tagged
+    frame.tpid = Ether2Frame::VLAN_TPID;
+    frame.tci = (uint16_t)((tci & 0xF000) | vid);
+    for (size_t i = first; i < last && tagged; i++)
+    {
+        const PortVlan &config = m_PortVlans[m_Egress[i]];
+        if (config.trunk && vid != config.pvid)
         {
-            L("The frame CRC is invalid, dropping it"_fred);
+            send<P>(m_Egress[i], frame, priority);
+            bytes += Ether2Frame::VLAN_TAG_SIZE;
+            tagged--;
         }
     }
-    else if (this->m_ErrorControlType == ERROR_CONTROL::EVEN)
+
+    frame.tpid = tpid;
+    frame.tci = tci;
+    m_Egress.resize(first);
+    return bytes;
+}
+
+template <error_control::Policy P>
+size_t Switch::egressBurst(uint16_t port, std::span<Ether2Frame *const> frames, const uint16_t *vids)
+{
+    //Each frame gets the tag of its VLAN on this port; the original tags are restored afterwards
+    uint16_t tpids[BURST_MAX], tcis[BURST_MAX];
+    const PortVlan &config = m_PortVlans[port];
+    size_t bytes = 0;
+    for (size_t i = 0; i < frames.size(); i++)
     {
-        if (!frame.checkEven())
+        Ether2Frame &frame = *frames[i];
+        tpids[i] = frame.tpid;
+        tcis[i] = frame.tci;
+        if (config.trunk && vids[i] != config.pvid)
         {
-            L("The frame parity bit (even) is invalid, dropping it"_fred);
+            frame.tpid = Ether2Frame::VLAN_TPID;
+            frame.tci = (uint16_t)((tcis[i] & 0xF000) | vids[i]);
         }
+        else
+            frame.untag();
+        bytes += frame.wireSize();
     }
+
+    //Queued frames are scheduled one by one (their classes may differ)
+    if (m_EgressQueues.empty())
+        transmitBurst<P>(port, frames);
     else
+        for (size_t i = 0; i < frames.size(); i++)
+            send<P>(port, *frames[i], tpids[i] == Ether2Frame::VLAN_TPID ? tcis[i] >> 13 : 0);
+
+    for (size_t i = 0; i < frames.size(); i++)
     {
-        if (!frame.checkOdd())
-        {
-            L("The frame parity bit (odd) is invalid, dropping it"_fred);
-        }
+        frames[i]->tpid = tpids[i];
+        frames[i]->tci = tcis[i];
     }
+    return bytes;
 }
 
-void Host::setPromiscuousMode(bool promiscuous) { m_PromiscuousMode = promiscuous; }
+template <error_control::Policy P>
+void Switch::send(uint16_t port, Ether2Frame &frame, unsigned priority)
+{
+    if (m_EgressQueues.empty())
+    {
+        transmit<P>(port, frame);
+        return;
+    }
 
-Host::Host(const MAC &mac, ERROR_CONTROL error_control_type, unsigned int port_count)
-    : EthernetPeer(error_control_type, port_count), m_MAC(mac)
+    queueing::EgressQueue &queue = m_EgressQueues[port];
+    metrics::PortCounters &counters = m_Metrics.ports[port];
+    switch (queue.push(frame, priority))
+    {
+    case queueing::Admission::TailDrop:
+        counters.tailDrops.add();
+        m_Metrics.drop(metrics::DropReason::QueueFull);
+        return;
+    case queueing::Admission::RedDrop:
+        counters.redDrops.add();
+        m_Metrics.drop(metrics::DropReason::Red);
+        return;
+    case queueing::Admission::Accepted:
+        break;
+    }
+
+    //A frame that is ready before the pending service (e.g. it was cut through) moves the service earlier
+    counters.queueDepth.set(queue.size());
+    if (std::max(queue.busyUntil, frame.departedAt) < queue.serviceAt)
+        scheduleService<P>(port);
+}
+
+template <error_control::Policy P>
+void Switch::scheduleService(uint16_t port)
 {
+    queueing::EgressQueue &queue = m_EgressQueues[port];
+
+    //The event looks the switch up by id: it may run after the switch is gone
+    sim::Time at = std::max(queue.busyUntil, queue.nextReady());
+    queue.serviceAt = at;
+    sim::schedule(at, [id = m_Id, port, at]() {
+        if (EthernetPeer *peer = Topology::global().peer(id))
+            static_cast<Switch *>(peer)->serve<P>(port, at);
+    });
 }
 
-void Switch::sendToAllExceptSender(uint16_t senderInterface, Ether2Frame &frame)
+template <error_control::Policy P>
+void Switch::serve(uint16_t port, sim::Time at)
 {
-    //Announce frame source and destination
-    std::cout << "(SWITCH) Sending frame to all interfaces except "_fblu << senderInterface << std::endl;
+    queueing::EgressQueue &queue = m_EgressQueues[port];
+    if (at != queue.serviceAt)
+        return;
+    queue.serviceAt = queueing::EgressQueue::NO_SERVICE;
 
-    //Send frame to all ports with a valid peer
-    for (unsigned int i = 0; i < interfaces.size(); i++)
-        if (interfaces[i] != nullptr && i != senderInterface)
-            interfaces[i]->receiveFrame(this, frame);
+    int cls = queue.select(at);
+    if (cls >= 0)
+    {
+        //The frame leaves now (it waited for the link and for the frames the scheduler picked before it)
+        Ether2Frame frame = queue.pop((unsigned)cls);
+        m_Metrics.ports[port].queueDepth.set(queue.size());
+        frame.departedAt = at;
+        queue.busyUntil = at + m_LinkTiming.serialization(frame.wireSize());
+        transmit<P>(port, frame);
+    }
+
+    if (!queue.empty())
+        scheduleService<P>(port);
 }
 
-size_t Switch::getSenderInterface(const EthernetPeer *const sender_ptr)
+void Switch::resumeQueues()
 {
-    //Gets the port index which matches with sender_ptr
-    for (unsigned int i = 0; i < interfaces.size(); i++)
-        if (interfaces[i] != nullptr && interfaces[i].get() == sender_ptr)
-            return i;
+    error_control::dispatch(m_ErrorControlType, [&]<class P>(P) {
+        for (size_t port = 0; port < m_EgressQueues.size(); port++)
+            if (m_EgressQueues[port].serviceAt != queueing::EgressQueue::NO_SERVICE)
+                scheduleService<P>((uint16_t)port);
+    });
+}
 
-    //If not found, throw an exception
-    throw std::runtime_error("Sender not found");
+void Switch::setEgressQueues(const queueing::QueueConfig &config)
+{
+    m_EgressQueues.clear();
+    m_EgressQueues.reserve(ports().size());
+    for (size_t i = 0; i < ports().size(); i++)
+        m_EgressQueues.emplace_back(config, noise::nextStream());
+}
+
+void Switch::learn(uint64_t key, uint16_t interface, uint64_t currentTime)
+{
+    TRACE_SCOPE("Switch::learn");
+    auto it = m_SwitchTable.find(key);
+    if (it != m_SwitchTable.end())
+    {
+        it->second = {interface, currentTime};
+        return;
+    }
+
+    //If the table is full, evict the entry that was updated the longest time ago
+    if (m_SwitchTable.size() >= MAX_TABLE_SIZE)
+    {
+        auto oldest = std::min_element(m_SwitchTable.begin(), m_SwitchTable.end(),
+                                       [](const auto &a, const auto &b) { return a.second.lastUpdate < b.second.lastUpdate; });
+        m_SwitchTable.erase(oldest);
+        m_Metrics.table.evictions.add();
+    }
+
+    m_SwitchTable.emplace(key, SwitchTableEntry{interface, currentTime});
+    m_Metrics.table.inserts.add();
+    m_Metrics.table.entries.set(m_SwitchTable.size());
+}
+
+void Switch::receiveFrame(uint16_t senderInterface, Ether2Frame &frame)
+{
+    error_control::dispatch(m_ErrorControlType, [&]<class P>(P) { receiveFrameT<P>(senderInterface, frame); });
+}
+
+void Switch::receiveFrames(uint16_t senderInterface, std::span<Ether2Frame> frames)
+{
+    error_control::dispatch(m_ErrorControlType, [&]<class P>(P) {
+        forEachBurst(frames, [&](std::span<Ether2Frame *const> burst) { receiveFramesT<P>(senderInterface, burst); });
+    });
 }
 
-void Switch::receiveFrame(const EthernetPeer *const sender_ptr, Ether2Frame &frame)
+void Switch::arrive(uint16_t senderInterface, Ether2Frame &frame)
 {
-    frame._simulation_fake_noise();
+    //Store-and-forward: the frame leaves after it was fully received and processed
+    //Cut-through: it leaves as soon as the destination MAC was read (the first bit arrived one serialization time before the last)
+    m_HopLatency.record(frame.arrivedAt - frame.hopStart);
+    frame.hopStart = frame.arrivedAt;
+    if (m_SwitchingMode == SwitchingMode::CutThrough)
+        frame.departedAt = frame.arrivedAt - m_LinkTiming.serialization(frame.wireSize() - Ether2Frame::DST_SIZE) + sim::SWITCH_PROCESSING;
+    else
+        frame.departedAt = frame.arrivedAt + sim::SWITCH_PROCESSING;
+}
 
+template <error_control::Policy P>
+size_t Switch::apply(const ForwardDecision &decision, uint16_t senderInterface, uint16_t vid, Ether2Frame &frame)
+{
+    switch (decision.action)
+    {
+    case ForwardDecision::DropVlan:
+        D(L("(SWITCH) The VLAN of the frame is not allowed on this interface, dropping!"_fred));
+        return 0;
+    case ForwardDecision::Broadcast:
+        D(L("(SWITCH) Broadcast (or unregistered group), sending to all except sender"_fyel));
+        return sendToAllExceptSender<P>(senderInterface, vid, frame);
+    case ForwardDecision::Multicast:
+        D(L("(SWITCH) Sending to the ports of the group"_fgre));
+        return sendToGroup<P>(senderInterface, vid, *decision.group, frame);
+    case ForwardDecision::FloodUnknown:
+        D(L("(SWITCH) Destination not in table, sending to all except sender"_fyel));
+        return sendToAllExceptSender<P>(senderInterface, vid, frame);
+    case ForwardDecision::FloodExpired:
+        D(L("(SWITCH) TTL expired, removing from table and sending to all except sender"_fyel));
+        return sendToAllExceptSender<P>(senderInterface, vid, frame);
+    case ForwardDecision::Filter:
+        D(L("(SWITCH) The destination of the packet is in the same interface that sent it, dropping!"_fred));
+        return 0;
+    case ForwardDecision::Forward:
+    {
+        D(L("(SWITCH) Sending to destination (it was in the switch table)"_fgre));
+        //A LAG sends the frame through the member hashed for the flow
+        uint16_t port = lagMember(decision.interface, frame.src, frame.dst, vid);
+        return port == NO_MEMBER ? 0 : egress<P>(port, vid, frame);
+    }
+    }
+    return 0;
+}
+
+template <error_control::Policy P>
+void Switch::receiveFrameT(uint16_t senderInterface, Ether2Frame &frame)
+{
+    TRACE_SCOPE("Switch::receiveFrame");
+    TRACE_FLOW_STEP(frame);
     L("");
     //Announce frame receival
-    std::cout << "(SWITCH) Received frame from "_fblu << MAC(frame.src).to_string() << ": " << frame.data << std::endl;
-    std::cout << "(SWITCH) Frame destination: "_fblu << MAC(frame.dst).to_string() << std::endl;
+    L("(SWITCH) Received frame from "_fblu << MAC(frame.src).to_string() << ": " << frame.data);
+    L("(SWITCH) Frame destination: "_fblu << MAC(frame.dst).to_string());
+
+    m_Metrics.rx(senderInterface, frame.wireSize());
+    sim::advanceTo(frame.arrivedAt);
+    arrive(senderInterface, frame);
 
-    size_t senderInterface = 0;
-    try
+    //The check is always computed at the end of the reception; only store-and-forward (or a frame terminated here) can still drop it
+    bool cutThrough = m_SwitchingMode == SwitchingMode::CutThrough;
+    bool valid = frame.check<P>();
+    if (!valid && (!cutThrough || frame.type == GROUP_CONTROL_TYPE))
     {
-        senderInterface = getSenderInterface(sender_ptr);
+        D(L(tui::text::Text("(SWITCH) The frame " + std::string(P::field) + " is invalid, dropping it").FRed()));
+        m_Metrics.drops.checksumFailures.add();
+        m_Metrics.drop(metrics::DropReason::Checksum);
+        return;
     }
-    catch (const std::exception &e)
+
+    //Group control frames are consumed here (snooping): the group table learns the ingress port
+    if (frame.type == GROUP_CONTROL_TYPE)
     {
-        std::cerr << e.what() << '\n';
+        D(L("(SWITCH) Group control frame, updating the group table"_fyel));
+        snoop(frame.data, logicalPort(senderInterface));
         return;
     }
 
-    //Get current time in milliseconds
-    uint64_t currentTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    uint16_t vid = classify(frame.tagged(), frame.tci, senderInterface);
+    ForwardDecision decision = decide(frame.src, frame.dst, logicalPort(senderInterface), vid, tableNow());
+    size_t sentBytes = apply<P>(decision, senderInterface, vid, frame);
+
+    //Cut-through already sent the corrupted frame on: its copies only waste bandwidth downstream
+    if (!valid)
+    {
+        D(L(tui::text::Text("(SWITCH) The frame " + std::string(P::field) + " was invalid, but it was already forwarded (cut-through)").FYellow()));
+        m_Metrics.drops.checksumFailures.add();
+        m_Metrics.switching.corruptForwarded.add();
+        m_Metrics.switching.wastedBytes.add(sentBytes);
+    }
+}
+
+template <error_control::Policy P>
+void Switch::receiveFramesT(uint16_t senderInterface, std::span<Ether2Frame *const> frames)
+{
+    TRACE_SCOPE("Switch::receiveFrames");
+    L("");
+    L("(SWITCH) Received a burst of "_fblu << frames.size() << " frame(s) on interface "_fblu << senderInterface);
+
+    //Counters and clock once per burst
+    size_t bytes = 0;
+    sim::Time lastArrival = 0;
+    for (Ether2Frame *frame : frames)
+    {
+        bytes += frame->wireSize();
+        lastArrival = std::max(lastArrival, frame->arrivedAt);
+        arrive(senderInterface, *frame);
+        TRACE_FLOW_STEP(*frame);
+    }
+    m_Metrics.ports[senderInterface].rxFrames.add(frames.size());
+    m_Metrics.ports[senderInterface].rxBytes.add(bytes);
+    sim::advanceTo(lastArrival);
+
+    //All payloads are checked in one interleaved pass, and the table clock is read once
+    uint64_t valid = verifyFrames<P>(frames);
+    bool cutThrough = m_SwitchingMode == SwitchingMode::CutThrough;
+    uint64_t currentTime = tableNow();
+    uint16_t ingress = logicalPort(senderInterface);
+
+    //First pass: drops, snooping, classification and learning (a run of frames from the same source is learned once).
+    //Every source of the burst is learned before the first lookup, as if the frames had arrived at the same time
+    uint16_t vids[BURST_MAX];
+    uint64_t pending = 0, learned = UINT64_MAX;
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        Ether2Frame &frame = *frames[i];
+        if (!(valid >> i & 1) && (!cutThrough || frame.type == GROUP_CONTROL_TYPE))
+        {
+            D(L(tui::text::Text("(SWITCH) The frame " + std::string(P::field) + " is invalid, dropping it").FRed()));
+            m_Metrics.drops.checksumFailures.add();
+            m_Metrics.drop(metrics::DropReason::Checksum);
+            continue;
+        }
+
+        if (frame.type == GROUP_CONTROL_TYPE)
+        {
+            snoop(frame.data, ingress);
+            continue;
+        }
+
+        vids[i] = classify(frame.tagged(), frame.tci, senderInterface);
+        if (vids[i] == NO_VLAN)
+        {
+            m_Metrics.drop(metrics::DropReason::Vlan);
+            continue;
+        }
+
+        if (!MAC(frame.src).isMulticast())
+        {
+            uint64_t key = tableKey(vids[i], frame.src);
+            if (key != learned)
+                learn(key, ingress, currentTime);
+            learned = key;
+        }
+        pending |= 1ull << i;
+    }
+
+    //Second pass: lookups. Frames forwarded to a single port are grouped by egress port and leave as one burst per port;
+    //the groups are sent before a frame that floods (or that is forwarded corrupted), so each egress port keeps the arrival order
+    struct Queued
+    {
+        uint16_t port, vid;
+        Ether2Frame *frame;
+    };
+    Queued queued[BURST_MAX];
+    size_t queuedCount = 0;
+    auto flush = [&]() {
+        std::stable_sort(queued, queued + queuedCount, [](const Queued &a, const Queued &b) { return a.port < b.port; });
+        Ether2Frame *burst[BURST_MAX];
+        uint16_t burstVids[BURST_MAX];
+        for (size_t first = 0, n; first < queuedCount; first += n)
+        {
+            for (n = 0; first + n < queuedCount && queued[first + n].port == queued[first].port; n++)
+            {
+                burst[n] = queued[first + n].frame;
+                burstVids[n] = queued[first + n].vid;
+            }
+            egressBurst<P>(queued[first].port, {burst, n}, burstVids);
+        }
+        queuedCount = 0;
+    };
+
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        if (!(pending >> i & 1))
+            continue;
+
+        Ether2Frame &frame = *frames[i];
+        bool intact = valid >> i & 1;
+        ForwardDecision decision = lookup(frame.dst, ingress, vids[i], currentTime);
+        if (decision.action == ForwardDecision::Forward && intact)
+        {
+            uint16_t port = lagMember(decision.interface, frame.src, frame.dst, vids[i]);
+            if (port != NO_MEMBER)
+                queued[queuedCount++] = {port, vids[i], &frame};
+            continue;
+        }
+
+        flush();
+        size_t sentBytes = apply<P>(decision, senderInterface, vids[i], frame);
+        if (!intact)
+        {
+            m_Metrics.drops.checksumFailures.add();
+            m_Metrics.switching.corruptForwarded.add();
+            m_Metrics.switching.wastedBytes.add(sentBytes);
+        }
+    }
+    flush();
+}
+
+uint64_t Switch::tableNow()
+{
+    //Simulated time in milliseconds: entries age with the simulation (sim::sleep), not with the wall clock
+    return sim::now() / sim::MILLISECOND;
+}
+
+uint16_t Switch::classify(bool tagged, uint16_t tci, uint16_t ingressInterface) const
+{
+    const PortVlan &config = m_PortVlans[ingressInterface];
+
+    //Untagged and priority-tagged (VID 0) frames belong to the VLAN of the port
+    uint16_t vid = tci & 0x0FFF;
+    if (!tagged || vid == 0)
+        return config.pvid;
+
+    //Access ports only take frames of their own VLAN; trunks take any VLAN they carry
+    if (!config.trunk && vid != config.pvid)
+        return NO_VLAN;
+
+    const PortMask *members = vlanPorts(vid);
+    return members && members->test(ingressInterface) ? vid : NO_VLAN;
+}
+
+ForwardDecision Switch::decide(uint64_t src, uint64_t dst, uint16_t ingressInterface, uint16_t vid, uint64_t currentTime)
+{
+    if (vid == NO_VLAN)
+    {
+        m_Metrics.drop(metrics::DropReason::Vlan);
+        return {ForwardDecision::DropVlan, ingressInterface};
+    }
 
     //TODO: check what should happen if the same MAC is presented in another interface before TTL expires
     //If sender not in switch table, add it, else update TTL and interface for MAC
-    m_SwitchTable[MAC(frame.src)] = {(uint16_t)senderInterface, currentTime};
+    //(a group address is never a valid source, so it is not learned)
+    if (!MAC(src).isMulticast())
+        learn(tableKey(vid, src), ingressInterface, currentTime);
 
-    auto findIt = m_SwitchTable.find(MAC(frame.dst));
+    return lookup(dst, ingressInterface, vid, currentTime);
+}
 
-    //If dest not in table or table is full, just send to all except sender
-    if (findIt == m_SwitchTable.end() || m_SwitchTable.size() == MAX_TABLE_SIZE)
+ForwardDecision Switch::lookup(uint64_t dst, uint16_t ingressInterface, uint16_t vid, uint64_t currentTime)
+{
+    TRACE_SCOPE("Switch::lookup");
+    //Group destinations are never looked up in the MAC table
+    if (MAC(dst).isMulticast())
     {
-        D(L("(SWITCH) Destination not in table, sending to all except sender"_fyel));
-        sendToAllExceptSender(senderInterface, frame);
-        return;
+        const PortMask *group = MAC(dst).isBroadcast() ? nullptr : groupPorts(MAC(dst));
+        if (group)
+        {
+            m_Metrics.forwarding.multicasts.add();
+            return {ForwardDecision::Multicast, ingressInterface, group};
+        }
+        m_Metrics.forwarding.broadcasts.add();
+        return {ForwardDecision::Broadcast, ingressInterface};
+    }
+
+    auto findIt = m_SwitchTable.find(tableKey(vid, dst));
+
+    //If dest not in table, just send to all except sender
+    if (findIt == m_SwitchTable.end())
+    {
+        m_Metrics.table.misses.add();
+        m_Metrics.forwarding.unknownUnicast.add();
+        return {ForwardDecision::FloodUnknown, ingressInterface};
     }
 
     //If dest TTL expired, remove from switch table and send to all except sender
     if (currentTime - findIt->second.lastUpdate > TTL)
     {
-        D(L("(SWITCH) TTL expired, removing from table and sending to all except sender"_fyel));
-        m_SwitchTable.erase(frame.src);
-        m_SwitchTable[MAC(frame.src)] = {(uint16_t)senderInterface, currentTime};
-        sendToAllExceptSender(senderInterface, frame);
-        return;
+        m_SwitchTable.erase(findIt);
+        m_Metrics.table.evictions.add();
+        m_Metrics.table.entries.set(m_SwitchTable.size());
+        m_Metrics.table.misses.add();
+        m_Metrics.forwarding.unknownUnicast.add();
+        return {ForwardDecision::FloodExpired, ingressInterface};
     }
 
     //If it's all ok, just send to destination
+    m_Metrics.table.hits.add();
 
-    if (findIt->second.interface == senderInterface)
+    if (findIt->second.interface == ingressInterface)
     {
-        D(L("(SWITCH) The destination of the packet is in the same interface that sent it, dropping!"_fred));
+        m_Metrics.drop(metrics::DropReason::SameInterface);
+        return {ForwardDecision::Filter, ingressInterface};
+    }
+
+    return {ForwardDecision::Forward, findIt->second.interface};
+}
+
+void Switch::snoop(const uint8_t *payload, uint16_t ingressInterface)
+{
+    uint64_t bytes = 0;
+    for (int i = 0; i < 6; i++)
+        bytes = bytes << 8 | payload[1 + i];
+    MAC group(bytes);
+    if (!group.isMulticast() || group.isBroadcast())
+        return;
+
+    if ((GroupOp)payload[0] == GroupOp::Join)
+    {
+        m_GroupTable[group].ports.set(ingressInterface);
+        m_Metrics.table.groupJoins.add();
         return;
     }
 
-    D(L("(SWITCH) Sending to destination (it was in the switch table)"_fgre));
-    sendFrame(findIt->second.interface, frame);
+    if ((GroupOp)payload[0] != GroupOp::Leave)
+        return;
+
+    auto it = m_GroupTable.find(group);
+    if (it == m_GroupTable.end())
+        return;
+
+    //Static ports stay in the group
+    if (!it->second.staticPorts.test(ingressInterface))
+        it->second.ports.reset(ingressInterface);
+    m_Metrics.table.groupLeaves.add();
+    if (!it->second.ports.any())
+        m_GroupTable.erase(it);
 }
 
-Switch::Switch(ERROR_CONTROL error_control_type, unsigned int port_count)
-    : EthernetPeer(error_control_type, port_count)
+void Switch::addGroupPort(const MAC &group, uint16_t port)
 {
-}
\ No newline at end of file
+    if (!group.isMulticast() || group.isBroadcast())
+        throw std::runtime_error("Not a multicast group address");
+
+    GroupEntry &entry = m_GroupTable[group];
+    entry.ports.set(port);
+    entry.staticPorts.set(port);
+}
+
+void Switch::removeGroupPort(const MAC &group, uint16_t port)
+{
+    auto it = m_GroupTable.find(group);
+    if (it == m_GroupTable.end())
+        return;
+
+    it->second.ports.reset(port);
+    it->second.staticPorts.reset(port);
+    if (!it->second.ports.any())
+        m_GroupTable.erase(it);
+}
+
+void Switch::clearPortVlans(uint16_t port)
+{
+    for (auto it = m_VlanPorts.begin(); it != m_VlanPorts.end();)
+    {
+        it->second.reset(port);
+        it = it->second.any() ? std::next(it) : m_VlanPorts.erase(it);
+    }
+
+    //Addresses learned on the port belonged to its old VLANs
+    std::erase_if(m_SwitchTable, [port](const auto &entry) { return entry.second.interface == port; });
+    m_Metrics.table.entries.set(m_SwitchTable.size());
+}
+
+void Switch::setAccessPort(uint16_t port, uint16_t vid)
+{
+    if (vid == 0 || vid >= 4095)
+        throw std::runtime_error("Invalid VLAN id");
+
+    for (uint16_t p : lagPorts(port))
+    {
+        clearPortVlans(p);
+        m_PortVlans[p] = {false, vid};
+        m_VlanPorts[vid].set(p);
+    }
+}
+
+void Switch::setTrunkPort(uint16_t port, const std::vector<uint16_t> &allowed, uint16_t nativeVid)
+{
+    if (nativeVid == 0 || nativeVid >= 4095)
+        throw std::runtime_error("Invalid VLAN id");
+    for (uint16_t vid : allowed)
+        if (vid == 0 || vid >= 4095)
+            throw std::runtime_error("Invalid VLAN id");
+
+    for (uint16_t p : lagPorts(port))
+    {
+        clearPortVlans(p);
+        m_PortVlans[p] = {true, nativeVid};
+        m_VlanPorts[nativeVid].set(p);
+        for (uint16_t vid : allowed)
+            m_VlanPorts[vid].set(p);
+    }
+}
+
+std::vector<uint16_t> Switch::lagPorts(uint16_t port) const
+{
+    if (m_PortLag[port] == NO_LAG)
+        return {port};
+    return m_Lags[m_PortLag[port]].members;
+}
+
+uint16_t Switch::addLag(const std::vector<uint16_t> &ports)
+{
+    if (ports.empty() || ports.size() > MAX_LAG_MEMBERS)
+        throw std::runtime_error("A LAG needs between 1 and 64 ports");
+    for (size_t i = 0; i < ports.size(); i++)
+    {
+        uint16_t p = ports[i];
+        if (p >= m_PortLag.size() || m_PortLag[p] != NO_LAG)
+            throw std::runtime_error("LAG port is invalid or already in a LAG");
+        if (std::find(ports.begin(), ports.begin() + i, p) != ports.begin() + i)
+            throw std::runtime_error("LAG port is listed twice");
+    }
+
+    uint16_t lag = (uint16_t)m_Lags.size();
+    m_Lags.push_back({ports});
+
+    //Members take the VLAN configuration of the first port; what was learned on them now belongs to the LAG
+    uint16_t first = ports[0];
+    for (uint16_t p : ports)
+    {
+        m_PortLag[p] = lag;
+        if (p == first)
+            continue;
+        clearPortVlans(p);
+        m_PortVlans[p] = m_PortVlans[first];
+        for (auto &[vid, mask] : m_VlanPorts)
+            if (mask.test(first))
+                mask.set(p);
+    }
+    return lag;
+}
+
+uint16_t Switch::lagMember(uint16_t port, uint64_t src, uint64_t dst, uint16_t vid) const
+{
+    uint16_t lag = m_PortLag[port];
+    if (lag == NO_LAG)
+        return port;
+
+    //MurmurHash3 finalizer over the flow (MACs are 48 bits: the VID fills the top), mapped to [0, n) without a division
+    uint64_t h = src ^ (dst * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)vid << 48);
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    auto pick = [h](unsigned n) { return (unsigned)(((unsigned __int128)h * n) >> 64); };
+
+    //The flow is hashed over every configured member, so a member going down (or back up) only moves its own flows
+    const std::vector<uint16_t> &members = m_Lags[lag].members;
+    const PortMask &active = activePorts();
+    uint16_t chosen = members[pick((unsigned)members.size())];
+    if (active.test(chosen))
+        return chosen;
+
+    //Flows of a member that is down are spread over the members still connected
+    uint16_t up[MAX_LAG_MEMBERS];
+    unsigned n = 0;
+    for (uint16_t m : members)
+        if (active.test(m))
+            up[n++] = m;
+    if (n == 0)
+        return NO_MEMBER;
+    return up[pick(n)];
+}
+
+const PortMask *Switch::vlanPorts(uint16_t vid) const
+{
+    auto it = m_VlanPorts.find(vid);
+    return it == m_VlanPorts.end() ? nullptr : &it->second;
+}
+
+const PortMask *Switch::groupPorts(const MAC &group) const
+{
+    auto it = m_GroupTable.find(group);
+    return it == m_GroupTable.end() ? nullptr : &it->second.ports;
+}
+
+Switch::Switch(ERROR_CONTROL error_control_type, unsigned int port_count, size_t table_size)
+    : EthernetPeer(error_control_type, port_count, PeerKind::Switch), MAX_TABLE_SIZE(table_size), m_PortVlans(port_count),
+      m_PortLag(port_count, NO_LAG)
+{
+    //Every port starts as an access port of the default VLAN (a single broadcast domain)
+    PortMask &defaultVlan = m_VlanPorts[DEFAULT_VLAN];
+    for (unsigned int i = 0; i < port_count; i++)
+        defaultVlan.set(i);
+
+    m_Metrics.table.capacity = table_size;
+    m_Metrics.publish("switch-" + std::to_string(m_Id), PeerKind::Switch);
+}
+
+//Specialized pipelines reachable from outside this file (stories, benchmarks)
+#define INSTANTIATE_PIPELINE(P)                                                                      \
+    template void Host::sendFrameT<error_control::P>(uint16_t, Ether2Frame &);                       \
+    template void Host::receiveFrameT<error_control::P>(uint16_t, Ether2Frame &);                    \
+    template void Host::sendFramesT<error_control::P>(uint16_t, std::span<Ether2Frame>);             \
+    template void Switch::receiveFrameT<error_control::P>(uint16_t, Ether2Frame &);                  \
+    template void Switch::receiveFramesT<error_control::P>(uint16_t, std::span<Ether2Frame *const>); \
+    template void EthernetPeer::transmit<error_control::P>(uint16_t, Ether2Frame &);
+ERROR_CONTROL_POLICIES(INSTANTIATE_PIPELINE)
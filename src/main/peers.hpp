@@ -1,26 +1,141 @@
 /**
  * Header criado para auxiliar no fluxo da rede, transmitindo os frames
  */
+#pragma once
+
 #include <vector>
 #include <stdexcept>
 #include <unordered_map>
+#include <unordered_set>
 #include <chrono>
+#include <span>
+#include <deque>
+#include <coroutine>
 
 #include "frame.hpp"
 #include "types.hpp"
 #include "mac.hpp"
+#include "metrics.hpp"
+#include "latency.hpp"
+#include "sim.hpp"
+#include "noise.hpp"
+#include "topology.hpp"
+#include "port_mask.hpp"
+#include "egress_queue.hpp"
 
 using namespace std::chrono_literals;
 
+namespace checkpoint
+{
+    struct Access;
+}
+
+/**
+ * Modo de despacho da entrega de frames:
+ *  - Virtual: sempre pela chamada virtual receiveFrame()
+ *  - Closed: os tipos embutidos (Host, Switch) são identificados pela etiqueta de tipo da topologia
+ *    e chamados diretamente; outros tipos (extensões) continuam pela chamada virtual
+ */
+enum class DispatchMode
+{
+    Virtual,
+    Closed
+};
+
+/**
+ * Modo de comutação de um switch:
+ *  - StoreAndForward: recebe o frame inteiro, confere a checagem e descarta frames corrompidos já no primeiro salto
+ *  - CutThrough: começa a transmitir assim que o MAC de destino foi lido (menor latência), mas encaminha
+ *    frames corrompidos; a checagem só é conferida no fim da recepção, para contabilizar o desperdício
+ */
+enum class SwitchingMode
+{
+    StoreAndForward,
+    CutThrough
+};
+
+//Frame em trânsito em um enlace (dentro de sim::run): chega à extremidade 'link' no instante frame.arrivedAt
+struct WireFrame
+{
+    PortLink link;
+    uint64_t order = 0; //Ordem de envio (desempata as chegadas no mesmo instante)
+    Ether2Frame frame;
+};
+
 class EthernetPeer
 {
 
 protected:
-    std::vector<Ref<EthernetPeer>> interfaces;
     ERROR_CONTROL m_ErrorControlType;
 
+    //Identificador do peer na topologia (as portas e seus enlaces ficam em Topology::global())
+    PeerId m_Id;
+    metrics::PeerMetrics m_Metrics;
+
+    //Modelo de temporização dos enlaces de saída deste peer
+    sim::LinkTiming m_LinkTiming;
+
+    //Ruído do sentido de saída de cada porta (cada um com seu fluxo aleatório)
+    std::vector<noise::NoiseModel> m_Noise;
+
+    //Enlaces das portas deste peer
+    inline std::span<PortLink> ports() const { return Topology::global().ports(m_Id); }
+
+    //Portas conectadas deste peer
+    inline const PortMask &activePorts() const { return Topology::global().active(m_Id); }
+
+    /**
+	 * Método que entrega o frame à outra extremidade do enlace, conforme o modo de despacho
+	 */
+    template <error_control::Policy P>
+    static void deliver(const PortLink &link, Ether2Frame &frame);
+
+    /**
+	 * Método que transmite o frame pelo enlace da interface (contadores, tempo do enlace e ruído)
+	 */
+    template <error_control::Policy P>
+    void transmit(uint16_t interface, Ether2Frame &frame);
+
+    /**
+	 * Métodos análogos a deliver/transmit para uma rajada (até BURST_MAX frames, mantendo a ordem):
+	 * um switch recebe a rajada inteira em uma só chamada, os demais peers recebem frame a frame
+	 */
+    template <error_control::Policy P>
+    static void deliverBurst(const PortLink &link, std::span<Ether2Frame *const> frames);
+    template <error_control::Policy P>
+    void transmitBurst(uint16_t interface, std::span<Ether2Frame *const> frames);
+
+    //Cópia do frame com os bits invertidos pelo ruído do enlace da interface
+    Ether2Frame corrupted(uint16_t interface, const Ether2Frame &frame);
+
+    //Agenda a chegada de uma cópia do frame à extremidade do enlace, no instante frame.arrivedAt
+    template <error_control::Policy P>
+    static void scheduleArrival(const PortLink &link, const Ether2Frame &frame);
+
+    friend struct checkpoint::Access;
+
 public:
-    EthernetPeer(ERROR_CONTROL error_control_type, unsigned port_count);
+    //Quantidade máxima de frames processados por chamada nos métodos de rajada (rajadas maiores são divididas)
+    static constexpr size_t BURST_MAX = VERIFY_BATCH_MAX;
+
+    EthernetPeer(ERROR_CONTROL error_control_type, unsigned port_count, PeerKind kind = PeerKind::Other);
+
+    static void setDispatchMode(DispatchMode mode);
+    static DispatchMode dispatchMode();
+
+    //Frames em trânsito nos enlaces, na ordem em que foram enviados
+    static std::vector<WireFrame> framesInFlight();
+
+    //Coloca uma cópia do frame em trânsito até a extremidade 'link' (ex.: ao restaurar um checkpoint)
+    static void putInFlight(const PortLink &link, const Ether2Frame &frame);
+
+    EthernetPeer(const EthernetPeer &) = delete;
+    EthernetPeer &operator=(const EthernetPeer &) = delete;
+
+    PeerId id() const { return m_Id; }
+
+    //Contadores do peer (leitura via metrics().snapshot())
+    const metrics::PeerMetrics &metrics() const { return m_Metrics; }
 
     /**
 	 * Método auxiliar que simula a conexão entre 2 computadores, utilizando suas portas
@@ -29,10 +144,17 @@ public:
 	 * 				const Ref<EthernetPeer> &B	=>	Computador B
 	 * 				unsigned portA				=>	Porta do computador A
 	 * 				unsigned portA				=>	Porta do computador B
+	 * 				double bitErrorRate			=>	Taxa de erro de bit do enlace (nos dois sentidos)
 	 * 
 	 * Retorno: void
 	 */
-    static void connect(const Ref<EthernetPeer> &A, const Ref<EthernetPeer> &B, unsigned portA, unsigned portB);
+    static void connect(const Ref<EthernetPeer> &A, const Ref<EthernetPeer> &B, unsigned portA, unsigned portB,
+                        double bitErrorRate = noise::DEFAULT_BIT_ERROR_RATE);
+
+    /**
+	 * Método que altera a taxa de erro de bit do sentido de saída de uma porta (inicia um novo fluxo aleatório)
+	 */
+    void setBitErrorRate(unsigned port, double bitErrorRate);
 
     /**
 	 * Método auxiliar que simula a desconexão entre dois computadores
@@ -44,33 +166,137 @@ public:
 	 */
     static void disconnect(const Ref<EthernetPeer> &A, const Ref<EthernetPeer> &B);
 
+    ERROR_CONTROL errorControl() const { return m_ErrorControlType; }
+
     /**
 	 * Método que simula o envio de um frame pela interface
+	 * (entrada em tempo de execução: escolhe a política uma vez e segue pelo caminho especializado)
 	 */
     virtual void sendFrame(uint16_t interface, Ether2Frame &frame);
     /**
 	 * Método que simula o recebimento de uma frame pela interface
 	 */
-    virtual void receiveFrame(const EthernetPeer *const sender_ptr, Ether2Frame &frame) = 0;
-    virtual ~EthernetPeer() {}
+    virtual void receiveFrame(uint16_t interface, Ether2Frame &frame) = 0;
+
+    /**
+	 * Métodos análogos aos acima para uma rajada de frames na mesma interface: o custo fixo de cada chamada
+	 * (despacho da política, leitura do relógio, log) é pago uma vez por rajada de até BURST_MAX frames.
+	 * Por padrão, os frames são recebidos um a um.
+	 * 
+	 * Parâmetros:	uint16_t interface				=>	Interface de saída/entrada
+	 * 				std::span<Ether2Frame> frames	=>	Frames da rajada, em ordem
+	 * 
+	 * Retorno: void
+	 */
+    virtual void sendFrames(uint16_t interface, std::span<Ether2Frame> frames);
+    virtual void receiveFrames(uint16_t interface, std::span<Ether2Frame> frames);
+
+    //Desconecta todas as portas e remove o peer da topologia
+    virtual ~EthernetPeer();
 };
 
-class Host : public EthernetPeer
+class Host final : public EthernetPeer
 {
+public:
+    class FrameAwaiter;
+
 private:
     bool m_PromiscuousMode = false;
 
+    //Grupos multicast assinados por este host
+    std::unordered_set<uint64_t> m_Groups;
+
+    /**
+	 * Método que envia um frame de controle de grupo (join/leave) ao endereço do grupo
+	 */
+    void sendGroupControl(GroupOp op, const MAC &group, uint16_t interface);
+
+    //Frames aceitos guardados para as aplicações (só depois da primeira chamada a receive) e as corrotinas esperando um frame
+    bool m_Listening = false;
+    std::deque<Ether2Frame> m_Inbox;
+    std::deque<FrameAwaiter *> m_Waiters;
+
+    //Entrega o frame aceito à primeira aplicação esperando (retomada como um evento) ou o guarda na caixa de entrada
+    void toApplication(const Ether2Frame &frame);
+
+    friend struct checkpoint::Access;
+
 public:
     MAC m_MAC;
 
+    //Frames guardados na caixa de entrada enquanto nenhuma aplicação espera (os excedentes são descartados)
+    static constexpr size_t INBOX_CAPACITY = 64;
+
+    //Espera de uma corrotina por um frame aceito pelo host (ver receive)
+    class FrameAwaiter
+    {
+    private:
+        Host *m_Host;
+        std::coroutine_handle<> m_Handle;
+        Ether2Frame m_Frame;
+
+        friend class Host;
+
+    public:
+        explicit FrameAwaiter(Host *host) : m_Host(host) {}
+        FrameAwaiter(const FrameAwaiter &) = delete;
+        FrameAwaiter &operator=(const FrameAwaiter &) = delete;
+
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> handle);
+        Ether2Frame await_resume() { return m_Frame; }
+
+        //Uma corrotina destruída enquanto espera (sim::reset) sai da lista de espera do host
+        ~FrameAwaiter();
+    };
+
+    /**
+	 * Método que espera o próximo frame aceito pelo host (co_await host->receive() dentro de uma sim::Task)
+	 * 
+	 * Retorno: FrameAwaiter	=>	Resulta em uma cópia do frame (imediatamente, se já havia um na caixa de entrada)
+	 */
+    FrameAwaiter receive();
+
     /**
 	 * Método que simula o envio de um frame pela interface
 	 */
-    virtual void receiveFrame(const EthernetPeer *const sender_ptr, Ether2Frame &frame) override;
+    virtual void receiveFrame(uint16_t interface, Ether2Frame &frame) override;
+
+    /**
+	 * Método que simula o envio de um frame pela interface, carimbando o instante de envio (origem do fluxo)
+	 */
+    virtual void sendFrame(uint16_t interface, Ether2Frame &frame) override;
+
+    /**
+	 * Método que envia a rajada de frames pela interface, um logo após o outro no enlace
+	 * (o relógio é lido uma vez: cada frame parte quando o anterior terminou de ser serializado)
+	 */
+    virtual void sendFrames(uint16_t interface, std::span<Ether2Frame> frames) override;
+
+    //Versões especializadas para a política P (instanciadas para todas as políticas de error_control.hpp)
+    template <error_control::Policy P>
+    void receiveFrameT(uint16_t interface, Ether2Frame &frame);
+    template <error_control::Policy P>
+    void sendFrameT(uint16_t interface, Ether2Frame &frame);
+    template <error_control::Policy P>
+    void sendFramesT(uint16_t interface, std::span<Ether2Frame> frames);
 
     void setPromiscuousMode(bool promiscuous);
 
+    /**
+	 * Métodos que assinam/cancelam um grupo multicast: o host passa a aceitar frames para o grupo
+	 * e avisa os switches (que aprendem a porta por snooping)
+	 * 
+	 * Parâmetros:	const MAC &group	=>	Endereço do grupo (precisa ser multicast)
+	 * 				uint16_t interface	=>	Interface por onde o aviso é enviado
+	 * 
+	 * Retorno: void
+	 */
+    void joinGroup(const MAC &group, uint16_t interface = 0);
+    void leaveGroup(const MAC &group, uint16_t interface = 0);
+
     Host(const MAC &mac, ERROR_CONTROL error_control_type, unsigned int port_count = 1);
+    ~Host();
 };
 
 struct SwitchTableEntry
@@ -79,30 +305,298 @@ struct SwitchTableEntry
     uint64_t lastUpdate;
 };
 
-using SwitchTable = std::unordered_map<MAC, SwitchTableEntry>;
+//Tabela de MACs por VLAN: a chave é (VID << 48) | MAC
+using SwitchTable = std::unordered_map<uint64_t, SwitchTableEntry>;
+
+//VLAN das portas que não foram configuradas
+constexpr uint16_t DEFAULT_VLAN = 1;
+constexpr uint16_t NO_VLAN = 0xFFFF;
+
+//Configuração IEEE 802.1Q de uma porta do switch
+struct PortVlan
+{
+    bool trunk = false;           //Access: frames sem tag, todos na VLAN pvid. Trunk: frames com tag das VLANs permitidas
+    uint16_t pvid = DEFAULT_VLAN; //Access: VLAN da porta. Trunk: VLAN nativa (enviada e recebida sem tag)
+};
+
+//Agregação de enlaces (LAG): várias portas formam uma porta lógica, representada pela primeira delas
+constexpr uint16_t NO_LAG = 0xFFFF;
+constexpr uint16_t NO_MEMBER = 0xFFFF;
+constexpr size_t MAX_LAG_MEMBERS = 64;
+
+struct Lag
+{
+    std::vector<uint16_t> members;
+    uint64_t floodStamp = 0; //Última inundação que já saiu por este LAG (cada inundação sai por um só membro)
+};
+
+//Portas de um grupo multicast: as aprendidas por snooping e as configuradas estaticamente
+struct GroupEntry
+{
+    PortMask ports;       //União das duas (usada no encaminhamento)
+    PortMask staticPorts; //Não são removidas por um leave
+};
+
+using GroupTable = std::unordered_map<MAC, GroupEntry>;
 
-class Switch : public EthernetPeer
+//Decisão de encaminhamento de um frame, tomada apenas a partir do cabeçalho
+struct ForwardDecision
+{
+    enum Action : uint8_t
+    {
+        Forward,      //Enviar pela interface 'interface'
+        FloodUnknown, //Destino desconhecido: enviar a todas as interfaces exceto a de entrada
+        FloodExpired, //Destino conhecido, mas com TTL expirado (entrada removida): idem
+        Filter,       //Destino está na própria interface de entrada: descartar
+        Broadcast,    //Broadcast ou multicast sem grupo registrado: todas as interfaces exceto a de entrada
+        Multicast,    //Grupo registrado: apenas as portas do grupo, exceto a de entrada
+        DropVlan      //VLAN do frame não é permitida na porta de entrada: descartar
+    } action;
+    uint16_t interface;
+    const PortMask *group = nullptr; //Portas do grupo (Multicast); válido até a próxima mudança na tabela de grupos
+};
+
+class Switch final : public EthernetPeer
 {
 private:
-    const uint8_t MAX_TABLE_SIZE = 4;
+    const size_t MAX_TABLE_SIZE;
 
     SwitchTable m_SwitchTable;
+    GroupTable m_GroupTable;
+
+    //Configuração de VLAN de cada porta e, para cada VLAN, as portas que participam dela
+    std::vector<PortVlan> m_PortVlans;
+    std::unordered_map<uint16_t, PortMask> m_VlanPorts;
+
+    //Latência do salto que termina neste switch (do fim da recepção no peer anterior até o fim da recepção aqui)
+    latency::Histogram m_HopLatency;
+
+    //Portas de saída de uma inundação/replicação (pilha: uma entrega pode voltar a este switch antes do fim)
+    std::vector<uint16_t> m_Egress;
+
+    SwitchingMode m_SwitchingMode = SwitchingMode::StoreAndForward;
+
+    //LAG de cada porta (NO_LAG: porta avulsa) e os LAGs do switch
+    std::vector<uint16_t> m_PortLag;
+    std::vector<Lag> m_Lags;
+    uint64_t m_FloodStamp = 0;
+
+    /**
+	 * Método que escolhe a porta física de saída de uma porta lógica: um membro ativo do LAG,
+	 * pelo hash do fluxo (os frames de um fluxo saem sempre pelo mesmo membro, sem reordenação).
+	 * O hash cobre todos os membros configurados: quando um cai, só os fluxos dele passam para os outros
+	 * 
+	 * Retorno: uint16_t	=>	A própria porta (fora de LAG), o membro escolhido ou NO_MEMBER (nenhum membro conectado)
+	 */
+    uint16_t lagMember(uint16_t port, uint64_t src, uint64_t dst, uint16_t vid) const;
+
+    //Portas que compartilham a configuração da porta (os membros do seu LAG, ou só ela)
+    std::vector<uint16_t> lagPorts(uint16_t port) const;
+
+    //Filas de saída de cada porta (vazio: os frames saem no instante em que são encaminhados)
+    std::vector<queueing::EgressQueue> m_EgressQueues;
+
+    /**
+	 * Método que coloca o frame na saída da porta: transmite direto ou, com filas, enfileira na classe da prioridade
+	 */
+    template <error_control::Policy P>
+    void send(uint16_t port, Ether2Frame &frame, unsigned priority);
+
+    //Agenda o próximo serviço da fila da porta (quando o enlace livra e algum frame está pronto)
+    template <error_control::Policy P>
+    void scheduleService(uint16_t port);
+
+    //Transmite o próximo frame escolhido pelo escalonador da fila da porta, no instante 'at'
+    template <error_control::Policy P>
+    void serve(uint16_t port, sim::Time at);
+
+    //Agenda de novo o serviço das filas que tinham um pendente (as filas foram restauradas sem os seus eventos)
+    void resumeQueues();
+
+    friend struct checkpoint::Access;
+
+    /**
+	 * Método que simula o envio de um frame a todas as interfaces conectadas da VLAN, exceto a de entrada
+	 * (os métodos de envio retornam os bytes transmitidos, somando todas as cópias)
+	 */
+    template <error_control::Policy P>
+    size_t sendToAllExceptSender(uint16_t senderInterface, uint16_t vid, Ether2Frame &frame);
+
+    /**
+	 * Método que envia o frame da VLAN vid por uma porta, com ou sem tag conforme a configuração da porta
+	 */
+    template <error_control::Policy P>
+    size_t egress(uint16_t port, uint16_t vid, Ether2Frame &frame);
+
+    /**
+	 * Método que envia o frame da VLAN vid pelas portas m_Egress[first..], trocando a tag uma vez por grupo
+	 * (primeiro as portas sem tag, depois as com tag) em vez de uma vez por porta
+	 */
+    template <error_control::Policy P>
+    size_t egressBatch(size_t first, uint16_t vid, Ether2Frame &frame);
+
+    /**
+	 * Método que envia pela mesma porta vários frames encaminhados (Forward), com ou sem tag conforme a porta,
+	 * como uma rajada para o próximo peer
+	 * 
+	 * Parâmetros:	uint16_t port							=>	Porta física de saída
+	 * 				std::span<Ether2Frame *const> frames	=>	Frames, em ordem de chegada
+	 * 				const uint16_t *vids					=>	VLAN de cada frame
+	 * 
+	 * Retorno: size_t	=>	Bytes transmitidos
+	 */
+    template <error_control::Policy P>
+    size_t egressBurst(uint16_t port, std::span<Ether2Frame *const> frames, const uint16_t *vids);
+
+    //Contabiliza a chegada do frame pela interface e calcula quando ele sai, conforme o modo de comutação
+    void arrive(uint16_t interface, Ether2Frame &frame);
+
+    /**
+	 * Método que executa a decisão de encaminhamento de um frame
+	 * 
+	 * Retorno: size_t	=>	Bytes transmitidos (todas as cópias)
+	 */
+    template <error_control::Policy P>
+    size_t apply(const ForwardDecision &decision, uint16_t senderInterface, uint16_t vid, Ether2Frame &frame);
+
+    /**
+	 * Método que consulta o destino de um frame na tabela de MACs/grupos (sem aprender a origem)
+	 * 
+	 * Retorno: ForwardDecision	=>	O que fazer com o frame (ver decide)
+	 */
+    ForwardDecision lookup(uint64_t dst, uint16_t ingressInterface, uint16_t vid, uint64_t currentTime);
+
+    //Remove a porta de todas as VLANs (e esquece os endereços aprendidos nela)
+    void clearPortVlans(uint16_t port);
+
+    /**
+	 * Método que aprende (ou atualiza) a interface de um MAC, removendo a entrada mais antiga se a tabela estiver cheia
+	 */
+    void learn(uint64_t key, uint16_t interface, uint64_t currentTime);
+
+    //Chave da tabela de MACs
+    static uint64_t tableKey(uint16_t vid, uint64_t mac) { return (uint64_t)vid << 48 | mac; }
+
+    //Tempo atual usado pela tabela (ms)
+    static uint64_t tableNow();
 
     /**
-	 * Método que simula o envio de um frame a todos as interfaces conectadas
+	 * Método que replica o frame para as portas do grupo, exceto a de entrada
 	 */
-    void sendToAllExceptSender(uint16_t senderInterface, Ether2Frame &frame);
+    template <error_control::Policy P>
+    size_t sendToGroup(uint16_t senderInterface, uint16_t vid, const PortMask &group, Ether2Frame &frame);
 
     /**
-	 * Método devolve a interface do remetente
+	 * Método que aplica um frame de controle de grupo (join/leave) recebido pela interface
+	 * 
+	 * Parâmetros:	const uint8_t *payload		=>	Payload do frame de controle
+	 * 				uint16_t ingressInterface	=>	Interface por onde o frame entrou
+	 * 
+	 * Retorno: void
 	 */
-    size_t getSenderInterface(const EthernetPeer *const sender_ptr);
+    void snoop(const uint8_t *payload, uint16_t ingressInterface);
 
 public:
+    /**
+	 * Método que decide a VLAN de um frame que entrou pela interface
+	 * 
+	 * Parâmetros:	bool tagged					=>	Se o frame tem tag 802.1Q
+	 * 				uint16_t tci				=>	TCI da tag
+	 * 				uint16_t ingressInterface	=>	Interface por onde o frame entrou
+	 * 
+	 * Retorno: uint16_t	=>	VID, ou NO_VLAN se a VLAN não é permitida na porta
+	 */
+    uint16_t classify(bool tagged, uint16_t tci, uint16_t ingressInterface) const;
+
+    /**
+	 * Método que aprende a origem e decide o destino de um frame usando apenas o cabeçalho
+	 * 
+	 * Parâmetros:	uint64_t src, dst			=>	MACs de origem e destino
+	 * 				uint16_t ingressInterface	=>	Porta lógica por onde o frame entrou (ver logicalPort)
+	 * 				uint16_t vid				=>	VLAN do frame (ver classify)
+	 * 				uint64_t currentTime		=>	Tempo atual da tabela (ms)
+	 * 
+	 * Retorno: ForwardDecision	=>	O que fazer com o frame
+	 */
+    ForwardDecision decide(uint64_t src, uint64_t dst, uint16_t ingressInterface, uint16_t vid, uint64_t currentTime);
+
+    /**
+	 * Métodos que configuram a VLAN de uma porta
+	 * 
+	 * setAccessPort:	a porta pertence só à VLAN vid; frames saem sem tag
+	 * setTrunkPort:	a porta pertence às VLANs 'allowed' (e à nativa); frames saem com tag, exceto os da VLAN nativa
+	 */
+    void setAccessPort(uint16_t port, uint16_t vid);
+    void setTrunkPort(uint16_t port, const std::vector<uint16_t> &allowed, uint16_t nativeVid = DEFAULT_VLAN);
+
+    //Portas que participam da VLAN
+    const PortMask *vlanPorts(uint16_t vid) const;
+
+    /**
+	 * Método que agrega portas em um LAG: para aprendizado, inundação e grupos elas são uma só porta lógica
+	 * (a primeira da lista), e cada frame sai por um membro escolhido pelo hash de origem/destino/VLAN.
+	 * Os membros passam a usar a configuração de VLAN da primeira porta.
+	 * 
+	 * Parâmetros: const std::vector<uint16_t> &ports	=>	Portas do LAG (ainda fora de outro LAG)
+	 * 
+	 * Retorno: uint16_t	=>	Identificador do LAG
+	 */
+    uint16_t addLag(const std::vector<uint16_t> &ports);
+
+    //Membros do LAG
+    const std::vector<uint16_t> &lagMembers(uint16_t lag) const { return m_Lags.at(lag).members; }
+
+    //Porta lógica da porta física (a primeira porta do seu LAG, ou ela mesma)
+    uint16_t logicalPort(uint16_t port) const { return m_PortLag[port] == NO_LAG ? port : m_Lags[m_PortLag[port]].members[0]; }
+
+    //Quantidade de entradas na tabela de MACs
+    size_t tableSize() const { return m_SwitchTable.size(); }
+
+    /**
+	 * Métodos que configuram estaticamente uma porta em um grupo multicast
+	 * (o grupo passa a ser registrado e seus frames vão só para as portas do grupo)
+	 */
+    void addGroupPort(const MAC &group, uint16_t port);
+    void removeGroupPort(const MAC &group, uint16_t port);
+
+    //Portas do grupo (nullptr se o grupo não está registrado)
+    const PortMask *groupPorts(const MAC &group) const;
+
     /**
 	 * Método que simula o envio de um frame pela interface
 	 */
-    virtual void receiveFrame(const EthernetPeer *const sender_ptr, Ether2Frame &frame) override;
+    virtual void receiveFrame(uint16_t interface, Ether2Frame &frame) override;
+
+    /**
+	 * Método que recebe uma rajada de frames pela interface: relógio da tabela lido uma vez, verificação
+	 * intercalada de todos os payloads, aprendizado em lote (uma só inserção por sequência de frames da mesma
+	 * origem) e os frames encaminhados agrupados por porta de saída, seguindo como rajada para o próximo peer
+	 */
+    virtual void receiveFrames(uint16_t interface, std::span<Ether2Frame> frames) override;
+
+    //Versões especializadas para a política P (instanciadas para todas as políticas de error_control.hpp)
+    template <error_control::Policy P>
+    void receiveFrameT(uint16_t interface, Ether2Frame &frame);
+    template <error_control::Policy P>
+    void receiveFramesT(uint16_t interface, std::span<Ether2Frame *const> frames);
+
+    const latency::Histogram &hopLatency() const { return m_HopLatency; }
+
+    void setSwitchingMode(SwitchingMode mode) { m_SwitchingMode = mode; }
+    SwitchingMode switchingMode() const { return m_SwitchingMode; }
+
+    /**
+	 * Método que habilita filas de saída limitadas em todas as portas (ver egress_queue.hpp)
+	 * Com filas, os frames só saem dentro do laço de eventos (sim::run)
+	 * 
+	 * Parâmetros: const queueing::QueueConfig &config	=>	Capacidade, escalonamento e política de descarte
+	 * 
+	 * Retorno: void
+	 */
+    void setEgressQueues(const queueing::QueueConfig &config);
+
+    //Fila de saída da porta (nullptr se as filas não estão habilitadas)
+    const queueing::EgressQueue *egressQueue(uint16_t port) const { return m_EgressQueues.empty() ? nullptr : &m_EgressQueues[port]; }
 
-    Switch(ERROR_CONTROL error_control_type, unsigned int port_count = 32);
+    Switch(ERROR_CONTROL error_control_type, unsigned int port_count = 32, size_t table_size = 4);
 };
\ No newline at end of file
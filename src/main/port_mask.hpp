@@ -0,0 +1,110 @@
+/**
+ * Header criado para representar conjuntos de portas como máscaras de bits
+ *
+ * Um bit por porta em palavras de 64 bits, com tamanho definido em tempo de execução (switches podem ter
+ * milhares de portas). Percorrer o conjunto custa uma iteração por palavra mais uma por bit ligado.
+ */
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class PortMask
+{
+private:
+    std::vector<uint64_t> m_Words;
+
+public:
+    static constexpr size_t NO_PORT = SIZE_MAX;
+
+    PortMask(size_t port_count = 0) : m_Words((port_count + 63) / 64) {}
+
+    //Quantidade de portas representáveis sem crescer
+    size_t capacity() const { return m_Words.size() * 64; }
+
+    void set(size_t port)
+    {
+        if (port >= capacity())
+            m_Words.resize(port / 64 + 1);
+        m_Words[port / 64] |= 1ull << (port % 64);
+    }
+
+    void reset(size_t port)
+    {
+        if (port < capacity())
+            m_Words[port / 64] &= ~(1ull << (port % 64));
+    }
+
+    bool test(size_t port) const { return port < capacity() && (m_Words[port / 64] >> (port % 64)) & 1; }
+
+    bool any() const
+    {
+        for (uint64_t w : m_Words)
+            if (w)
+                return true;
+        return false;
+    }
+
+    size_t count() const
+    {
+        size_t n = 0;
+        for (uint64_t w : m_Words)
+            n += std::popcount(w);
+        return n;
+    }
+
+    /**
+     * Chama f(porta) para cada porta do conjunto, em ordem crescente
+     *
+     * Parâmetros:	F &&f			=>	Função chamada com cada porta (size_t)
+     * 				size_t except	=>	Porta a pular (ex.: a de entrada do frame)
+     *
+     * Retorno: void
+     */
+    template <class F>
+    void forEach(F &&f, size_t except = NO_PORT) const
+    {
+        for (size_t i = 0; i < m_Words.size(); i++)
+        {
+            uint64_t w = m_Words[i];
+            if (except / 64 == i)
+                w &= ~(1ull << (except % 64));
+            while (w)
+            {
+                f(i * 64 + std::countr_zero(w));
+                w &= w - 1;
+            }
+        }
+    }
+
+    /**
+     * Chama f(porta) para cada porta presente neste conjunto e em 'other' (interseção palavra a palavra)
+     *
+     * Parâmetros:	const PortMask &other	=>	Segundo conjunto (ex.: as portas conectadas)
+     * 				F &&f					=>	Função chamada com cada porta (size_t)
+     * 				size_t except			=>	Porta a pular
+     *
+     * Retorno: void
+     */
+    template <class F>
+    void forEachAnd(const PortMask &other, F &&f, size_t except = NO_PORT) const
+    {
+        size_t words = std::min(m_Words.size(), other.m_Words.size());
+        for (size_t i = 0; i < words; i++)
+        {
+            uint64_t w = m_Words[i] & other.m_Words[i];
+            if (except / 64 == i)
+                w &= ~(1ull << (except % 64));
+            while (w)
+            {
+                f(i * 64 + std::countr_zero(w));
+                w &= w - 1;
+            }
+        }
+    }
+
+    const std::vector<uint64_t> &words() const { return m_Words; }
+};
@@ -0,0 +1,55 @@
+/**
+ * Header auxiliar com o gerador pseudo-aleatório usado na simulação (xoshiro256**)
+ *
+ * Cada consumidor (enlace, thread da simulação de Monte Carlo, fila com RED...) tem seu próprio gerador,
+ * semeado por SplitMix64 a partir de (semente global, número do fluxo). Assim não há estado global
+ * compartilhado entre threads e a mesma semente sempre reproduz a mesma execução.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace rng
+{
+    //SplitMix64: usado apenas para expandir a semente no estado do xoshiro
+    inline uint64_t splitmix64(uint64_t &state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    struct Xoshiro256
+    {
+        uint64_t s[4];
+
+        Xoshiro256(uint64_t seed = 0, uint64_t stream = 0)
+        {
+            uint64_t sm = seed ^ (stream * 0xD1B54A32D192ED03ull);
+            for (uint64_t &word : s)
+                word = splitmix64(sm);
+        }
+
+        static inline uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+        inline uint64_t next()
+        {
+            uint64_t result = rotl(s[1] * 5, 7) * 9;
+            uint64_t t = s[1] << 17;
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= t;
+            s[3] = rotl(s[3], 45);
+            return result;
+        }
+
+        //Real uniforme em [0, 1)
+        inline double nextDouble() { return (next() >> 11) * 0x1.0p-53; }
+
+        //Inteiro uniforme em [0, bound) (método de Lemire, sem divisão)
+        inline uint64_t nextBelow(uint64_t bound) { return (uint64_t)(((unsigned __int128)next() * bound) >> 64); }
+    };
+}
@@ -0,0 +1,156 @@
+#include "router.hpp"
+
+#include <stdexcept>
+
+Router::Router(ERROR_CONTROL error_control_type, unsigned port_count)
+    : EthernetPeer(error_control_type, port_count), m_Interfaces(port_count)
+{
+    m_Metrics.publish("router-" + std::to_string(m_Id), PeerKind::Other);
+}
+
+uint32_t Router::nextHopId(uint16_t port, uint32_t gateway)
+{
+    auto [it, inserted] = m_NextHopIds.try_emplace({port, gateway}, (uint32_t)m_NextHops.size());
+    if (inserted)
+    {
+        if (it->second > lpm::MAX_NEXT_HOP)
+            throw std::length_error("Router: too many next hops");
+        m_NextHops.push_back({port, gateway});
+    }
+    return it->second;
+}
+
+void Router::setInterface(uint16_t port, const MAC &mac, uint32_t address, uint8_t prefixLength)
+{
+    if (port >= m_Interfaces.size())
+        throw std::out_of_range("Router: no such port");
+    m_Interfaces[port] = {mac, address, prefixLength, true};
+    addRoute(address & ipv4::mask(prefixLength), prefixLength, port);
+}
+
+void Router::addRoute(uint32_t prefix, uint8_t length, uint16_t port, uint32_t gateway)
+{
+    if (port >= m_Interfaces.size())
+        throw std::out_of_range("Router: no such port");
+    m_Routes.insert(prefix, length, nextHopId(port, gateway));
+}
+
+bool Router::removeRoute(uint32_t prefix, uint8_t length) { return m_Routes.remove(prefix, length); }
+
+void Router::addArp(uint32_t address, const MAC &mac) { m_Arp.insert_or_assign(address, mac); }
+
+const Router::NextHop *Router::route(uint32_t address) const
+{
+    uint32_t id = m_Routes.lookup(address);
+    return id == lpm::NO_ROUTE ? nullptr : &m_NextHops[id];
+}
+
+void Router::glean(uint16_t interface, uint32_t source, uint64_t mac)
+{
+    const Interface &in = m_Interfaces[interface];
+    if (((source ^ in.address) & ipv4::mask(in.prefixLength)) != 0 || source == in.address)
+        return;
+    auto [it, inserted] = m_Arp.try_emplace(source, MAC(mac));
+    if (!inserted && it->second.bytes != mac)
+        it->second = MAC(mac);
+}
+
+void Router::receiveFrame(uint16_t interface, Ether2Frame &frame)
+{
+    error_control::dispatch(m_ErrorControlType, [&]<class P>(P) { receiveFrameT<P>(interface, frame); });
+}
+
+template <error_control::Policy P>
+void Router::receiveFrameT(uint16_t interface, Ether2Frame &frame)
+{
+    TRACE_SCOPE("Router::receiveFrame");
+    TRACE_FLOW_STEP(frame);
+    L("");
+    L("(ROUTER) Received frame from "_fblu << MAC(frame.src).to_string() << " on interface "_fblu << interface);
+
+    m_Metrics.rx(interface, frame.wireSize());
+    sim::advanceTo(frame.arrivedAt);
+
+    //Only frames addressed to the interface are routed (broadcasts and other MACs stay in their segment)
+    const Interface &in = m_Interfaces[interface];
+    if (!in.configured || frame.dst != in.mac.bytes)
+    {
+        L("(ROUTER) The frame is not addressed to this interface, dropping it"_fwhi);
+        m_Metrics.drop(metrics::DropReason::NotForUs);
+        return;
+    }
+
+    if (!frame.check<P>())
+    {
+        L(tui::text::Text("(ROUTER) The frame " + std::string(P::field) + " is invalid, dropping it").FRed());
+        m_Metrics.drops.checksumFailures.add();
+        m_Metrics.drop(metrics::DropReason::Checksum);
+        return;
+    }
+
+    uint8_t *header = frame.data;
+    if (frame.type != ipv4::ETHERTYPE || !ipv4::valid(header, Ether2Frame::PAYLOAD_SIZE))
+    {
+        L("(ROUTER) Not a valid IPv4 packet, dropping it"_fred);
+        m_Metrics.drop(metrics::DropReason::Malformed);
+        return;
+    }
+
+    uint32_t destination = ipv4::load32(header + ipv4::DESTINATION);
+    glean(interface, ipv4::load32(header + ipv4::SOURCE), frame.src);
+
+    for (const Interface &own : m_Interfaces)
+        if (own.configured && own.address == destination)
+        {
+            L("(ROUTER) Packet addressed to the router itself"_fgre);
+            m_Delivered++;
+            return;
+        }
+
+    if (header[ipv4::TTL] <= 1)
+    {
+        L("(ROUTER) TTL expired, dropping the packet"_fred);
+        m_Metrics.drop(metrics::DropReason::TtlExpired);
+        return;
+    }
+
+    uint32_t id;
+    {
+        TRACE_SCOPE("Router::lookup");
+        id = m_Routes.lookup(destination);
+    }
+    if (id == lpm::NO_ROUTE)
+    {
+        L(tui::text::Text("(ROUTER) No route to " + ipv4::toString(destination) + ", dropping the packet").FRed());
+        m_Metrics.drop(metrics::DropReason::NoRoute);
+        return;
+    }
+
+    const NextHop &hop = m_NextHops[id];
+    auto arp = m_Arp.find(hop.gateway ? hop.gateway : destination);
+    if (arp == m_Arp.end())
+    {
+        L(tui::text::Text("(ROUTER) No ARP entry for the next hop of " + ipv4::toString(destination) + ", dropping the packet").FRed());
+        m_Metrics.drop(metrics::DropReason::NoArp);
+        return;
+    }
+
+    //Rewrite: one hop less, the egress interface as source and the next hop as destination, then a new check field
+    ipv4::decrementTtl(header);
+    frame.src = m_Interfaces[hop.port].mac.bytes;
+    frame.dst = arp->second.bytes;
+    {
+        TRACE_SCOPE("checksum");
+        frame.verifyContent = P::compute(frame.data, Ether2Frame::PAYLOAD_SIZE);
+    }
+
+    L(tui::text::Text("(ROUTER) Forwarding to " + ipv4::toString(destination) + " through interface " + std::to_string(hop.port)).FGreen());
+    frame.hopStart = frame.arrivedAt;
+    frame.departedAt = frame.arrivedAt + sim::SWITCH_PROCESSING;
+    m_Forwarded++;
+    transmit<P>(hop.port, frame);
+}
+
+//Specialized pipelines reachable from outside this file (stories, benchmarks)
+#define INSTANTIATE_ROUTER(P) template void Router::receiveFrameT<error_control::P>(uint16_t, Ether2Frame &);
+ERROR_CONTROL_POLICIES(INSTANTIATE_ROUTER)
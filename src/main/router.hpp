@@ -0,0 +1,104 @@
+/**
+ * Header criado para um roteador IPv4 (camada 3) entre os enlaces Ethernet da simulação
+ *
+ * Cada porta é uma interface com MAC e endereço IPv4 próprios (a sub-rede dela vira uma rota conectada).
+ * Um frame IPv4 endereçado ao MAC da interface de entrada é validado (versão, IHL, checksum do cabeçalho),
+ * tem o TTL decrementado (com o checksum atualizado de forma incremental) e é encaminhado pelo prefixo mais longo
+ * (lpm::Dir24_8). Os MACs de saída vêm do cache ARP: entradas estáticas e as aprendidas dos pacotes recebidos de
+ * vizinhos diretos; não há troca de mensagens ARP, então um destino sem entrada é descartado.
+ *
+ *   Ref<Router> R = std::make_shared<Router>(ERROR_CONTROL::CRC, 2);
+ *   R->setInterface(0, MAC("02:00:00:00:01:00"), ipv4::parse("10.0.0.1"), 24);
+ *   R->setInterface(1, MAC("02:00:00:00:01:01"), ipv4::parse("10.0.1.1"), 24);
+ *   R->addRoute(ipv4::parse("192.168.0.0"), 16, 1, ipv4::parse("10.0.1.2"));
+ *   R->addArp(ipv4::parse("10.0.1.2"), MAC("02:00:00:00:02:00"));
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "ipv4.hpp"
+#include "lpm.hpp"
+#include "peers.hpp"
+
+class Router final : public EthernetPeer
+{
+public:
+    struct Interface
+    {
+        MAC mac = MAC(0ull);
+        uint32_t address = 0;
+        uint8_t prefixLength = 0;
+        bool configured = false;
+    };
+
+    //Próximo salto de uma rota: porta de saída e gateway (0: destino na sub-rede da porta)
+    struct NextHop
+    {
+        uint16_t port;
+        uint32_t gateway;
+    };
+
+private:
+    std::vector<Interface> m_Interfaces;
+    lpm::Dir24_8 m_Routes;
+    std::vector<NextHop> m_NextHops;
+    std::map<std::pair<uint16_t, uint32_t>, uint32_t> m_NextHopIds; //Cada (porta, gateway) aparece uma vez em m_NextHops
+    std::unordered_map<uint32_t, MAC> m_Arp;
+
+    uint64_t m_Forwarded = 0, m_Delivered = 0;
+
+    uint32_t nextHopId(uint16_t port, uint32_t gateway);
+
+    //Aprende o MAC de quem mandou o pacote, se ele é um vizinho direto da interface de entrada
+    void glean(uint16_t interface, uint32_t source, uint64_t mac);
+
+public:
+    Router(ERROR_CONTROL error_control_type, unsigned port_count);
+
+    /**
+     * Método que configura a interface de uma porta e adiciona a rota conectada da sub-rede dela
+     *
+     * Parâmetros:	uint16_t port			=>	Porta
+     * 				const MAC &mac			=>	MAC da interface
+     * 				uint32_t address		=>	Endereço IPv4 da interface
+     * 				uint8_t prefixLength	=>	Tamanho do prefixo da sub-rede
+     *
+     * Retorno: void
+     */
+    void setInterface(uint16_t port, const MAC &mac, uint32_t address, uint8_t prefixLength);
+    const Interface &interface(uint16_t port) const { return m_Interfaces.at(port); }
+
+    /**
+     * Método que adiciona (ou substitui) uma rota
+     *
+     * Parâmetros:	uint32_t prefix		=>	Prefixo
+     * 				uint8_t length		=>	Tamanho do prefixo (0: rota padrão)
+     * 				uint16_t port		=>	Porta de saída
+     * 				uint32_t gateway	=>	Próximo roteador (0: o destino está na sub-rede da porta)
+     *
+     * Retorno: void
+     */
+    void addRoute(uint32_t prefix, uint8_t length, uint16_t port, uint32_t gateway = 0);
+    bool removeRoute(uint32_t prefix, uint8_t length);
+
+    //Entrada estática no cache ARP
+    void addArp(uint32_t address, const MAC &mac);
+
+    //Próximo salto do endereço (nullptr se não há rota)
+    const NextHop *route(uint32_t address) const;
+
+    const lpm::Dir24_8 &routes() const { return m_Routes; }
+
+    //Pacotes encaminhados e pacotes endereçados ao próprio roteador
+    uint64_t forwarded() const { return m_Forwarded; }
+    uint64_t delivered() const { return m_Delivered; }
+
+    virtual void receiveFrame(uint16_t interface, Ether2Frame &frame) override;
+
+    template <error_control::Policy P>
+    void receiveFrameT(uint16_t interface, Ether2Frame &frame);
+};
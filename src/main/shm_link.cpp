@@ -0,0 +1,244 @@
+#include "shm_link.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "metrics.hpp"
+#include "topology.hpp"
+
+namespace shm
+{
+    static constexpr uint32_t MAGIC = 0x4E4C5331; //"NLS1"
+    static constexpr uint32_t VERSION = 2;
+
+    //Frames are copied into the ring byte for byte and read by another process
+    static_assert(std::is_trivially_copyable_v<Ether2Frame>);
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free);
+
+    //One direction: the producer owns head, the consumer owns tail, each on its own cache line
+    struct Ring
+    {
+        alignas(metrics::CACHE_LINE_SIZE) std::atomic<uint64_t> head{0};
+        alignas(metrics::CACHE_LINE_SIZE) std::atomic<uint64_t> tail{0};
+    };
+
+    struct alignas(metrics::CACHE_LINE_SIZE) Clock
+    {
+        std::atomic<uint64_t> value{0};
+    };
+
+    struct Segment
+    {
+        std::atomic<uint32_t> magic{0};
+        uint32_t version = VERSION;
+        uint64_t capacity = 0;
+        uint64_t lookahead = 0;
+
+        Clock clocks[2];
+        Ring rings[2]; //rings[s] carries frames from side s to the other side
+
+        Ether2Frame *slots(unsigned ring) { return reinterpret_cast<Ether2Frame *>(this + 1) + ring * capacity; }
+    };
+
+    static std::runtime_error systemError(const std::string &what, const std::string &name)
+    {
+        return std::runtime_error(what + " '" + name + "': " + strerror(errno));
+    }
+
+    Link::Link(const std::string &name, bool create, ERROR_CONTROL error_control_type, sim::Time lookahead, size_t capacity)
+        : EthernetPeer(error_control_type, 1, PeerKind::Remote), m_Name(name), m_Owner(create), m_Side(create ? 0 : 1),
+          m_Lookahead(lookahead)
+    {
+        if (capacity == 0 || (capacity & (capacity - 1)))
+            throw std::runtime_error("Shared-memory ring capacity must be a power of 2");
+        if (lookahead == 0)
+            throw std::runtime_error("Shared-memory link needs a lookahead greater than zero");
+
+        m_Bytes = sizeof(Segment) + 2 * capacity * sizeof(Ether2Frame);
+
+        int fd;
+        if (create)
+        {
+            //A segment left behind by a process that crashed is replaced
+            shm_unlink(name.c_str());
+            fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd < 0 || ftruncate(fd, (off_t)m_Bytes) < 0)
+                throw systemError("Could not create shared-memory segment", name);
+        }
+        else
+        {
+            //Waits for the other process to create and size the segment
+            struct stat st = {};
+            while ((fd = shm_open(name.c_str(), O_RDWR, 0)) < 0)
+            {
+                if (errno != ENOENT)
+                    throw systemError("Could not open shared-memory segment", name);
+                std::this_thread::yield();
+            }
+            while (fstat(fd, &st) == 0 && (size_t)st.st_size < m_Bytes)
+                std::this_thread::yield();
+        }
+
+        void *memory = mmap(nullptr, m_Bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED)
+            throw systemError("Could not map shared-memory segment", name);
+
+        if (create)
+        {
+            m_Segment = new (memory) Segment();
+            m_Segment->capacity = capacity;
+            m_Segment->lookahead = lookahead;
+            m_Segment->magic.store(MAGIC, std::memory_order_release);
+        }
+        else
+        {
+            m_Segment = static_cast<Segment *>(memory);
+            while (m_Segment->magic.load(std::memory_order_acquire) != MAGIC)
+                std::this_thread::yield();
+            if (m_Segment->version != VERSION || m_Segment->capacity != capacity || m_Segment->lookahead != lookahead)
+            {
+                munmap(memory, m_Bytes);
+                throw std::runtime_error("Shared-memory segment '" + name + "' was created with another version, capacity or lookahead");
+            }
+        }
+
+        m_Metrics.publish("shm-" + name, PeerKind::Remote);
+    }
+
+    Link::~Link()
+    {
+        munmap(m_Segment, m_Bytes);
+        if (m_Owner)
+            shm_unlink(m_Name.c_str());
+    }
+
+    bool Link::push(const Ether2Frame &frame)
+    {
+        Ring &ring = m_Segment->rings[m_Side];
+        uint64_t capacity = m_Segment->capacity;
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+
+        //The consumer's index is only read again when the ring looks full
+        if (head - m_CachedTail >= capacity)
+        {
+            m_CachedTail = ring.tail.load(std::memory_order_acquire);
+            if (head - m_CachedTail >= capacity)
+                return false;
+        }
+
+        m_Segment->slots(m_Side)[head & (capacity - 1)] = frame;
+        ring.head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    void Link::receiveFrame(uint16_t interface, Ether2Frame &frame)
+    {
+        m_Metrics.rx(interface, frame.wireSize());
+
+        //The simulation never blocks on a full ring (the other process may be waiting for this one)
+        if (!m_Backlog.empty() || !push(frame))
+            m_Backlog.push_back(frame);
+    }
+
+    void Link::flush()
+    {
+        while (!m_Backlog.empty() && push(m_Backlog.front()))
+            m_Backlog.pop_front();
+    }
+
+    sim::Time Link::earliestPending() const
+    {
+        sim::Time earliest = UINT64_MAX;
+        for (const Ether2Frame &frame : m_Backlog)
+            earliest = std::min(earliest, frame.arrivedAt - m_Lookahead);
+        return earliest;
+    }
+
+    size_t Link::poll()
+    {
+        unsigned from = 1 - m_Side;
+        Ring &ring = m_Segment->rings[from];
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        if (m_CachedHead == tail)
+        {
+            m_CachedHead = ring.head.load(std::memory_order_acquire);
+            if (m_CachedHead == tail)
+                return 0;
+        }
+
+        //Each frame reaches the local peer at its arrival time, computed by the link that transmitted it
+        const Ether2Frame *slots = m_Segment->slots(from);
+        uint64_t mask = m_Segment->capacity - 1;
+        for (uint64_t i = tail; i < m_CachedHead; i++)
+        {
+            const Ether2Frame &frame = slots[i & mask];
+            if (frame.arrivedAt < sim::now())
+                throw std::runtime_error("Frame from shared-memory link '" + m_Name + "' arrived in the past (lookahead mismatch?)");
+
+            m_Metrics.tx(0, frame.wireSize());
+            sim::schedule(frame.arrivedAt, [id = m_Id, copy = frame]() mutable {
+                Topology &topology = Topology::global();
+                if (!topology.peer(id))
+                    return;
+                const PortLink &link = topology.link(id, 0);
+                if (link.connected())
+                    topology.peer(link.peer)->receiveFrame(link.port, copy);
+            });
+        }
+        ring.tail.store(m_CachedHead, std::memory_order_release);
+        return m_CachedHead - tail;
+    }
+
+    sim::Time Link::peerClock() const { return m_Segment->clocks[1 - m_Side].value.load(std::memory_order_acquire); }
+
+    void Link::publish(sim::Time clock) { m_Segment->clocks[m_Side].value.store(clock, std::memory_order_release); }
+
+    size_t run(std::span<Link *const> links, sim::Time until)
+    {
+        size_t executed = 0;
+        sim::Time clock = 0;
+        while (true)
+        {
+            //The clock of a neighbour is read before its ring: whatever it sends after that read arrives at or after the grant
+            sim::Time grant = UINT64_MAX;
+            for (Link *link : links)
+            {
+                sim::Time peer = link->peerClock();
+                grant = std::min(grant, peer > UINT64_MAX - link->lookahead() ? UINT64_MAX : peer + link->lookahead());
+                link->poll();
+            }
+
+            size_t ran = sim::run(std::min(grant - 1, until));
+            executed += ran;
+
+            //Everything before the next event is done, and nothing can arrive before the grant. Frames still waiting
+            //for room in a ring hold the clock back, so the neighbour does not run past their arrival
+            sim::Time next = std::min(sim::nextEvent(), grant);
+            for (Link *link : links)
+            {
+                link->flush();
+                next = std::min(next, link->earliestPending());
+            }
+            for (Link *link : links)
+                link->publish(next);
+
+            if (next > until)
+                break;
+            if (ran == 0 && next == clock)
+                std::this_thread::yield();
+            clock = next;
+        }
+        return executed;
+    }
+}
@@ -0,0 +1,106 @@
+/**
+ * Header criado para ligar uma porta de um processo de simulação a uma porta de outro processo na mesma máquina
+ *
+ * Os dois processos compartilham um segmento de memória POSIX (shm_open + mmap) com um anel SPSC sem travas
+ * por sentido e o relógio de cada lado. Do lado local, o enlace é um peer de uma porta (shm::Link): o frame
+ * transmitido a ele entra no anel já no instante do envio, com o instante de chegada calculado pelo enlace
+ * de quem transmitiu; do outro lado, ele é entregue ao peer conectado à porta do Link nesse instante.
+ * Um frame nunca sai para o outro processo antes do relógio local (um switch cut-through perde a antecipação
+ * nesse salto), então ele sempre chega ao menos um lookahead depois.
+ *
+ * O tempo é sincronizado de forma conservadora: cada processo publica até onde já simulou, e só executa eventos
+ * anteriores ao relógio publicado pelo outro lado mais o atraso mínimo do enlace (lookahead), de modo que nenhum
+ * frame chega ao passo (ver shm::run). Sem sockets: cada processo pode ficar em um nó NUMA (ex.: numactl).
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <string>
+
+#include "frame.hpp"
+#include "peers.hpp"
+#include "sim.hpp"
+
+namespace shm
+{
+    //Frames por sentido no anel (potência de 2)
+    constexpr size_t DEFAULT_CAPACITY = 1024;
+
+    //Atraso mínimo de um frame no enlace padrão: propagação mais a serialização do menor frame
+    constexpr sim::Time DEFAULT_LOOKAHEAD = sim::LinkTiming{}.propagation + sim::LinkTiming{}.serialization(Ether2Frame::WIRE_SIZE);
+
+    //Cabeçalho do segmento compartilhado (os anéis e os frames vêm logo depois)
+    struct Segment;
+
+    class Link final : public EthernetPeer
+    {
+    private:
+        std::string m_Name;
+        bool m_Owner;
+        unsigned m_Side; //0: quem criou o segmento, 1: quem abriu
+
+        Segment *m_Segment = nullptr;
+        size_t m_Bytes = 0;
+        sim::Time m_Lookahead;
+
+        //Índices locais: cópias do índice do outro lado, relidas só quando o anel parece cheio/vazio
+        uint64_t m_CachedTail = 0, m_CachedHead = 0;
+
+        //Frames que não couberam no anel (enviados no próximo flush, sem bloquear a simulação)
+        std::deque<Ether2Frame> m_Backlog;
+
+        bool push(const Ether2Frame &frame);
+
+    public:
+        /**
+         * Construtor que cria (create = true) ou abre o segmento 'name' (o lado que abre espera o outro criar)
+         *
+         * Parâmetros:	const std::string &name		=>	Nome do segmento (ex.: "/nls-fabric-0")
+         * 				bool create					=>	Se este processo cria o segmento
+         * 				ERROR_CONTROL error_control	=>	Método de checagem (o mesmo nos dois processos)
+         * 				sim::Time lookahead			=>	Menor atraso de um frame no enlace (os dois lados devem concordar)
+         * 				size_t capacity				=>	Frames por sentido no anel (potência de 2)
+         */
+        Link(const std::string &name, bool create, ERROR_CONTROL error_control_type, sim::Time lookahead = DEFAULT_LOOKAHEAD,
+             size_t capacity = DEFAULT_CAPACITY);
+        ~Link();
+
+        //Frame transmitido ao Link: segue para o outro processo
+        virtual void receiveFrame(uint16_t interface, Ether2Frame &frame) override;
+
+        //Retira os frames do outro processo do anel e agenda a entrega de cada um no seu instante de chegada
+        size_t poll();
+
+        //Envia os frames que ficaram para trás por falta de espaço no anel
+        void flush();
+
+        //Relógio publicado pelo outro processo (ele já simulou tudo antes desse instante)
+        sim::Time peerClock() const;
+
+        //Publica o relógio deste processo
+        void publish(sim::Time clock);
+
+        //Maior relógio que pode ser publicado enquanto há frames fora do anel (UINT64_MAX sem nenhum)
+        sim::Time earliestPending() const;
+
+        sim::Time lookahead() const { return m_Lookahead; }
+        size_t backlog() const { return m_Backlog.size(); }
+    };
+
+    /**
+     * Método que executa a simulação deste processo até 'until', sincronizada com os outros processos pelos enlaces
+     *
+     * A cada rodada: lê o relógio de cada vizinho, recebe os frames dos anéis, executa os eventos anteriores ao menor
+     * (relógio do vizinho + lookahead) e publica o próprio relógio (o próximo evento, limitado por esse mesmo valor).
+     *
+     * Parâmetros:	std::span<Link *const> links	=>	Enlaces deste processo com outros processos
+     * 				sim::Time until					=>	Último instante a simular
+     *
+     * Retorno: size_t	=>	Quantidade de eventos executados
+     */
+    size_t run(std::span<Link *const> links, sim::Time until);
+}
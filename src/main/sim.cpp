@@ -0,0 +1,117 @@
+#include "sim.hpp"
+#include "task.hpp"
+
+#include <queue>
+#include <vector>
+
+namespace sim
+{
+    static std::atomic<Time> __now{0};
+
+    Time now() { return __now.load(std::memory_order_relaxed); }
+
+    void advanceTo(Time t)
+    {
+        Time current = __now.load(std::memory_order_relaxed);
+        while (current < t && !__now.compare_exchange_weak(current, t, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    //Event queue of the simulation (single threaded: events are scheduled and run by the simulation thread)
+    struct Event
+    {
+        Time at;
+        uint64_t sequence;
+        std::function<void()> fn;
+
+        //Earliest first; ties in scheduling order
+        bool operator>(const Event &other) const { return at != other.at ? at > other.at : sequence > other.sequence; }
+    };
+
+    static std::priority_queue<Event, std::vector<Event>, std::greater<Event>> __events;
+    static uint64_t __sequence = 0;
+    static bool __running = false;
+    static uint64_t __epoch = 0;
+
+    //Detached tasks still alive (intrusive list through their promises)
+    static Task::promise_type *__tasks = nullptr;
+    static size_t __liveTasks = 0;
+
+    void reset()
+    {
+        __now.store(0, std::memory_order_relaxed);
+        __events = {};
+        __sequence = 0;
+        __epoch++;
+
+        //The events that would resume them are gone, so the waiting tasks are destroyed (each one unlinks itself)
+        while (__tasks)
+            std::coroutine_handle<Task::promise_type>::from_promise(*__tasks).destroy();
+    }
+
+    Task::promise_type::~promise_type()
+    {
+        if (!detached)
+            return;
+        (prev ? prev->next : __tasks) = next;
+        if (next)
+            next->prev = prev;
+        __liveTasks--;
+    }
+
+    void spawn(Task task, Time at)
+    {
+        std::coroutine_handle<Task::promise_type> h = std::exchange(task.m_Handle, {});
+        Task::promise_type &promise = h.promise();
+        promise.detached = true;
+        promise.next = __tasks;
+        if (__tasks)
+            __tasks->prev = &promise;
+        __tasks = &promise;
+        __liveTasks++;
+
+        schedule(at, [h]() { h.resume(); });
+    }
+
+    size_t liveTasks() { return __liveTasks; }
+
+    uint64_t epoch() { return __epoch; }
+
+    void schedule(Time at, std::function<void()> fn) { __events.push({at, __sequence++, std::move(fn)}); }
+
+    size_t run(Time until)
+    {
+        size_t executed = 0;
+
+        //Also restored when an event throws (e.g. an exception escaping a task)
+        struct Running
+        {
+            bool outer = !__running;
+            Running() { __running = true; }
+            ~Running()
+            {
+                if (outer)
+                    __running = false;
+            }
+        } running;
+
+        while (!__events.empty() && __events.top().at <= until)
+        {
+            //Moved out before popping: the event may schedule others
+            Event event = std::move(const_cast<Event &>(__events.top()));
+            __events.pop();
+
+            advanceTo(event.at);
+            event.fn();
+            executed++;
+        }
+        return executed;
+    }
+
+    size_t pendingEvents() { return __events.size(); }
+
+    Time nextEvent() { return __events.empty() ? UINT64_MAX : __events.top().at; }
+
+    bool running() { return __running; }
+}
@@ -0,0 +1,79 @@
+/**
+ * Header criado para modelar o tempo simulado da rede
+ *
+ * O relógio simulado conta nanossegundos desde o início da simulação e só avança quando
+ * frames chegam aos peers (ou quando algo o avança explicitamente), independente do relógio de parede.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace sim
+{
+    //Tempo simulado, em nanossegundos
+    using Time = uint64_t;
+
+    constexpr Time NANOSECOND = 1;
+    constexpr Time MICROSECOND = 1000 * NANOSECOND;
+    constexpr Time MILLISECOND = 1000 * MICROSECOND;
+    constexpr Time SECOND = 1000 * MILLISECOND;
+
+    //Tempo simulado atual
+    Time now();
+
+    //Avança o relógio até t (nunca volta no tempo)
+    void advanceTo(Time t);
+
+    //Volta o relógio para zero e descarta os eventos pendentes (início de uma nova simulação)
+    void reset();
+
+    //Quantidade de reinícios (reset) até agora: os eventos agendados em uma época anterior foram descartados
+    uint64_t epoch();
+
+    /**
+     * Agenda um evento: ao ser executado, o relógio avança até 'at' e fn é chamada
+     * (eventos no mesmo instante são executados na ordem em que foram agendados)
+     *
+     * Parâmetros:	Time at						=>	Instante do evento
+     * 				std::function<void()> fn	=>	Ação do evento
+     *
+     * Retorno: void
+     */
+    void schedule(Time at, std::function<void()> fn);
+
+    /**
+     * Executa os eventos pendentes em ordem de tempo (inclusive os agendados durante a execução)
+     *
+     * Parâmetros: Time until	=>	Para antes do primeiro evento posterior a este instante
+     *
+     * Retorno: size_t	=>	Quantidade de eventos executados
+     */
+    size_t run(Time until = UINT64_MAX);
+
+    //Quantidade de eventos agendados e ainda não executados
+    size_t pendingEvents();
+
+    //Instante do próximo evento agendado (UINT64_MAX se não há nenhum)
+    Time nextEvent();
+
+    //Se o laço de eventos (run) está executando: nele, os frames chegam ao outro lado do enlace como eventos
+    bool running();
+
+    /**
+     * Modelo de temporização de um enlace: o frame leva (tamanho / banda) para ser serializado
+     * e mais o atraso de propagação para o primeiro bit chegar ao outro lado
+     */
+    struct LinkTiming
+    {
+        uint64_t bandwidth_bps = 1'000'000'000; //1 Gbps
+        Time propagation = 500 * NANOSECOND;    //~100m de cabo
+
+        constexpr Time serialization(size_t bytes) const { return (Time)bytes * 8 * SECOND / bandwidth_bps; }
+    };
+
+    //Atraso de processamento de um switch entre o fim da recepção e o início da transmissão
+    constexpr Time SWITCH_PROCESSING = 1 * MICROSECOND;
+}
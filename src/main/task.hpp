@@ -0,0 +1,148 @@
+/**
+ * Header criado para escrever o comportamento dos peers como corrotinas (C++20) sobre o laço de eventos da simulação
+ *
+ * Uma aplicação é uma função que retorna sim::Task e espera com co_await: sim::sleep(d) retoma a corrotina
+ * como um evento d nanossegundos simulados depois, e Host::receive() a retoma quando o host aceita um frame.
+ * Nenhuma thread é criada e nada espera pelo relógio de parede: milhares de aplicações custam só os seus quadros
+ * de corrotina, e tudo roda dentro de sim::run.
+ *
+ *   sim::Task ping(Ref<Host> A, MAC B)
+ *   {
+ *       co_await sim::sleep(5 * sim::SECOND);
+ *       ...
+ *       Ether2Frame reply = co_await A->receive();
+ *   }
+ *
+ *   sim::spawn(ping(A, B->m_MAC));
+ *   sim::run();
+ */
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include "sim.hpp"
+
+namespace sim
+{
+    class Task
+    {
+    public:
+        struct promise_type
+        {
+            //Corrotina que espera por esta (co_await task); sem ela, a tarefa é independente (spawn)
+            std::coroutine_handle<> continuation;
+            std::exception_ptr exception;
+
+            //Lista das tarefas independentes vivas (destruídas por sim::reset)
+            promise_type *prev = nullptr, *next = nullptr;
+            bool detached = false;
+
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+            //Tarefas começam suspensas: só rodam quando esperadas ou agendadas por spawn
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            struct FinalAwaiter
+            {
+                bool await_ready() noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+                {
+                    //An awaited task resumes its caller (which destroys it); a detached one is gone
+                    if (std::coroutine_handle<> next = h.promise().continuation)
+                        return next;
+                    h.destroy();
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+            FinalAwaiter final_suspend() noexcept { return {}; }
+
+            void return_void() {}
+
+            //The awaiting coroutine rethrows; a detached task throws out of the event that resumed it (sim::run)
+            void unhandled_exception()
+            {
+                if (!continuation)
+                    throw;
+                exception = std::current_exception();
+            }
+
+            ~promise_type();
+        };
+
+        Task(Task &&other) noexcept : m_Handle(std::exchange(other.m_Handle, {})) {}
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+
+        ~Task()
+        {
+            if (m_Handle)
+                m_Handle.destroy();
+        }
+
+        //Espera a tarefa terminar (a corrotina que espera é retomada logo depois, sem passar pela fila de eventos)
+        auto operator co_await() && noexcept
+        {
+            struct Awaiter
+            {
+                std::coroutine_handle<promise_type> handle;
+
+                bool await_ready() noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept
+                {
+                    handle.promise().continuation = caller;
+                    return handle;
+                }
+
+                void await_resume()
+                {
+                    if (handle.promise().exception)
+                        std::rethrow_exception(handle.promise().exception);
+                }
+            };
+            return Awaiter{m_Handle};
+        }
+
+    private:
+        std::coroutine_handle<promise_type> m_Handle;
+
+        explicit Task(std::coroutine_handle<promise_type> handle) : m_Handle(handle) {}
+
+        friend void spawn(Task task, Time at);
+    };
+
+    /**
+     * Método que agenda uma tarefa independente: ela começa a rodar no instante 'at' (dentro de sim::run)
+     * e seu quadro é liberado quando ela termina, ou por sim::reset se ela ainda estiver esperando
+     *
+     * Parâmetros:	Task task	=>	Tarefa (ainda não iniciada)
+     * 				Time at		=>	Instante do início (padrão: agora)
+     *
+     * Retorno: void
+     */
+    void spawn(Task task, Time at);
+    inline void spawn(Task task) { spawn(std::move(task), now()); }
+
+    //Quantidade de tarefas independentes que ainda não terminaram
+    size_t liveTasks();
+
+    //Espera 'delay' nanossegundos simulados (a corrotina é retomada por um evento)
+    struct Sleep
+    {
+        Time delay;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) const
+        {
+            schedule(now() + delay, [h]() { h.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    inline Sleep sleep(Time delay) { return {delay}; }
+}
@@ -3,9 +3,74 @@
  */
 #include "tests.hpp"
 
+#include "dashboard.hpp"
+#include "ipv4.hpp"
 #include "peers.hpp"
+#include "router.hpp"
+#include "task.hpp"
+#include <atomic>
 #include <memory>
+#include <string>
 #include <thread>
+#include <vector>
+
+/**
+ * Aplicações dos hosts das histórias: cada uma segue o seu próprio roteiro no tempo simulado
+ * (os links têm ruído, então um roteiro não espera por respostas que podem nunca chegar)
+ */
+
+//Aplicação de um host em modo promíscuo: mostra cada frame que o host abriu (nunca termina; sim::reset a destrói)
+static sim::Task sniffer(Ref<Host> host, std::string name)
+{
+    while (true)
+    {
+        Ether2Frame frame = co_await host->receive();
+        L(tui::text::Text("\n[" + name + "] Sniffed '" + std::string((const char *)frame.data) + "' from " + MAC(frame.src).to_string()).FCyan());
+    }
+}
+
+//Aplicação de A: cumprimenta B, avisa que volta logo e só volta depois que o TTL expirou
+static sim::Task A_B_ttl_appA(Ref<Host> A, MAC B)
+{
+    using P = error_control::Crc;
+    L("\n[MAIN] A sends 'Hello' to B"_fmag);
+    co_await sim::sleep(5 * sim::SECOND);
+    {
+        Ether2Frame frame(B, A->m_MAC, "Hello", 6, P{});
+        A->sendFrameT<P>(0, frame);
+    }
+
+    //B answers in the meantime
+    co_await sim::sleep(7 * sim::SECOND);
+    L("\n[MAIN] A sends 'BRB' to B"_fmag);
+    co_await sim::sleep(5 * sim::SECOND);
+    {
+        Ether2Frame frame(B, A->m_MAC, "BRB", 4, P{});
+        A->sendFrameT<P>(0, frame);
+    }
+
+    L("\n[MAIN] After a long time (TTL has expired)"_fmag);
+    co_await sim::sleep(1 * sim::SECOND);
+    L("\n[MAIN] A sends 'I'm Back' to B"_fmag);
+    co_await sim::sleep(16 * sim::SECOND);
+
+    //Create a frame from A to B with the message "Hello World"
+    Ether2Frame frame(B, A->m_MAC, "I'm back!", 10, P{});
+    //Send the frame
+    A->sendFrameT<P>(0, frame);
+}
+
+//Aplicação de B: responde ao cumprimento de A
+static sim::Task A_B_ttl_appB(Ref<Host> B, MAC A)
+{
+    using P = error_control::Crc;
+    co_await sim::sleep(6 * sim::SECOND);
+    L("\n[MAIN] B sends 'Oh, Hello!' to A"_fmag);
+    co_await sim::sleep(5 * sim::SECOND);
+
+    Ether2Frame frame(A, B->m_MAC, "Oh, Hello!", 11, P{});
+    B->sendFrameT<P>(0, frame);
+}
 
 /**
  * Método que simula conexão de computadores A, B e C, com A no Switch S1, B e C no switch S2 e ambos switches conectados
@@ -34,11 +99,12 @@
  */
 void A_B_ttl_andPromC()
 {
-    ERROR_CONTROL test_error_control = ERROR_CONTROL::CRC;
+    using P = error_control::Crc;
+    ERROR_CONTROL test_error_control = P::kind;
 
-    Ref<Host> A = std::make_shared<Host>(MAC("AA:AA:AA:AA:AA:AA"), test_error_control);
-    Ref<Host> B = std::make_shared<Host>(MAC("BB:BB:BB:BB:BB:BB"), test_error_control);
-    Ref<Host> C = std::make_shared<Host>(MAC("CC:CC:CC:CC:CC:CC"), test_error_control);
+    Ref<Host> A = std::make_shared<Host>(MAC("02:AA:AA:AA:AA:AA"), test_error_control);
+    Ref<Host> B = std::make_shared<Host>(MAC("02:BB:BB:BB:BB:BB"), test_error_control);
+    Ref<Host> C = std::make_shared<Host>(MAC("02:CC:CC:CC:CC:CC"), test_error_control);
 
     C->setPromiscuousMode(true);
 
@@ -51,39 +117,50 @@ void A_B_ttl_andPromC()
     EthernetPeer::connect(B, S2, 0, 1);
     EthernetPeer::connect(C, S2, 0, 2);
 
-    L("\n[MAIN] A sends 'Hello' to B"_fmag);
-    std::this_thread::sleep_for(std::chrono::seconds(5));
-    {
-        Ether2Frame frame(B->m_MAC, A->m_MAC, "Hello", 6, test_error_control);
-        A->sendFrame(0, frame);
-    }
+    //The hosts talk through their applications; the table ages with the simulated time they sleep
+    sim::spawn(A_B_ttl_appA(A, B->m_MAC));
+    sim::spawn(A_B_ttl_appB(B, A->m_MAC));
+    sim::spawn(sniffer(C, "C"));
+    sim::run();
+}
 
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    L("\n[MAIN] B sends 'Oh, Hello!' to A"_fmag);
-    std::this_thread::sleep_for(std::chrono::seconds(5));
+//Aplicação de B: cumprimenta C e, depois da resposta de C, pergunta se está tudo bem
+static sim::Task B_C_self_appB(Ref<Host> B, MAC C)
+{
+    using P = error_control::Crc;
+    L("\n[MAIN] B sends 'Hello' to C"_fmag);
+    co_await sim::sleep(5 * sim::SECOND);
     {
-        Ether2Frame frame(A->m_MAC, B->m_MAC, "Oh, Hello!", 11, test_error_control);
-        B->sendFrame(0, frame);
+        Ether2Frame frame(C, B->m_MAC, "Hello", 6, P{});
+        B->sendFrameT<P>(0, frame);
     }
 
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    L("\n[MAIN] A sends 'BRB' to B"_fmag);
-    std::this_thread::sleep_for(std::chrono::seconds(5));
+    co_await sim::sleep(7 * sim::SECOND);
+    L("\n[MAIN] B sends 'Everything ok?' to C"_fmag);
+    co_await sim::sleep(4 * sim::SECOND);
+
+    Ether2Frame frame(C, B->m_MAC, "Everything ok?", 15, P{});
+    B->sendFrameT<P>(0, frame);
+}
+
+//Aplicação de C: responde a B e, depois da segunda mensagem, responde por engano para si mesmo
+static sim::Task B_C_self_appC(Ref<Host> C, MAC B)
+{
+    using P = error_control::Crc;
+    co_await sim::sleep(6 * sim::SECOND);
+    L("\n[MAIN] C sends 'Oh, Hello!' to B"_fmag);
+    co_await sim::sleep(5 * sim::SECOND);
     {
-        Ether2Frame frame(B->m_MAC, A->m_MAC, "BRB", 4, test_error_control);
-        A->sendFrame(0, frame);
+        Ether2Frame frame(B, C->m_MAC, "Oh, Hello!", 11, P{});
+        C->sendFrameT<P>(0, frame);
     }
 
-    //Wait 20s
-    L("\n[MAIN] After a long time (TTL has expired)"_fmag);
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    L("\n[MAIN] A sends 'I'm Back' to B"_fmag);
-    std::this_thread::sleep_for(std::chrono::seconds(16));
+    co_await sim::sleep(6 * sim::SECOND);
+    L("\n[MAIN] C sends 'Yeah, pretty much' to itself by mistake"_fmag);
+    co_await sim::sleep(5 * sim::SECOND);
 
-    //Create a frame from A to B with the message "Hello World"
-    Ether2Frame frame(B->m_MAC, A->m_MAC, "I'm back!", 10, test_error_control);
-    //Send the frame
-    A->sendFrame(0, frame);
+    Ether2Frame frame(C->m_MAC, C->m_MAC, "Yeah, pretty much", 18, P{});
+    C->sendFrameT<P>(0, frame);
 }
 
 /**
@@ -93,11 +170,12 @@ void A_B_ttl_andPromC()
  */
 void B_C_self_andPromA()
 {
-    ERROR_CONTROL test_error_control = ERROR_CONTROL::CRC;
+    using P = error_control::Crc;
+    ERROR_CONTROL test_error_control = P::kind;
 
-    Ref<Host> A = std::make_shared<Host>(MAC("AA:AA:AA:AA:AA:AA"), test_error_control);
-    Ref<Host> B = std::make_shared<Host>(MAC("BB:BB:BB:BB:BB:BB"), test_error_control);
-    Ref<Host> C = std::make_shared<Host>(MAC("CC:CC:CC:CC:CC:CC"), test_error_control);
+    Ref<Host> A = std::make_shared<Host>(MAC("02:AA:AA:AA:AA:AA"), test_error_control);
+    Ref<Host> B = std::make_shared<Host>(MAC("02:BB:BB:BB:BB:BB"), test_error_control);
+    Ref<Host> C = std::make_shared<Host>(MAC("02:CC:CC:CC:CC:CC"), test_error_control);
 
     A->setPromiscuousMode(true);
 
@@ -110,35 +188,21 @@ void B_C_self_andPromA()
     EthernetPeer::connect(B, S2, 0, 1);
     EthernetPeer::connect(C, S2, 0, 2);
 
-    L("\n[MAIN] B sends 'Hello' to C"_fmag);
-    std::this_thread::sleep_for(std::chrono::seconds(5));
-    {
-        Ether2Frame frame(C->m_MAC, B->m_MAC, "Hello", 6, test_error_control);
-        B->sendFrame(0, frame);
-    }
-
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    L("\n[MAIN] C sends 'Oh, Hello!' to B"_fmag);
-    std::this_thread::sleep_for(std::chrono::seconds(5));
-    {
-        Ether2Frame frame(B->m_MAC, C->m_MAC, "Oh, Hello!", 11, test_error_control);
-        C->sendFrame(0, frame);
-    }
+    sim::spawn(B_C_self_appB(B, C->m_MAC));
+    sim::spawn(B_C_self_appC(C, B->m_MAC));
+    sim::spawn(sniffer(A, "A"));
+    sim::run();
+}
 
-    L("\n[MAIN] B sends 'Everything ok?' to C"_fmag);
-    std::this_thread::sleep_for(std::chrono::seconds(5));
-    {
-        Ether2Frame frame(C->m_MAC, B->m_MAC, "Everything ok?", 15, test_error_control);
-        B->sendFrame(0, frame);
-    }
+//Aplicação de B: envia um frame a C (o enlace corrompe alguns bits)
+template <error_control::Policy P>
+static sim::Task B_C_error_appB(Ref<Host> B, MAC C)
+{
+    L("\n[MAIN] B sends 'Hello' to C"_fmag);
+    co_await sim::sleep(5 * sim::SECOND);
 
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    L("\n[MAIN] C sends 'Yeah, pretty much' to itself by mistake"_fmag);
-    std::this_thread::sleep_for(std::chrono::seconds(5));
-    {
-        Ether2Frame frame(C->m_MAC, C->m_MAC, "Yeah, pretty much", 18, test_error_control);
-        C->sendFrame(0, frame);
-    }
+    Ether2Frame frame(C, B->m_MAC, "Hello", 6, P{});
+    B->sendFrameT<P>(0, frame);
 }
 
 /**
@@ -146,13 +210,16 @@ void B_C_self_andPromA()
  * 
  * Topologia mais simples que as funções anteriores: B se comunica com C por meio de um switch
  * 
- * O foco dessa simulação é demonstrar a checagem de erro por meio do método CRC.
+ * O foco dessa simulação é demonstrar a checagem de erro por meio do método da política P.
  */
-void B_C_error(ERROR_CONTROL test_error_control)
+template <error_control::Policy P>
+void B_C_error()
 {
-    // Ref<Host> A = std::make_shared<Host>(MAC("AA:AA:AA:AA:AA:AA"), test_error_control);
-    Ref<Host> B = std::make_shared<Host>(MAC("BB:BB:BB:BB:BB:BB"), test_error_control);
-    Ref<Host> C = std::make_shared<Host>(MAC("CC:CC:CC:CC:CC:CC"), test_error_control);
+    ERROR_CONTROL test_error_control = P::kind;
+
+    // Ref<Host> A = std::make_shared<Host>(MAC("02:AA:AA:AA:AA:AA"), test_error_control);
+    Ref<Host> B = std::make_shared<Host>(MAC("02:BB:BB:BB:BB:BB"), test_error_control);
+    Ref<Host> C = std::make_shared<Host>(MAC("02:CC:CC:CC:CC:CC"), test_error_control);
 
     // A->setPromiscuousMode(true);
 
@@ -165,10 +232,195 @@ void B_C_error(ERROR_CONTROL test_error_control)
     EthernetPeer::connect(B, S2, 0, 1);
     EthernetPeer::connect(C, S2, 0, 2);
 
-    L("\n[MAIN] B sends 'Hello' to C"_fmag);
-    std::this_thread::sleep_for(std::chrono::seconds(5));
+    sim::spawn(B_C_error_appB<P>(B, C->m_MAC));
+    sim::run();
+}
+
+#define INSTANTIATE_STORY(P) template void B_C_error<error_control::P>();
+ERROR_CONTROL_POLICIES(INSTANTIATE_STORY)
+
+void B_C_error(ERROR_CONTROL test_error_control)
+{
+    error_control::dispatch(test_error_control, []<class P>(P) { B_C_error<P>(); });
+}
+
+//Aplicação de um host atrás do roteador: mostra cada pacote IPv4 que chega a ele (nunca termina; sim::reset a destrói)
+static sim::Task router_inbox(Ref<Host> host, std::string name)
+{
+    while (true)
+    {
+        Ether2Frame frame = co_await host->receive();
+        const uint8_t *header = frame.data;
+        L(tui::text::Text("\n[" + name + "] Received '" + std::string((const char *)header + ipv4::HEADER_SIZE) + "' from " +
+                          ipv4::toString(ipv4::load32(header + ipv4::SOURCE)) + " (TTL " + std::to_string(header[ipv4::TTL]) + ")")
+              .FCyan());
+    }
+}
+
+//Aplicação de A: fala com C pelo roteador e depois manda os pacotes que o roteador descarta
+static sim::Task A_C_router_appA(Ref<Host> A, MAC router, MAC C)
+{
+    using P = error_control::Crc;
+    const uint32_t IP_A = ipv4::parse("10.0.0.2"), IP_C = ipv4::parse("10.0.1.2");
+
+    L("\n[MAIN] A sends 'Hello' to C (10.0.1.2), but the router has not heard from C yet"_fmag);
+    co_await sim::sleep(1 * sim::SECOND);
+    {
+        Ether2Frame frame = ipv4::packet<P>(router, A->m_MAC, IP_A, IP_C, "Hello", 6);
+        A->sendFrameT<P>(0, frame);
+    }
+
+    //C answers in between (see A_C_router_appC), so the router has learned its MAC
+    co_await sim::sleep(2 * sim::SECOND);
+    L("\n[MAIN] A sends 'Hello' to C again"_fmag);
+    {
+        Ether2Frame frame = ipv4::packet<P>(router, A->m_MAC, IP_A, IP_C, "Hello", 6);
+        A->sendFrameT<P>(0, frame);
+    }
+
+    co_await sim::sleep(1 * sim::SECOND);
+    L("\n[MAIN] A sends 'Anyone?' to 192.168.0.1, outside every route"_fmag);
+    {
+        Ether2Frame frame = ipv4::packet<P>(router, A->m_MAC, IP_A, ipv4::parse("192.168.0.1"), "Anyone?", 8);
+        A->sendFrameT<P>(0, frame);
+    }
+
+    co_await sim::sleep(1 * sim::SECOND);
+    L("\n[MAIN] A sends 'Last hop' to C with TTL 1"_fmag);
+    {
+        Ether2Frame frame = ipv4::packet<P>(router, A->m_MAC, IP_A, IP_C, "Last hop", 9, 1);
+        A->sendFrameT<P>(0, frame);
+    }
+
+    co_await sim::sleep(1 * sim::SECOND);
+    L("\n[MAIN] A sends 'Psst' straight to C's MAC, which is not on A's link"_fmag);
+    {
+        Ether2Frame frame = ipv4::packet<P>(C, A->m_MAC, IP_A, IP_C, "Psst", 5);
+        A->sendFrameT<P>(0, frame);
+    }
+}
+
+//Aplicação de C: responde a A (o roteador aprende o MAC de C com este pacote)
+static sim::Task A_C_router_appC(Ref<Host> C, MAC router)
+{
+    using P = error_control::Crc;
+    co_await sim::sleep(2 * sim::SECOND);
+    L("\n[MAIN] C sends 'Hi' to A (10.0.0.2)"_fmag);
+
+    Ether2Frame frame = ipv4::packet<P>(router, C->m_MAC, ipv4::parse("10.0.1.2"), ipv4::parse("10.0.0.2"), "Hi", 3);
+    C->sendFrameT<P>(0, frame);
+}
+
+/**
+ * Método que simula dois hosts em sub-redes diferentes ligados por um roteador: A (10.0.0.2) na porta 0 e C (10.0.1.2) na porta 1
+ *
+ * O roteador não tem entradas ARP estáticas: o primeiro pacote de A para C é descartado (sem ARP para C), mas ensina
+ * ao roteador o MAC de A. Quando C responde, o roteador aprende o MAC de C e entrega o pacote a A; a partir daí,
+ * A alcança C. Em seguida, A manda um pacote sem rota, um com TTL 1 e um endereçado a um MAC que não é o do roteador,
+ * todos descartados. No fim, os contadores do roteador são mostrados.
+ */
+void A_C_router()
+{
+    using P = error_control::Crc;
+    ERROR_CONTROL test_error_control = P::kind;
+
+    Ref<Host> A = std::make_shared<Host>(MAC("02:AA:AA:AA:AA:AA"), test_error_control);
+    Ref<Host> C = std::make_shared<Host>(MAC("02:CC:CC:CC:CC:CC"), test_error_control);
+
+    Ref<Router> R = std::make_shared<Router>(test_error_control, 2);
+    R->setInterface(0, MAC("02:00:00:00:01:00"), ipv4::parse("10.0.0.1"), 24);
+    R->setInterface(1, MAC("02:00:00:00:01:01"), ipv4::parse("10.0.1.1"), 24);
+
+    EthernetPeer::connect(A, R, 0, 0);
+    EthernetPeer::connect(C, R, 0, 1);
+
+    sim::spawn(A_C_router_appA(A, R->interface(0).mac, C->m_MAC));
+    sim::spawn(A_C_router_appC(C, R->interface(1).mac));
+    sim::spawn(router_inbox(A, "A"));
+    sim::spawn(router_inbox(C, "C"));
+    sim::run();
+
+    metrics::PeerSnapshot s = R->metrics().snapshot();
+    L("\n[MAIN] Router: "_fmag << R->forwarded() << " packet(s) forwarded");
+    for (metrics::DropReason reason : {metrics::DropReason::NotForUs, metrics::DropReason::TtlExpired, metrics::DropReason::NoRoute, metrics::DropReason::NoArp})
+        L("  dropped ("_fmag << metrics::dropReasonName(reason) << "): " << s.drops[(size_t)reason]);
+}
+
+//Aplicação de carga do painel: manda frames a hosts das outras folhas, em rodízio, até 'stop'
+static sim::Task dashboard_appLoad(Ref<Host> host, std::vector<MAC> others, const std::atomic<bool> *stop)
+{
+    using P = error_control::Crc;
+    sim::Time interval = 2 * sim::LinkTiming{}.serialization(Ether2Frame::WIRE_SIZE);
+    for (size_t n = 0; !stop->load(std::memory_order_relaxed); n++)
+    {
+        Ether2Frame frame(others[n % others.size()], host->m_MAC, "load", 5, P{});
+        host->sendFrameT<P>(0, frame);
+        co_await sim::sleep(interval);
+    }
+}
+
+/**
+ * Método que mostra o painel ao vivo de uma rede folha-espinha carregada (spine com LEAVES folhas, HOSTS hosts em cada)
+ *
+ * Os hosts mandam a metade da banda do enlace para as outras folhas, então os uplinks ficam sobrecarregados
+ * (filas cheias e descartes) e as tabelas pequenas das folhas vivem cheias. A simulação roda em uma thread própria,
+ * na velocidade máxima, e o painel lê os contadores em outra, até o usuário apertar enter.
+ */
+void dashboardStory()
+{
+    using P = error_control::Crc;
+    const unsigned LEAVES = 4, HOSTS = 6;
+
+    queueing::QueueConfig config;
+    config.capacity = 32;
+
+    Ref<Switch> spine = std::make_shared<Switch>(P::kind, LEAVES, 64);
+    spine->setEgressQueues(config);
+    std::vector<Ref<Switch>> leaves;
+    std::vector<Ref<Host>> hosts;
+    for (unsigned l = 0; l < LEAVES; l++)
     {
-        Ether2Frame frame(C->m_MAC, B->m_MAC, "Hello", 6, test_error_control);
-        B->sendFrame(0, frame);
+        leaves.push_back(std::make_shared<Switch>(P::kind, HOSTS + 1, 16));
+        leaves.back()->setEgressQueues(config);
+        EthernetPeer::connect(leaves.back(), spine, HOSTS, l, 0);
+        for (unsigned h = 0; h < HOSTS; h++)
+        {
+            hosts.push_back(std::make_shared<Host>(MAC(0x020000000000ull + (l << 8) + h), P::kind));
+            EthernetPeer::connect(hosts.back(), leaves.back(), 0, h, 0);
+        }
     }
+
+    std::atomic<bool> stop = false;
+    for (size_t i = 0; i < hosts.size(); i++)
+    {
+        std::vector<MAC> others;
+        for (size_t j = 0; j < hosts.size(); j++)
+            if (j / HOSTS != i / HOSTS)
+                others.push_back(hosts[j]->m_MAC);
+        sim::spawn(dashboard_appLoad(hosts[i], others, &stop), i * sim::MICROSECOND);
+    }
+
+    //The narrative log would scroll over the dashboard
+    bool log = __nezumi_log_on__;
+    __nezumi_log_on__ = false;
+
+    tui::Dashboard dashboard;
+    dashboard.start();
+    std::thread simulation([&]() {
+        while (!stop.load(std::memory_order_relaxed))
+            sim::run(sim::now() + sim::MILLISECOND);
+    });
+
+    tui::readline();
+    stop = true;
+    simulation.join();
+    dashboard.stop();
+
+    __nezumi_log_on__ = log;
+    L("Dashboard: " << dashboard.frames() << " frames drawn, " << dashboard.bytesWritten() << " bytes written to the terminal, "
+                    << (double)sim::now() / sim::MILLISECOND << " ms simulated");
+
+    //Applications and flows of the load are not part of the story report
+    sim::reset();
+    latency::flows().reset();
 }
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "types.hpp"
+#include "error_control.hpp"
 
 /**
  * Método que simula conexão de computadores A, B e C, com A no Switch S1, B e C no switch S2 e ambos switches conectados
@@ -46,4 +47,23 @@ void B_C_self_andPromA();
  * 
  * O foco dessa simulação é demonstrar a checagem de erro por meio do método especificado.
  */
+template <error_control::Policy P>
+void B_C_error();
+
+//Entrada em tempo de execução: escolhe a política uma vez e roda a história especializada
 void B_C_error(ERROR_CONTROL test_error_control);
+
+/**
+ * Método que simula os hosts A e C em sub-redes diferentes, ligados por um roteador (sem switches)
+ *
+ * O roteador aprende os MACs dos vizinhos pelos pacotes que recebe deles (sem ARP estático): o primeiro pacote
+ * de A para C é descartado e só passa depois que C fala com A. A história também mostra os descartes por TTL
+ * expirado, por falta de rota e de frames endereçados a outro MAC.
+ */
+void A_C_router();
+
+/**
+ * Método que mostra o painel ao vivo (tui::Dashboard) de uma rede folha-espinha sob carga: a simulação roda
+ * em uma thread própria, sem esperar pelo painel, até o usuário apertar enter
+ */
+void dashboardStory();
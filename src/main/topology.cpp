@@ -0,0 +1,75 @@
+#include "topology.hpp"
+
+#include <stdexcept>
+
+#include "sim.hpp"
+
+Topology &Topology::global()
+{
+    static Topology topology;
+    return topology;
+}
+
+PeerId Topology::add(EthernetPeer *peer, unsigned port_count, PeerKind kind)
+{
+    if (m_Peers.size() >= NO_PEER || port_count > UINT16_MAX)
+        throw std::runtime_error("Topology is full");
+
+    //An arena kept alive by events of removed peers is released once those events are gone (e.g. after sim::reset)
+    if (m_Live == 0 && !m_Peers.empty() && sim::pendingEvents() == 0)
+        *this = Topology();
+
+    PeerId id = (PeerId)m_Peers.size();
+    m_Peers.push_back(peer);
+    m_Kinds.push_back(kind);
+    m_PortBase.push_back((uint32_t)m_Ports.size());
+    m_PortCount.push_back((uint16_t)port_count);
+    m_Ports.resize(m_Ports.size() + port_count);
+    m_Active.emplace_back(port_count);
+    m_Live++;
+    return id;
+}
+
+void Topology::remove(PeerId id)
+{
+    //Disconnect the other side of every link of this peer
+    m_Active[id].forEach([&](size_t port) { disconnect(id, (uint16_t)port); });
+
+    m_Peers[id] = nullptr;
+    m_Live--;
+
+    //Ids and port ranges are never reused while a simulation is alive. Once every peer is gone the arena is released,
+    //but only if no scheduled event still holds an id (a reused id would hand the event a different peer)
+    if (m_Live == 0 && sim::pendingEvents() == 0)
+        *this = Topology();
+}
+
+void Topology::connect(PeerId a, uint16_t pa, PeerId b, uint16_t pb)
+{
+    m_Ports[m_PortBase[a] + pa] = {b, pb};
+    m_Ports[m_PortBase[b] + pb] = {a, pa};
+    m_Active[a].set(pa);
+    m_Active[b].set(pb);
+}
+
+void Topology::disconnect(PeerId id, uint16_t port)
+{
+    PortLink &l = m_Ports[m_PortBase[id] + port];
+    if (l.connected())
+    {
+        m_Ports[m_PortBase[l.peer] + l.port] = PortLink();
+        m_Active[l.peer].reset(l.port);
+    }
+    l = PortLink();
+    m_Active[id].reset(port);
+}
+
+size_t Topology::bytes() const
+{
+    size_t masks = m_Active.capacity() * sizeof(PortMask);
+    for (const PortMask &m : m_Active)
+        masks += m.words().capacity() * sizeof(uint64_t);
+
+    return m_Peers.capacity() * sizeof(EthernetPeer *) + m_Kinds.capacity() * sizeof(PeerKind) + m_PortBase.capacity() * sizeof(uint32_t) +
+           m_PortCount.capacity() * sizeof(uint16_t) + m_Ports.capacity() * sizeof(PortLink) + masks;
+}
@@ -0,0 +1,93 @@
+/**
+ * Header criado para guardar as conexões entre os peers de forma compacta
+ *
+ * Cada peer recebe um identificador de 32 bits e um intervalo contíguo de portas em uma única arena
+ * (formato CSR: deslocamento do primeiro enlace de cada peer + vetor plano de enlaces).
+ * Um enlace é só (peer remoto, porta remota): 8 bytes por porta, sem shared_ptr, sem contagem
+ * de referências a cada entrega e sem ciclos — quando um peer é destruído, suas portas são desconectadas.
+ */
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "port_mask.hpp"
+
+class EthernetPeer;
+
+using PeerId = uint32_t;
+constexpr PeerId NO_PEER = UINT32_MAX;
+
+//Etiqueta do tipo concreto de um peer (permite despachar a entrega sem chamada virtual)
+enum class PeerKind : uint8_t
+{
+    Other, //Tipos definidos fora do conjunto embutido: sempre despachados pela chamada virtual
+    Host,
+    Switch,
+    Remote //Ponta de um enlace com outro processo: recebe o frame já no envio (ver shm_link.hpp)
+};
+
+//Extremidade remota de uma porta
+struct PortLink
+{
+    PeerId peer = NO_PEER;
+    uint16_t port = 0;
+
+    bool connected() const { return peer != NO_PEER; }
+};
+
+class Topology
+{
+public:
+    //Topologia única da simulação
+    static Topology &global();
+
+    /**
+     * Registra um peer, reservando suas portas na arena
+     *
+     * Parâmetros:	EthernetPeer *peer		=>	Peer a registrar
+     * 				unsigned port_count		=>	Quantidade de portas
+     * 				PeerKind kind			=>	Tipo concreto do peer
+     *
+     * Retorno: PeerId	=>	Identificador do peer
+     */
+    PeerId add(EthernetPeer *peer, unsigned port_count, PeerKind kind);
+
+    //Desconecta todas as portas do peer e o remove (chamado pelo destrutor do peer)
+    void remove(PeerId id);
+
+    //Liga a porta pa do peer a à porta pb do peer b (nos dois sentidos)
+    void connect(PeerId a, uint16_t pa, PeerId b, uint16_t pb);
+
+    //Desliga a porta do peer e a extremidade remota do enlace
+    void disconnect(PeerId id, uint16_t port);
+
+    //Peer do identificador (nullptr se removido ou nunca atribuído: eventos agendados podem sobreviver ao peer)
+    inline EthernetPeer *peer(PeerId id) const { return id < m_Peers.size() ? m_Peers[id] : nullptr; }
+    inline PeerKind kind(PeerId id) const { return m_Kinds[id]; }
+
+    inline std::span<PortLink> ports(PeerId id) { return {m_Ports.data() + m_PortBase[id], m_PortCount[id]}; }
+    inline const PortLink &link(PeerId id, uint16_t port) const { return m_Ports[m_PortBase[id] + port]; }
+
+    //Portas conectadas do peer (mantido por connect/disconnect; percorrer custa uma iteração por bit ligado)
+    inline const PortMask &active(PeerId id) const { return m_Active[id]; }
+
+    //Quantidade de peers registrados (vivos)
+    size_t size() const { return m_Live; }
+
+    //Quantidade de identificadores já atribuídos (inclui os dos peers removidos, cujo peer é nullptr)
+    PeerId idCount() const { return (PeerId)m_Peers.size(); }
+
+    //Bytes usados pela topologia (vetores de peers, deslocamentos, arena de portas e máscaras de portas ativas)
+    size_t bytes() const;
+
+private:
+    std::vector<EthernetPeer *> m_Peers;
+    std::vector<PeerKind> m_Kinds;
+    std::vector<uint32_t> m_PortBase;
+    std::vector<uint16_t> m_PortCount;
+    std::vector<PortLink> m_Ports;
+    std::vector<PortMask> m_Active;
+    size_t m_Live = 0;
+};
@@ -0,0 +1,143 @@
+#include "trace.hpp"
+
+#ifdef NLS_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "sim.hpp"
+
+namespace trace
+{
+    struct Event
+    {
+        const char *name;
+        uint64_t start, duration, flow;
+        sim::Time simTime;
+        Phase phase;
+    };
+
+    //Events one thread keeps before dropping (about 48 MiB)
+    static constexpr size_t BUFFER_CAPACITY = 1 << 20;
+
+    struct Buffer
+    {
+        uint32_t tid;
+        std::vector<Event> events;
+        uint64_t dropped = 0;
+    };
+
+    //Buffers outlive their threads, so a trace still has the events of threads that already ended
+    static std::mutex __buffers_mutex;
+    static std::vector<std::unique_ptr<Buffer>> __buffers;
+    static std::atomic<bool> __recording = false;
+    static std::atomic<uint64_t> __next_flow = 1;
+    static std::chrono::steady_clock::time_point __origin = std::chrono::steady_clock::now();
+
+    static Buffer &threadBuffer()
+    {
+        thread_local Buffer *buffer = nullptr;
+        if (!buffer)
+        {
+            std::lock_guard<std::mutex> lock(__buffers_mutex);
+            __buffers.push_back(std::make_unique<Buffer>());
+            buffer = __buffers.back().get();
+            buffer->tid = (uint32_t)__buffers.size();
+            buffer->events.reserve(4096);
+        }
+        return *buffer;
+    }
+
+    void start() { __recording.store(true, std::memory_order_relaxed); }
+    void stop() { __recording.store(false, std::memory_order_relaxed); }
+    bool recording() { return __recording.load(std::memory_order_relaxed); }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(__buffers_mutex);
+        for (auto &buffer : __buffers)
+        {
+            buffer->events.clear();
+            buffer->dropped = 0;
+        }
+        __origin = std::chrono::steady_clock::now();
+    }
+
+    uint64_t clock() { return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - __origin).count(); }
+
+    void record(const char *name, Phase phase, uint64_t start, uint64_t duration, uint64_t flow)
+    {
+        Buffer &buffer = threadBuffer();
+        if (buffer.events.size() >= BUFFER_CAPACITY)
+        {
+            buffer.dropped++;
+            return;
+        }
+        buffer.events.push_back({name, start, duration, flow, sim::now(), phase});
+    }
+
+    uint64_t newFlow() { return __next_flow.fetch_add(1, std::memory_order_relaxed); }
+
+    size_t events()
+    {
+        std::lock_guard<std::mutex> lock(__buffers_mutex);
+        size_t count = 0;
+        for (auto &buffer : __buffers)
+            count += buffer->events.size();
+        return count;
+    }
+
+    uint64_t dropped()
+    {
+        std::lock_guard<std::mutex> lock(__buffers_mutex);
+        uint64_t count = 0;
+        for (auto &buffer : __buffers)
+            count += buffer->dropped;
+        return count;
+    }
+
+    size_t writeChrome(const std::string &path)
+    {
+        FILE *out = fopen(path.c_str(), "w");
+        if (!out)
+            throw std::runtime_error("Could not open the trace file " + path);
+
+        std::lock_guard<std::mutex> lock(__buffers_mutex);
+        size_t written = 0;
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", out);
+        for (auto &buffer : __buffers)
+        {
+            fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", written ? ",\n" : "",
+                    buffer->tid, buffer->tid);
+            written++;
+
+            //Chrome timestamps are microseconds; the fraction keeps the nanoseconds
+            for (const Event &e : buffer->events)
+            {
+                fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f", e.name, (char)e.phase, buffer->tid,
+                        (double)e.start / 1000);
+                if (e.phase == Phase::Complete)
+                    fprintf(out, ",\"dur\":%.3f", (double)e.duration / 1000);
+                else
+                {
+                    //Flow events bind to the enclosing slice (the hop that handled the frame)
+                    fprintf(out, ",\"cat\":\"frame\",\"id\":%llu", (unsigned long long)e.flow);
+                    if (e.phase != Phase::FlowStart)
+                        fputs(",\"bp\":\"e\"", out);
+                }
+                fprintf(out, ",\"args\":{\"sim_ns\":%llu}}", (unsigned long long)e.simTime);
+                written++;
+            }
+        }
+        fputs("\n]}\n", out);
+        fclose(out);
+        return written;
+    }
+}
+
+#endif
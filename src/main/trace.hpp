@@ -0,0 +1,118 @@
+/**
+ * Header criado para instrumentar o caminho dos frames (onde o tempo de parede é gasto)
+ *
+ * Só existe quando compilado com NLS_TRACE (make TRACE=1); sem ele, as macros não geram código e as funções
+ * de controle são vazias, então os chamadores não precisam de #ifdef.
+ *
+ *   TRACE_SCOPE("Switch::lookup");   //Fatia com o tempo de parede até o fim do escopo
+ *   TRACE_FLOW_BEGIN(frame);         //Novo fluxo: as setas seguem o frame de salto em salto
+ *   TRACE_FLOW_STEP(frame);          //O frame passou por aqui (dentro de um TRACE_SCOPE)
+ *   TRACE_FLOW_END(frame);           //O frame chegou ao destino
+ *
+ * Cada thread grava em um buffer próprio (sem trava no caminho quente); writeChrome junta os buffers em um
+ * arquivo JSON do Chrome trace (chrome://tracing, ui.perfetto.dev), com o tempo simulado em args.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace trace
+{
+#ifdef NLS_TRACE
+    constexpr bool COMPILED = true;
+
+    //Fases dos eventos do Chrome trace
+    enum class Phase : char
+    {
+        Complete = 'X',
+        FlowStart = 's',
+        FlowStep = 't',
+        FlowEnd = 'f'
+    };
+
+    //Começa/para de gravar (os eventos já gravados ficam até clear)
+    void start();
+    void stop();
+    void clear();
+
+    bool recording();
+
+    //Nanossegundos de parede desde o começo da gravação
+    uint64_t clock();
+
+    void record(const char *name, Phase phase, uint64_t start, uint64_t duration, uint64_t flow);
+
+    //Identificador de um novo fluxo (sempre diferente de 0)
+    uint64_t newFlow();
+
+    //Eventos gravados e descartados (buffer da thread cheio)
+    size_t events();
+    uint64_t dropped();
+
+    /**
+     * Função que escreve os eventos gravados no formato JSON do Chrome trace
+     *
+     * Deve ser chamada com a gravação parada e sem outras threads gravando.
+     *
+     * Parâmetros: const std::string &path	=>	Arquivo de saída
+     *
+     * Retorno: size_t	=>	Eventos escritos
+     */
+    size_t writeChrome(const std::string &path);
+
+    class Scope
+    {
+    private:
+        const char *m_Name;
+        uint64_t m_Start;
+        bool m_On;
+
+    public:
+        explicit Scope(const char *name) : m_Name(name), m_Start(0), m_On(recording())
+        {
+            if (m_On)
+                m_Start = clock();
+        }
+        ~Scope()
+        {
+            if (m_On)
+                record(m_Name, Phase::Complete, m_Start, clock() - m_Start, 0);
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+    inline void flow(Phase phase, uint64_t id)
+    {
+        if (id && recording())
+            record("frame", phase, clock(), 0, id);
+    }
+#else
+    constexpr bool COMPILED = false;
+
+    inline void start() {}
+    inline void stop() {}
+    inline void clear() {}
+    inline bool recording() { return false; }
+    inline size_t events() { return 0; }
+    inline uint64_t dropped() { return 0; }
+    inline size_t writeChrome(const std::string &) { return 0; }
+#endif
+}
+
+#ifdef NLS_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) ::trace::Scope TRACE_CONCAT(__trace_scope_, __LINE__)(name)
+#define TRACE_FLOW_BEGIN(frame) ((frame).traceFlow = ::trace::recording() ? ::trace::newFlow() : 0, ::trace::flow(::trace::Phase::FlowStart, (frame).traceFlow))
+#define TRACE_FLOW_STEP(frame) ::trace::flow(::trace::Phase::FlowStep, (frame).traceFlow)
+#define TRACE_FLOW_END(frame) ::trace::flow(::trace::Phase::FlowEnd, (frame).traceFlow)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_FLOW_BEGIN(frame) ((void)0)
+#define TRACE_FLOW_STEP(frame) ((void)0)
+#define TRACE_FLOW_END(frame) ((void)0)
+#endif
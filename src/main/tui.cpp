@@ -1,4 +1,5 @@
 #include "tui.hpp"
+#include "input.hpp"
 #if defined(WIN32) //Winows
 
 #error Windows is not Supported
@@ -10,6 +11,7 @@
 
 #endif
 
+#include <condition_variable>
 #include <regex>
 #include <sstream>
 #include <thread>
@@ -124,98 +126,72 @@ namespace tui
 
     std::pair<int, int> getSize()
     {
-        winsize size;
+        //Zero when stdout is not a terminal
+        winsize size = {};
         ioctl(1, TIOCGWINSZ, &size);
         return {size.ws_col, size.ws_row};
     }
 
+    static std::mutex ___reading_line_mutex;
+    static std::condition_variable ___reading_line_resumed;
     static bool ___reading_line = false;
     static bool ___reading_line_paused = false;
 
     std::string readline(int maxChars)
     {
-        static struct termios oldt, newt;
-        tcgetattr(STDIN_FILENO, &oldt);
-        newt = oldt;
+        //Keys come from the shared stdin reader, so keys typed ahead are kept for the next read
+        RawMode raw(STDIN_FILENO);
+        KeyReader &reader = KeyReader::standard();
+        LineEditor editor((size_t)std::max(0, maxChars));
+        fflush(stdout);
 
-        newt.c_lflag &= ~(ICANON);
-        newt.c_lflag &= ~ECHO;
-        tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-
-        std::stringstream ss;
-        ___reading_line = true;
-
-        std::vector<char> buf(maxChars, 0);
-        int pos = -1;
-        int greatestPos = 0;
+        {
+            std::lock_guard<std::mutex> lock(___reading_line_mutex);
+            ___reading_line = true;
+        }
 
-        char c;
-        while (pos < maxChars)
+        KeyEvent key;
+        std::string echo;
+        bool done = false;
+        while (!done)
         {
-            pos = std::max(0, pos);
-            if (!___reading_line_paused)
             {
-                c = getchar();
-                fflush(stdin);
-                
-                if (c == 127) {
-                    if (pos == 0) continue;
-                    ss.seekp(-1, std::ios_base::end);
-                    ss << "\0";
-                    ss.seekp(-1, std::ios_base::end);
-                    pos--;
-                    greatestPos--;
-                    left(1);
-                    print(" ");
-                    fflush(stdout);
-                    left(1);
-                    continue;
-                }
-
-                if (c == '\033') {
-                    if (getchar() != '[') continue;
-                    char dir = getchar();
-                    if (dir == 'D' && pos > 0 ) { pos--; left(); }
-                    if (dir == 'C' && pos < greatestPos ) { pos++; right(); }
-                    continue;
-                }
-
-                putchar(c);
-                fflush(stdout);
-                if (c == '\n')
-                {
-                    ___reading_line = false;
-                    ___reading_line_paused = false;
-                    break;
-                }
-                buf[pos] = c;
-                pos++;
-                greatestPos++;
+                std::unique_lock<std::mutex> lock(___reading_line_mutex);
+                ___reading_line_resumed.wait(lock, []() { return !___reading_line_paused; });
             }
-            else
-                std::this_thread::sleep_for(10ms);
-        }
-
-        buf[pos] = '\0';
-
-        /*restore the old settings*/
-        tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-
 
+            //Blocks in poll() until a key arrives; a short timeout lets a pause take effect while idle
+            if (!reader.next(key, 100))
+                continue;
+            echo.clear();
+            done = editor.feed(key, echo);
+            fwrite(echo.data(), 1, echo.size(), stdout);
+            fflush(stdout);
+        }
 
-        return std::string(buf.begin(), buf.begin()+greatestPos);
+        {
+            std::lock_guard<std::mutex> lock(___reading_line_mutex);
+            ___reading_line = false;
+            ___reading_line_paused = false;
+        }
+        return editor.take();
     }
 
     void pauseReadline()
     {
+        std::lock_guard<std::mutex> lock(___reading_line_mutex);
         if (___reading_line)
             ___reading_line_paused = true;
     }
 
     void unpauseReadline()
     {
-        if (___reading_line)
-            ___reading_line_paused = false;
+        {
+            std::lock_guard<std::mutex> lock(___reading_line_mutex);
+            if (___reading_line)
+                ___reading_line_paused = false;
+        }
+        ___reading_line_resumed.notify_all();
     }
     
     void cancelReadline()
@@ -225,19 +201,14 @@ namespace tui
 
     void paint(int xs, int ys, int xe, int ye, text::TextColorB bg)
     {
+        //The whole area is built first and written at once (one flush, not one per cell)
+        std::string out;
+        std::string row(std::max(0, xe - xs + 1), ' ');
         for (int y = ys; y <= ye; y++)
-        {
-            cursor(xs, y);
-            printf("\033[%sm", text::createColorString(bg).c_str());
+            out += "\033[" + std::to_string(y) + ";" + std::to_string(xs) + "f\033[" + text::createColorString(bg) + "m" + row + "\033[39;49m";
 
-            for (int i = 0; i <= xe - xs; i++)
-            {
-                printf(" ");
-                fflush(stdout);
-            }
-
-            printf("\033[39;49m");
-        }
+        fwrite(out.data(), 1, out.size(), stdout);
+        fflush(stdout);
     }
 }
 
@@ -9,8 +9,10 @@ template <typename T>
 using Ref = std::shared_ptr<T>;
 
 #define __nezumi_debugger_on__ 1
+//Log da simulação, que pode ser desligado em tempo de execução (ex.: nos benchmarks)
+inline bool __nezumi_log_on__ = true;
 #define D(x) { if (__nezumi_debugger_on__) { x } }
-#define L(x) { std::cout << x << std::endl; }
+#define L(x) { if (__nezumi_log_on__) { std::cout << x << std::endl; } }
 
 
 // Declarações (forward declarations), para evitar problemas com dependencias cíclicas
@@ -20,6 +22,7 @@ struct Data;
 
 class DataReceiver;
 class PC;
+class Host;
 class Switch;
 
 // Partes de um mac PART1 :: PART2 :: etc...
@@ -28,5 +31,9 @@ using MAC_PARTS = uint16_t[6];
 enum class ERROR_CONTROL {
     EVEN, 
     ODD,
-    CRC
+    CRC,
+    CRC32C,
+    FLETCHER32,
+    ADLER32,
+    INTERNET
 };
\ No newline at end of file
@@ -0,0 +1,275 @@
+/**
+ * Simulação de Monte Carlo da taxa de erros NÃO detectados por cada método de checagem (CRC-32, paridade par e ímpar)
+ *
+ * Cada tentativa injeta um padrão de erro (k bits aleatórios ou uma rajada) no payload de um frame e verifica
+ * se a checagem ainda aceita o frame. Como o CRC é linear, CRC(m ^ e) = CRC(m) ^ CRC(e) ^ CRC(0): o efeito de inverter
+ * o bit i é uma constante pré-computada (síndrome), e uma tentativa só precisa fazer o XOR das síndromes dos bits
+ * invertidos (zero = erro não detectado), em vez de recalcular o CRC dos 1500 bytes. A paridade (par ou ímpar)
+ * só deixa de detectar quando o número de bits invertidos é par.
+ *
+ * Periodicamente o resultado incremental é conferido contra Ether2Frame::checkCRC/checkEven/checkOdd em um frame real.
+ *
+ * Uso: ./bin/montecarlo [tentativas por cenário] [threads] [semente]
+ */
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame.hpp"
+#include "rng.hpp"
+
+static constexpr size_t PAYLOAD_BITS = sizeof(Ether2Frame::data) * 8;
+
+//A cada VERIFY_EVERY tentativas (por thread), o resultado incremental é conferido no frame real
+static constexpr uint64_t VERIFY_EVERY = 1 << 16;
+
+//Padrão de erro de um cenário
+struct Scenario
+{
+    enum Kind
+    {
+        RandomBits, //'size' bits distintos em posições uniformes
+        Burst       //rajada de 'size' bits: primeiro e último invertidos, internos com chance 1/2
+    } kind;
+    unsigned size;
+
+    std::string name() const { return (kind == RandomBits ? "k=" : "burst=") + std::to_string(size); }
+};
+
+//Contagem de erros não detectados de um cenário
+struct Tally
+{
+    uint64_t trials = 0;
+    uint64_t undetectedCRC = 0, undetectedEven = 0, undetectedOdd = 0;
+
+    void merge(const Tally &o)
+    {
+        trials += o.trials;
+        undetectedCRC += o.undetectedCRC;
+        undetectedEven += o.undetectedEven;
+        undetectedOdd += o.undetectedOdd;
+    }
+};
+
+/**
+ * Síndrome de cada bit do payload: a alteração que a inversão daquele bit causa no CRC
+ */
+static std::vector<uint32_t> buildSyndromes()
+{
+    std::vector<uint32_t> syndromes(PAYLOAD_BITS);
+    std::vector<uint8_t> buf(sizeof(Ether2Frame::data), 0);
+    uint32_t zero = CRC32(buf.data(), buf.size());
+
+    for (size_t bit = 0; bit < PAYLOAD_BITS; bit++)
+    {
+        buf[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+        syndromes[bit] = CRC32(buf.data(), buf.size()) ^ zero;
+        buf[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+    }
+    return syndromes;
+}
+
+/**
+ * Sorteia as posições dos bits invertidos de uma tentativa
+ *
+ * Retorno: size_t	=>	Quantidade de posições escritas em 'positions'
+ */
+static size_t drawErrors(const Scenario &scenario, rng::Xoshiro256 &gen, uint32_t *positions)
+{
+    if (scenario.kind == Scenario::RandomBits)
+    {
+        for (size_t i = 0; i < scenario.size; i++)
+        {
+            //Flipping the same bit twice would cancel it, so positions must be distinct
+            bool repeated;
+            do
+            {
+                positions[i] = (uint32_t)gen.nextBelow(PAYLOAD_BITS);
+                repeated = false;
+                for (size_t j = 0; j < i; j++)
+                    repeated |= positions[j] == positions[i];
+            } while (repeated);
+        }
+        return scenario.size;
+    }
+
+    uint32_t start = (uint32_t)gen.nextBelow(PAYLOAD_BITS - scenario.size + 1);
+    size_t count = 0;
+    positions[count++] = start;
+
+    uint64_t interior = 0;
+    for (unsigned i = 1; i + 1 < scenario.size; i++)
+    {
+        if ((i - 1) % 64 == 0)
+            interior = gen.next();
+        if (interior & 1)
+            positions[count++] = start + i;
+        interior >>= 1;
+    }
+
+    if (scenario.size > 1)
+        positions[count++] = start + scenario.size - 1;
+    return count;
+}
+
+/**
+ * Aplica o erro a um frame real e confere que as checagens do frame concordam com o resultado incremental
+ */
+static void verifyAgainstFrame(const Ether2Frame &crcFrame, const Ether2Frame &evenFrame, const Ether2Frame &oddFrame,
+                               const uint32_t *positions, size_t count, bool crcUndetected, bool parityUndetected)
+{
+    Ether2Frame c = crcFrame, e = evenFrame, o = oddFrame;
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t mask = (uint8_t)(1u << (positions[i] % 8));
+        c.data[positions[i] / 8] ^= mask;
+        e.data[positions[i] / 8] ^= mask;
+        o.data[positions[i] / 8] ^= mask;
+    }
+
+    if (c.checkCRC() != crcUndetected || e.checkEven() != parityUndetected || o.checkOdd() != parityUndetected)
+        throw std::runtime_error("Incremental check disagrees with the frame check");
+}
+
+static Tally runScenario(const Scenario &scenario, uint64_t trials, unsigned threads, uint64_t seed,
+                         const std::vector<uint32_t> &syndromes)
+{
+    const char payload[] = "Monte Carlo frame used to cross-check the incremental syndromes";
+    MAC dst("02:CC:CC:CC:CC:CC"), src("02:BB:BB:BB:BB:BB");
+    const Ether2Frame crcFrame(dst, src, payload, sizeof(payload), ERROR_CONTROL::CRC);
+    const Ether2Frame evenFrame(dst, src, payload, sizeof(payload), ERROR_CONTROL::EVEN);
+    const Ether2Frame oddFrame(dst, src, payload, sizeof(payload), ERROR_CONTROL::ODD);
+
+    std::vector<Tally> tallies(threads);
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+
+    for (unsigned t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            try
+            {
+                //Independent stream per (scenario, thread): results do not depend on scheduling
+                rng::Xoshiro256 gen(seed, ((uint64_t)scenario.kind << 48) ^ ((uint64_t)scenario.size << 32) ^ t);
+                uint64_t share = trials / threads + (t < trials % threads ? 1 : 0);
+                uint32_t positions[PAYLOAD_BITS];
+                Tally local;
+
+                for (uint64_t i = 0; i < share; i++)
+                {
+                    size_t count = drawErrors(scenario, gen, positions);
+
+                    uint32_t syndrome = 0;
+                    for (size_t p = 0; p < count; p++)
+                        syndrome ^= syndromes[positions[p]];
+
+                    bool crcUndetected = syndrome == 0;
+                    bool parityUndetected = count % 2 == 0;
+
+                    local.undetectedCRC += crcUndetected;
+                    local.undetectedEven += parityUndetected;
+                    local.undetectedOdd += parityUndetected;
+
+                    if (i % VERIFY_EVERY == 0)
+                        verifyAgainstFrame(crcFrame, evenFrame, oddFrame, positions, count, crcUndetected, parityUndetected);
+                }
+
+                local.trials = share;
+                tallies[t] = local;
+            }
+            catch (...)
+            {
+                //An exception escaping a thread would call std::terminate; it is rethrown after the join instead
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+
+    for (std::thread &w : workers)
+        w.join();
+    for (const std::exception_ptr &error : errors)
+        if (error)
+            std::rethrow_exception(error);
+
+    Tally total;
+    for (const Tally &t : tallies)
+        total.merge(t);
+    return total;
+}
+
+/**
+ * Intervalo de confiança de Wilson (95%) para uma proporção: continua informativo quando não há nenhum evento
+ */
+static std::pair<double, double> wilson(uint64_t events, uint64_t trials)
+{
+    const double z = 1.959963984540054;
+    double n = (double)trials, p = events / n;
+    double denom = 1 + z * z / n;
+    double center = (p + z * z / (2 * n)) / denom;
+    double half = z * std::sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / denom;
+    return {events == 0 ? 0.0 : std::max(0.0, center - half), events == trials ? 1.0 : std::min(1.0, center + half)};
+}
+
+static void printRate(const char *method, uint64_t events, uint64_t trials)
+{
+    auto [low, high] = wilson(events, trials);
+    std::cout << "    " << std::left << std::setw(6) << method << std::right
+              << std::setw(14) << events << " undetected"
+              << "  rate=" << std::scientific << std::setprecision(3) << (double)events / trials
+              << "  95% CI=[" << low << ", " << high << "]" << std::defaultfloat << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    uint64_t trials = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    unsigned threads = argc > 2 ? (unsigned)std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+    uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+    if (threads == 0)
+        threads = 1;
+    if (trials == 0)
+    {
+        std::cerr << "The number of trials per scenario must be a positive integer" << std::endl;
+        return 1;
+    }
+
+    const std::vector<Scenario> scenarios = {
+        {Scenario::RandomBits, 1}, {Scenario::RandomBits, 2}, {Scenario::RandomBits, 3}, {Scenario::RandomBits, 4},
+        {Scenario::RandomBits, 5}, {Scenario::RandomBits, 8}, {Scenario::RandomBits, 16},
+        {Scenario::Burst, 8}, {Scenario::Burst, 32}, {Scenario::Burst, 33}, {Scenario::Burst, 34}, {Scenario::Burst, 64}};
+
+    std::cout << "Precomputing CRC-32 syndromes for " << PAYLOAD_BITS << " payload bits..." << std::endl;
+    const std::vector<uint32_t> syndromes = buildSyndromes();
+
+    std::cout << trials << " trials per scenario, " << threads << " threads, seed " << seed << std::endl;
+    for (const Scenario &scenario : scenarios)
+    {
+        auto start = std::chrono::steady_clock::now();
+        Tally tally;
+        try
+        {
+            tally = runScenario(scenario, trials, threads, seed, syndromes);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << scenario.name() << ": " << e.what() << std::endl;
+            return 1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << scenario.name() << "  (" << std::fixed << std::setprecision(1) << tally.trials / seconds / 1e6
+                  << "M trials/s)" << std::defaultfloat << std::endl;
+        printRate("CRC", tally.undetectedCRC, tally.trials);
+        printRate("EVEN", tally.undetectedEven, tally.trials);
+        printRate("ODD", tally.undetectedOdd, tally.trials);
+    }
+
+    return 0;
+}